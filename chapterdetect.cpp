@@ -0,0 +1,233 @@
+#include "chapterdetect.hpp"
+
+#include <QRegularExpression>
+#include <algorithm>
+#include <array>
+#include <ciso646>
+#include <cmath>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64)  // SSE2 is part of x86-64
+#    include <emmintrin.h>
+#    define VIDEO_CONCATENATER_HAS_SSE2
+#endif
+
+namespace concat {
+namespace {
+constexpr int HISTOGRAM_BINS = 32;
+using Histogram = std::array<std::uint32_t, HISTOGRAM_BINS>;
+Histogram histogram_of(const std::uint8_t *frame) {
+    // four partial histograms keep increments of the same bin from depending on each other
+    std::array<Histogram, 4> partial{};
+    std::size_t i = 0;
+    for (; i + 4 <= DETECTION_FRAME_SIZE; i += 4) {
+        partial[0][frame[i] >> 3]++;
+        partial[1][frame[i + 1] >> 3]++;
+        partial[2][frame[i + 2] >> 3]++;
+        partial[3][frame[i + 3] >> 3]++;
+    }
+    for (; i < DETECTION_FRAME_SIZE; i++) {
+        partial[0][frame[i] >> 3]++;
+    }
+    Histogram result{};
+    for (auto bin = 0; bin < HISTOGRAM_BINS; bin++) {
+        result[bin] = partial[0][bin] + partial[1][bin] + partial[2][bin] + partial[3][bin];
+    }
+    return result;
+}
+double rms_level(std::uint64_t sum_of_squares, std::size_t size) {
+    auto mean_square = static_cast<double>(sum_of_squares) / size;
+    // -inf for digital silence is clamped so that levels stay comparable
+    return std::max(10 * std::log10(mean_square / (32768.0 * 32768.0)), -120.0);
+}
+struct Candidate {
+    double time;
+    double strength;
+};
+}  // namespace
+QStringList keyframe_arguments(const QString &path) {
+    QStringList result;
+    // clang-format off
+    result << "-hide_banner" << "-nostdin"
+           << "-skip_frame" << "nokey"
+           << "-i" << path
+           << "-map" << "0:v:0"
+           << "-fps_mode" << "passthrough"
+           << "-vf" << QStringLiteral("scale=%1:%2:flags=fast_bilinear,format=gray,showinfo")
+                           .arg(DETECTION_FRAME_WIDTH).arg(DETECTION_FRAME_HEIGHT)
+           << "-f" << "rawvideo"
+           << "-";
+    // clang-format on
+    return result;
+}
+QStringList envelope_arguments(const QString &path) {
+    QStringList result;
+    // clang-format off
+    result << "-hide_banner" << "-nostdin"
+           << "-i" << path
+           << "-map" << "0:a:0"
+           << "-ac" << "1"
+           << "-ar" << QString::number(DETECTION_SAMPLE_RATE)
+           << "-f" << "s16le"
+           << "-";
+    // clang-format on
+    return result;
+}
+std::vector<double> parse_frame_times(const QByteArray &log) {
+    static const QRegularExpression PTS_TIME(R"(\bpts_time:\s*(-?[0-9.]+))");
+    std::vector<double> result;
+    auto matches = PTS_TIME.globalMatch(QString::fromUtf8(log));
+    while (matches.hasNext()) {
+        result.push_back(matches.next().captured(1).toDouble());
+    }
+    return result;
+}
+std::uint64_t sum_of_absolute_differences(const std::uint8_t *a, const std::uint8_t *b, std::size_t size) {
+    std::uint64_t result = 0;
+    std::size_t i = 0;
+#ifdef VIDEO_CONCATENATER_HAS_SSE2
+    auto sums = _mm_setzero_si128();
+    for (; i + 16 <= size; i += 16) {
+        auto x = _mm_loadu_si128(reinterpret_cast<const __m128i *>(a + i));
+        auto y = _mm_loadu_si128(reinterpret_cast<const __m128i *>(b + i));
+        sums = _mm_add_epi64(sums, _mm_sad_epu8(x, y));  // two 64 bit lanes
+    }
+    result += static_cast<std::uint64_t>(_mm_cvtsi128_si64(sums)) +
+              static_cast<std::uint64_t>(_mm_cvtsi128_si64(_mm_unpackhi_epi64(sums, sums)));
+#endif
+    for (; i < size; i++) {
+        result += a[i] > b[i] ? a[i] - b[i] : b[i] - a[i];
+    }
+    return result;
+}
+std::uint64_t sum_of_squares(const std::int16_t *samples, std::size_t size) {
+    std::uint64_t result = 0;
+    std::size_t i = 0;
+#ifdef VIDEO_CONCATENATER_HAS_SSE2
+    auto sums = _mm_setzero_si128();
+    auto zero = _mm_setzero_si128();
+    for (; i + 8 <= size; i += 8) {
+        auto x = _mm_loadu_si128(reinterpret_cast<const __m128i *>(samples + i));
+        // each lane is at most 2 * 32768^2 = 2^31, which fits unsigned 32 bit. it is widened before accumulating
+        auto squares = _mm_madd_epi16(x, x);
+        sums = _mm_add_epi64(sums, _mm_unpacklo_epi32(squares, zero));
+        sums = _mm_add_epi64(sums, _mm_unpackhi_epi32(squares, zero));
+    }
+    result += static_cast<std::uint64_t>(_mm_cvtsi128_si64(sums)) +
+              static_cast<std::uint64_t>(_mm_cvtsi128_si64(_mm_unpackhi_epi64(sums, sums)));
+#endif
+    for (; i < size; i++) {
+        result += static_cast<std::uint64_t>(static_cast<std::int32_t>(samples[i]) * samples[i]);
+    }
+    return result;
+}
+std::vector<double> scene_scores(const std::uint8_t *frames, std::size_t frame_count) {
+    std::vector<double> result;
+    if (frame_count == 0) {
+        return result;
+    }
+    result.push_back(0);
+    auto previous = histogram_of(frames);
+    for (std::size_t i = 1; i < frame_count; i++) {
+        const auto *frame = frames + i * DETECTION_FRAME_SIZE;
+        auto histogram = histogram_of(frame);
+        std::uint64_t histogram_distance = 0;
+        for (auto bin = 0; bin < HISTOGRAM_BINS; bin++) {
+            histogram_distance += histogram[bin] > previous[bin] ? histogram[bin] - previous[bin]
+                                                                 : previous[bin] - histogram[bin];
+        }
+        auto pixel_difference = sum_of_absolute_differences(frame - DETECTION_FRAME_SIZE, frame, DETECTION_FRAME_SIZE);
+        // both terms are normalized to [0, 1]
+        result.push_back((static_cast<double>(pixel_difference) / (255.0 * DETECTION_FRAME_SIZE) +
+                          static_cast<double>(histogram_distance) / (2.0 * DETECTION_FRAME_SIZE)) /
+                         2);
+        previous = histogram;
+    }
+    return result;
+}
+std::vector<double> rms_envelope(const std::int16_t *samples, std::size_t size, std::size_t window_size) {
+    std::vector<double> result;
+    for (std::size_t start = 0; window_size > 0 && start < size; start += window_size) {
+        auto length = std::min(window_size, size - start);
+        result.push_back(rms_level(sum_of_squares(samples + start, length), length));
+    }
+    return result;
+}
+EnvelopeAccumulator::EnvelopeAccumulator(std::size_t window_size)
+    : window_size_(std::max<std::size_t>(window_size, 1)) {}
+void EnvelopeAccumulator::add(const char *data, std::size_t size) {
+    std::vector<char> bytes(partial_sample_);
+    bytes.insert(bytes.end(), data, data + size);
+    auto sample_count = bytes.size() / sizeof(std::int16_t);
+    partial_sample_.assign(bytes.begin() + sample_count * sizeof(std::int16_t), bytes.end());
+    // copied, since pieces of a pipe are not aligned for int16_t
+    std::vector<std::int16_t> samples(sample_count);
+    std::memcpy(samples.data(), bytes.data(), sample_count * sizeof(std::int16_t));
+    for (std::size_t start = 0; start < sample_count;) {
+        auto length = std::min(window_size_ - sample_count_, sample_count - start);
+        sum_of_squares_ += sum_of_squares(samples.data() + start, length);
+        sample_count_ += length;
+        start += length;
+        if (sample_count_ == window_size_) {
+            envelope_.push_back(rms_level(sum_of_squares_, sample_count_));
+            sum_of_squares_ = 0;
+            sample_count_ = 0;
+        }
+    }
+}
+std::vector<double> EnvelopeAccumulator::envelope() const {
+    auto result = envelope_;
+    if (sample_count_ > 0) {
+        result.push_back(rms_level(sum_of_squares_, sample_count_));
+    }
+    return result;
+}
+std::vector<double> propose_boundaries(const std::vector<double> &keyframe_times, const std::vector<double> &scores,
+                                       const std::vector<double> &envelope, double duration,
+                                       const DetectionParams &params) {
+    std::vector<std::pair<double, double>> silences;  // [start, end)
+    for (std::size_t i = 0; i < envelope.size();) {
+        if (envelope[i] >= params.silence_level) {
+            i++;
+            continue;
+        }
+        auto start = i;
+        while (i < envelope.size() && envelope[i] < params.silence_level) {
+            i++;
+        }
+        silences.emplace_back(start * params.envelope_window, i * params.envelope_window);
+    }
+    std::vector<Candidate> candidates;
+    for (const auto &[start, end] : silences) {
+        if (end - start >= params.min_silence) {
+            // the chapter starts where the sound comes back. longer breaks rank higher
+            candidates.push_back({end, 1 + std::min((end - start) / 10, 1.0)});
+        }
+    }
+    auto count = std::min(keyframe_times.size(), scores.size());
+    for (std::size_t i = 0; i < count; i++) {
+        if (scores[i] < params.scene_threshold) {
+            continue;
+        }
+        auto time = keyframe_times[i];
+        auto window = params.coincidence_window;
+        bool is_near_silence = std::any_of(silences.begin(), silences.end(), [&](const auto &silence) {
+            return time > silence.first - window && time < silence.second + window;
+        });
+        // a cut inside a break is where the next part begins, so it takes the place of the silence
+        candidates.push_back({time, scores[i] + (is_near_silence ? 2 : 0)});
+    }
+    std::stable_sort(candidates.begin(), candidates.end(),
+                     [](const auto &a, const auto &b) { return a.strength > b.strength; });
+    std::vector<double> result;
+    for (const auto &candidate : candidates) {
+        auto is_apart = [&](double time) { return std::abs(time - candidate.time) >= params.min_chapter_length; };
+        if (is_apart(0) && is_apart(duration) && candidate.time < duration &&
+            std::all_of(result.begin(), result.end(), is_apart)) {
+            result.push_back(candidate.time);
+        }
+    }
+    std::sort(result.begin(), result.end());
+    return result;
+}
+}  // namespace concat
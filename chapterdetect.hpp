@@ -0,0 +1,96 @@
+#ifndef VIDEO_CONCATENATER_CHAPTERDETECT
+#define VIDEO_CONCATENATER_CHAPTERDETECT
+
+#include <QByteArray>
+#include <QString>
+#include <QStringList>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace concat {
+// keyframes are decoded downscaled to gray frames of this size
+constexpr int DETECTION_FRAME_WIDTH = 64;
+constexpr int DETECTION_FRAME_HEIGHT = 36;
+constexpr std::size_t DETECTION_FRAME_SIZE = DETECTION_FRAME_WIDTH * DETECTION_FRAME_HEIGHT;
+// audio is decoded to mono 16 bit samples of this rate. enough for the loudness envelope of speech and music
+constexpr int DETECTION_SAMPLE_RATE = 4000;
+/**
+ * @brief arguments of ffmpeg which write keyframes only as raw gray frames to stdout
+ * @details Non-key frames are skipped by the decoder, so this runs at many times real time. showinfo writes the
+ * timestamp of each frame to stderr, which parse_frame_times() reads.
+ */
+QStringList keyframe_arguments(const QString &path);
+/**
+ * @brief arguments of ffmpeg which write the first audio stream as mono s16le of DETECTION_SAMPLE_RATE to stdout
+ */
+QStringList envelope_arguments(const QString &path);
+/**
+ * @brief timestamps in seconds of frames printed by showinfo
+ */
+std::vector<double> parse_frame_times(const QByteArray &log);
+/**
+ * @brief sum of |a[i] - b[i]|
+ * @details SSE2 is used where available.
+ */
+std::uint64_t sum_of_absolute_differences(const std::uint8_t *a, const std::uint8_t *b, std::size_t size);
+/**
+ * @brief sum of samples[i]^2
+ * @details SSE2 is used where available.
+ */
+std::uint64_t sum_of_squares(const std::int16_t *samples, std::size_t size);
+/**
+ * @brief difference of each frame from the previous one in [0, 1]. the first frame has 0
+ * @details Mean absolute pixel difference and distance of luma histograms are averaged. The histogram keeps camera
+ * motion from being taken as a scene change, and the pixel difference catches cuts between scenes of similar tones.
+ * @param frames frames of DETECTION_FRAME_SIZE bytes, back to back
+ */
+std::vector<double> scene_scores(const std::uint8_t *frames, std::size_t frame_count);
+/**
+ * @brief RMS level of each window in dBFS
+ */
+std::vector<double> rms_envelope(const std::int16_t *samples, std::size_t size, std::size_t window_size);
+/**
+ * @brief rms_envelope() of samples which arrive in pieces, e.g. from stdout of ffmpeg while it runs
+ * @details Only the window being filled is kept, so memory does not grow with the length of the input.
+ */
+class EnvelopeAccumulator {
+   public:
+    explicit EnvelopeAccumulator(std::size_t window_size);
+    /**
+     * @param data s16le. a sample may be split between calls
+     */
+    void add(const char *data, std::size_t size);
+    /**
+     * @brief envelope of the samples added so far, including the last window which is not full
+     */
+    std::vector<double> envelope() const;
+
+   private:
+    std::size_t window_size_;
+    std::vector<double> envelope_;      // of full windows
+    std::uint64_t sum_of_squares_ = 0;  // of the window being filled
+    std::size_t sample_count_ = 0;      // in the window being filled
+    std::vector<char> partial_sample_;  // first byte of a sample split between calls
+};
+struct DetectionParams {
+    double scene_threshold = 0.35;     // scene score taken as a cut
+    double silence_level = -45;        // dBFS. windows below this are silent
+    double min_silence = 2;            // seconds. shorter silences are pauses, not breaks
+    double min_chapter_length = 60;    // seconds between boundaries
+    double coincidence_window = 1.5;   // seconds. a cut this close to a silence is a stronger candidate
+    double envelope_window = 0.25;     // seconds of each window of rms_envelope()
+};
+/**
+ * @brief starts of chapters after the first one, in seconds from the start of the file
+ * @details Candidates are ends of long silences and scene cuts, and cuts next to silences rank highest. Candidates
+ * are accepted by rank while they are min_chapter_length away from the ends and from accepted ones.
+ * @param keyframe_times seconds from the start of the file
+ * @param scores scene_scores() of the keyframes
+ * @param envelope rms_envelope() with params.envelope_window
+ */
+std::vector<double> propose_boundaries(const std::vector<double> &keyframe_times, const std::vector<double> &scores,
+                                       const std::vector<double> &envelope, double duration,
+                                       const DetectionParams &params = DetectionParams());
+}  // namespace concat
+#endif
@@ -0,0 +1,84 @@
+#include "chaptersplit.hpp"
+
+#include <QFileInfo>
+#include <QRegularExpression>
+#include <algorithm>
+#include <ciso646>
+
+namespace concat {
+namespace {
+// keyframes this close to a boundary are treated as the boundary itself
+constexpr double TOLERANCE = 0.001;
+// range searched for a keyframe on each side of a boundary
+constexpr double KEYFRAME_SEARCH_WINDOW = 20;
+QString format_seconds(double seconds) { return QString::number(seconds, 'f', 6); }
+}  // namespace
+QStringList boundary_probe_arguments(const QString &path, const QVector<double> &boundaries) {
+    QStringList intervals;
+    for (auto boundary : boundaries) {
+        intervals << QStringLiteral("%1%%2").arg(format_seconds(std::max(boundary - KEYFRAME_SEARCH_WINDOW, 0.0)),
+                                                format_seconds(boundary + KEYFRAME_SEARCH_WINDOW));
+    }
+    QStringList result;
+    // clang-format off
+    result << "-v" << "error"
+           << "-select_streams" << "v:0"
+           << "-show_entries" << "packet=pts_time,flags"
+           << "-of" << "csv=p=0"
+           << "-read_intervals" << intervals.join(",")
+           << path;
+    // clang-format on
+    return result;
+}
+QVector<ChapterPart> snap_to_keyframes(const QVector<ChapterPart> &chapters, const QVector<double> &keyframes) {
+    auto snapped = chapters;
+    for (auto &chapter : snapped) {
+        // only keyframes in the window of this boundary are used. ones from windows of other boundaries would move
+        // the start across them in GOPs longer than the window
+        auto next = std::upper_bound(keyframes.begin(), keyframes.end(), chapter.start + TOLERANCE);
+        if (next != keyframes.begin() && *std::prev(next) >= chapter.start - KEYFRAME_SEARCH_WINDOW) {
+            chapter.start = *std::prev(next);
+        } else if (next != keyframes.end() && *next <= chapter.start + KEYFRAME_SEARCH_WINDOW) {
+            chapter.start = *next;
+        }
+    }
+    QVector<ChapterPart> result;
+    for (auto i = 0; i < snapped.size(); i++) {
+        auto part = snapped[i];
+        if (i + 1 < snapped.size()) {
+            part.end = snapped[i + 1].start;
+        }
+        if (part.end - part.start > TOLERANCE) {
+            result << part;
+        }
+    }
+    return result;
+}
+QStringList chapter_export_arguments(const QString &src, const ChapterPart &part, const QString &dst) {
+    QStringList result;
+    // -seek_timestamp makes -ss a timestamp of the source, which chapters and keyframes are expressed in
+    // clang-format off
+    result << "-hide_banner" << "-y"
+           << "-seek_timestamp" << "1"
+           << "-ss" << format_seconds(part.start)
+           << "-i" << src
+           << "-t" << format_seconds(part.end - part.start)
+           << "-map" << "0"
+           << "-c" << "copy"
+           << "-map_chapters" << "-1"
+           << "-avoid_negative_ts" << "make_zero"
+           << dst;
+    // clang-format on
+    return result;
+}
+QString chapter_file_name(const QString &source_path, int index, int count, const QString &title) {
+    QFileInfo source(source_path);
+    auto width = std::max(static_cast<int>(QString::number(count).size()), 2);
+    auto name = QStringLiteral("%1_%2").arg(source.completeBaseName()).arg(index, width, 10, QLatin1Char('0'));
+    auto simplified = title.simplified();
+    if (not simplified.isEmpty()) {
+        name += " " + simplified.replace(QRegularExpression(R"([/\\:*?"<>|])"), "_");
+    }
+    return name + "." + source.suffix();
+}
+}  // namespace concat
@@ -0,0 +1,42 @@
+#ifndef VIDEO_CONCATENATER_CHAPTERSPLIT
+#define VIDEO_CONCATENATER_CHAPTERSPLIT
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+namespace concat {
+/**
+ * @brief a range of the source exported as one file. times are timestamps of the source in seconds
+ */
+struct ChapterPart {
+    double start;
+    double end;
+    QString title;
+};
+/**
+ * @brief arguments of ffprobe which list video packets shortly before and after each boundary
+ * @details Only short ranges are demuxed, so probing does not read the whole source.
+ */
+QStringList boundary_probe_arguments(const QString &path, const QVector<double> &boundaries);
+/**
+ * @brief move the start of each chapter to the last keyframe at or before it
+ * @details If the probed range before the start has no keyframe (GOP longer than the range), the first keyframe after
+ * the start is used instead, and the start is kept if there is none either. The end of a part is the start of the next
+ * one, so parts neither overlap nor leave gaps. Chapters which collapse to nothing by snapping are dropped.
+ * @param chapters sorted by start
+ * @param keyframes sorted. chapters are not moved if this is empty
+ */
+QVector<ChapterPart> snap_to_keyframes(const QVector<ChapterPart> &chapters, const QVector<double> &keyframes);
+/**
+ * @brief arguments of ffmpeg which stream-copy [part.start, part.end) of src into dst without its chapters
+ */
+QStringList chapter_export_arguments(const QString &src, const ChapterPart &part, const QString &dst);
+/**
+ * @brief default file name of a part: "<base name>_<index> <title>.<suffix>"
+ * @details index is 1-based and zero-padded to the width of count. characters which are invalid in file names on
+ * some platforms are replaced by '_'
+ */
+QString chapter_file_name(const QString &source_path, int index, int count, const QString &title);
+}  // namespace concat
+#endif
@@ -0,0 +1,56 @@
+#include "concatlist.hpp"
+
+#include <QStringList>
+#include <algorithm>
+#include <ciso646>
+
+namespace concat {
+namespace {
+QString format_seconds(double seconds) { return QString::number(seconds, 'f', 6); }
+/**
+ * @retval std::nullopt ids differ between entries or are unknown
+ */
+std::optional<int> common_id(const QVector<ConcatListEntry> &entries, QString ConcatListEntry::*id) {
+    if (entries.isEmpty()) {
+        return std::nullopt;
+    }
+    const auto &first = entries.front().*id;
+    auto all_same = std::all_of(entries.begin(), entries.end(),
+                                [&](const ConcatListEntry &entry) { return entry.*id == first; });
+    bool ok;
+    auto result = first.toInt(&ok, 0);  // ffprobe prints ids in hex ("0x1")
+    if (not all_same || not ok) {
+        return std::nullopt;
+    }
+    return result;
+}
+}  // namespace
+QString quote_for_concat(const QString &text) {
+    QString result = text;
+    result.replace("'", R"('\'')");
+    return "'" + result + "'";
+}
+QString write_concat_list(const QVector<ConcatListEntry> &entries) {
+    QStringList lines{"ffconcat version 1.0"};
+    auto video_id = common_id(entries, &ConcatListEntry::video_id);
+    auto audio_id = common_id(entries, &ConcatListEntry::audio_id);
+    if (video_id.has_value() && audio_id.has_value()) {
+        // streams which are not declared here are dropped
+        lines << "stream" << QStringLiteral("exact_stream_id %1").arg(video_id.value());
+        lines << "stream" << QStringLiteral("exact_stream_id %1").arg(audio_id.value());
+    }
+    for (const auto &entry : entries) {
+        lines << "file " + quote_for_concat(entry.path);
+        if (entry.duration.has_value()) {
+            lines << "duration " + format_seconds(entry.duration.value());
+        }
+        if (entry.inpoint.has_value()) {
+            lines << "inpoint " + format_seconds(entry.inpoint.value());
+        }
+        if (entry.outpoint.has_value()) {
+            lines << "outpoint " + format_seconds(entry.outpoint.value());
+        }
+    }
+    return lines.join("\n") + "\n";
+}
+}  // namespace concat
@@ -0,0 +1,32 @@
+#ifndef VIDEO_CONCATENATER_CONCATLIST
+#define VIDEO_CONCATENATER_CONCATLIST
+
+#include <QString>
+#include <QVector>
+#include <optional>
+
+namespace concat {
+/**
+ * @brief one "file" block of ffconcat list. times are in seconds.
+ */
+struct ConcatListEntry {
+    QString path;
+    std::optional<double> duration;  // demuxer does not open the file to learn its duration if this is set
+    std::optional<double> inpoint;
+    std::optional<double> outpoint;
+    QString video_id;  // container-level id of the stream. empty if unknown
+    QString audio_id;
+};
+/**
+ * @brief quote a string for ffconcat. ' is written as '\''
+ */
+QString quote_for_concat(const QString &text);
+/**
+ * @brief write entries as "ffconcat version 1.0"
+ *
+ * if video and audio ids are the same in all entries, streams are declared with exact_stream_id so that the demuxer
+ * does not have to match streams by probing each file.
+ */
+QString write_concat_list(const QVector<ConcatListEntry> &entries);
+}  // namespace concat
+#endif
@@ -0,0 +1,137 @@
+#include "copysafety.hpp"
+
+#include <QObject>
+#include <algorithm>
+#include <ciso646>
+
+namespace concat {
+StreamParams StreamParams::from_ffprobe(const QJsonObject &stream) {
+    StreamParams result;
+    result.codec_type = stream["codec_type"].toString();
+    result.codec_name = stream["codec_name"].toString();
+    result.profile = stream["profile"].toString();
+    result.level = stream["level"].toInt(-1);
+    result.extradata_hash = stream["extradata_hash"].toString();
+    result.time_base = stream["time_base"].toString();
+    result.id = stream["id"].toString();
+    result.start_time = stream["start_time"].toString().toDouble();
+    bool ok;
+    result.duration = stream["duration"].toString().toDouble(&ok);
+    if (not ok) {
+        result.duration = -1;
+    }
+    result.bit_rate = stream["bit_rate"].toString().toLongLong();
+    result.nb_frames = stream["nb_frames"].toString().toLongLong(&ok);
+    if (not ok) {
+        result.nb_frames = -1;
+    }
+    result.width = stream["width"].toInt();
+    result.height = stream["height"].toInt();
+    result.pix_fmt = stream["pix_fmt"].toString();
+    result.field_order = stream["field_order"].toString();
+    result.r_frame_rate = stream["r_frame_rate"].toString();
+    result.sample_fmt = stream["sample_fmt"].toString();
+    result.sample_rate = stream["sample_rate"].toString().toInt();
+    result.channels = stream["channels"].toInt();
+    result.channel_layout = stream["channel_layout"].toString();
+    return result;
+}
+QString annexb_filter_of(const QString &codec_name) {
+    if (codec_name == "h264") {
+        return "h264_mp4toannexb";
+    } else if (codec_name == "hevc") {
+        return "hevc_mp4toannexb";
+    } else {
+        return "";
+    }
+}
+namespace {
+template <class T>
+QString describe_difference(const QString &name, const T &first, const T &other, int index, const QString &path) {
+    return QObject::tr("input %1 [%2]: %3 is %4 (input 1: %5)").arg(index + 1).arg(path, name).arg(other).arg(first);
+}
+}  // namespace
+CopyAnalysis analyze_copy_safety(const QVector<AnalyzedInput> &inputs) {
+    CopyAnalysis result;
+    bool parameter_sets_differ = std::any_of(inputs.begin(), inputs.end(),
+                                             [](const AnalyzedInput &input) { return input.has_rendered_boundaries; });
+    if (inputs.size() < 2 && not parameter_sets_differ) {
+        return result;
+    }
+    const auto &first = inputs.front();
+    for (auto i = 1; i < inputs.size(); i++) {
+        const auto &video = inputs[i].video;
+        const auto &audio = inputs[i].audio;
+        const auto &path = inputs[i].path;
+        // differences which cannot be fixed without decoding
+        auto check = [&](QStringList &reasons, const QString &name, const auto &first_value, const auto &value) {
+            if (first_value != value) {
+                reasons << describe_difference(name, first_value, value, i, path);
+            }
+        };
+        check(result.video_reasons, "video codec", first.video.codec_name, video.codec_name);
+        check(result.video_reasons, "width", first.video.width, video.width);
+        check(result.video_reasons, "height", first.video.height, video.height);
+        check(result.video_reasons, "pixel format", first.video.pix_fmt, video.pix_fmt);
+        check(result.video_reasons, "field order", first.video.field_order, video.field_order);
+        check(result.audio_reasons, "audio codec", first.audio.codec_name, audio.codec_name);
+        check(result.audio_reasons, "audio profile", first.audio.profile, audio.profile);
+        check(result.audio_reasons, "sample rate", first.audio.sample_rate, audio.sample_rate);
+        check(result.audio_reasons, "channels", first.audio.channels, audio.channels);
+        check(result.audio_reasons, "channel layout", first.audio.channel_layout, audio.channel_layout);
+        check(result.audio_reasons, "sample format", first.audio.sample_fmt, audio.sample_fmt);
+        // e.g. AudioSpecificConfig of AAC. decoder is not reconfigured in the middle of stream
+        check(result.audio_reasons, "audio extradata", first.audio.extradata_hash, audio.extradata_hash);
+        // differences which can be fixed on stream copy
+        if (first.video.profile != video.profile || first.video.level != video.level ||
+            first.video.extradata_hash != video.extradata_hash) {
+            parameter_sets_differ = true;
+        }
+        if (first.video.time_base != video.time_base) {
+            result.fixups << describe_difference("video time base", first.video.time_base, video.time_base, i, path) +
+                                 " " + QObject::tr("(timestamps are rescaled to time base of input 1)");
+        }
+        if (first.video.r_frame_rate != video.r_frame_rate) {
+            result.fixups << describe_difference("frame rate", first.video.r_frame_rate, video.r_frame_rate, i,
+                                                 path) +
+                                 " " + QObject::tr("(kept as variable frame rate)");
+        }
+    }
+    result.video_requires_encoding = not result.video_reasons.isEmpty();
+    result.audio_requires_encoding = not result.audio_reasons.isEmpty();
+    if (parameter_sets_differ && not result.video_requires_encoding) {
+        // the concat demuxer passes the extradata of the first input only. each input is remuxed to MPEG-TS with its
+        // parameter sets in-band, so that the decoder is reconfigured at each join
+        if (not annexb_filter_of(first.video.codec_name).isEmpty()) {
+            result.video_requires_annexb_segments = true;
+            result.fixups << QObject::tr("parameter sets differ between inputs: each input is remuxed with %1")
+                                 .arg(annexb_filter_of(first.video.codec_name));
+        } else {
+            result.video_requires_encoding = true;
+            result.video_reasons << QObject::tr("codec private data (extradata) of %1 differs between inputs")
+                                        .arg(first.video.codec_name);
+        }
+    }
+    return result;
+}
+QString CopyAnalysis::report() const {
+    QString result;
+    result += QObject::tr("video: %1").arg(video_requires_encoding ? QObject::tr("re-encode") : QObject::tr("copy"));
+    result += "\n";
+    for (const auto &reason : video_reasons) {
+        result += "  " + reason + "\n";
+    }
+    result += QObject::tr("audio: %1").arg(audio_requires_encoding ? QObject::tr("re-encode") : QObject::tr("copy"));
+    result += "\n";
+    for (const auto &reason : audio_reasons) {
+        result += "  " + reason + "\n";
+    }
+    if (not fixups.isEmpty()) {
+        result += QObject::tr("fixups:") + "\n";
+        for (const auto &fixup : fixups) {
+            result += "  " + fixup + "\n";
+        }
+    }
+    return result;
+}
+}  // namespace concat
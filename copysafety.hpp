@@ -0,0 +1,66 @@
+#ifndef VIDEO_CONCATENATER_COPYSAFETY
+#define VIDEO_CONCATENATER_COPYSAFETY
+
+#include <QJsonObject>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+namespace concat {
+/**
+ * @brief parameters of a stream which must match across inputs to concatenate it with stream copy
+ */
+struct StreamParams {
+    QString codec_type;
+    QString codec_name;
+    QString profile;
+    int level = -1;
+    QString extradata_hash;  // needs "-show_data_hash" on ffprobe
+    QString time_base;
+    QString id;  // container-level id (track id or PID)
+    double start_time = 0;  // seconds
+    double duration = -1;   // seconds. negative if unknown
+    qint64 bit_rate = 0;    // bits per second. 0 if unknown (e.g. streams in Matroska)
+    qint64 nb_frames = -1;  // packets counted by the index of the container. negative if unknown
+    // video
+    int width = 0;
+    int height = 0;
+    QString pix_fmt;
+    QString field_order;
+    QString r_frame_rate;
+    // audio
+    QString sample_fmt;
+    int sample_rate = 0;
+    int channels = 0;
+    QString channel_layout;
+
+    static StreamParams from_ffprobe(const QJsonObject &stream);
+};
+struct CopyAnalysis {
+    bool video_requires_encoding = false;
+    bool audio_requires_encoding = false;
+    /// video streams must be rewritten to Annex B with in-band parameter sets per segment (stream copy)
+    bool video_requires_annexb_segments = false;
+    QStringList video_reasons;  // why video has to be re-encoded
+    QStringList audio_reasons;  // why audio has to be re-encoded
+    QStringList fixups;         // what is done to keep stream copy
+
+    QString report() const;
+};
+struct AnalyzedInput {
+    QString path;
+    StreamParams video;
+    StreamParams audio;
+    /// boundary GOPs of the input are re-encoded for trimming, so parameter sets differ inside the input
+    bool has_rendered_boundaries = false;
+};
+/**
+ * @brief compare stream parameters of all inputs and decide what is needed to concatenate them with stream copy
+ */
+CopyAnalysis analyze_copy_safety(const QVector<AnalyzedInput> &inputs);
+/**
+ * @brief bitstream filter which converts codec to Annex B. empty if codec has no such filter.
+ */
+QString annexb_filter_of(const QString &codec_name);
+}  // namespace concat
+#endif
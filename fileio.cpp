@@ -0,0 +1,74 @@
+#include "fileio.hpp"
+
+#ifdef __linux__
+#    include <sys/stat.h>
+#    include <unistd.h>
+
+#    include <array>
+#    include <cerrno>
+#    include <system_error>
+
+namespace concat {
+namespace fs = std::filesystem;
+FileDescriptor::~FileDescriptor() {
+    if (fd_ >= 0) {
+        ::close(fd_);
+    }
+}
+void throw_errno(const char *what, const fs::path &path) {
+    throw fs::filesystem_error(what, path, std::error_code(errno, std::generic_category()));
+}
+void write_all(int fd, const void *data, std::size_t size, const fs::path &path) {
+    auto bytes = static_cast<const char *>(data);
+    for (std::size_t written = 0; written < size;) {
+        auto result = ::write(fd, bytes + written, size - written);
+        if (result < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw_errno("write", path);
+        }
+        written += result;
+    }
+}
+void append_contents(int src_fd, int dst_fd, const fs::path &src) {
+    struct stat src_stat {};
+    if (::fstat(src_fd, &src_stat) != 0) {
+        throw_errno("fstat", src);
+    }
+    // copy_file_range() lets the kernel (or NFS/SMB server) copy without passing data through userspace
+    auto offset = ::lseek(src_fd, 0, SEEK_CUR);
+    off_t remaining = src_stat.st_size - (offset < 0 ? 0 : offset);
+    while (remaining > 0) {
+        auto copied = ::copy_file_range(src_fd, nullptr, dst_fd, nullptr, remaining, 0);
+        if (copied < 0) {
+            if (errno == EXDEV || errno == ENOSYS || errno == EINVAL || errno == EOPNOTSUPP) {
+                break;  // fall back to read()/write() below
+            }
+            throw_errno("copy_file_range", src);
+        }
+        if (copied == 0) {
+            break;
+        }
+        remaining -= copied;
+    }
+    if (remaining <= 0) {
+        return;
+    }
+    std::array<char, 1 << 20> buffer{};
+    while (true) {
+        auto read_size = ::read(src_fd, buffer.data(), buffer.size());
+        if (read_size < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw_errno("read", src);
+        }
+        if (read_size == 0) {
+            return;
+        }
+        write_all(dst_fd, buffer.data(), read_size, src);
+    }
+}
+}  // namespace concat
+#endif
@@ -0,0 +1,38 @@
+#ifndef VIDEO_CONCATENATER_FILEIO
+#define VIDEO_CONCATENATER_FILEIO
+
+#include <filesystem>
+
+#ifdef __linux__
+namespace concat {
+/**
+ * @brief owns a file descriptor of POSIX
+ */
+class FileDescriptor {
+    int fd_;
+
+   public:
+    explicit FileDescriptor(int fd) : fd_(fd) {}
+    FileDescriptor(const FileDescriptor &) = delete;
+    FileDescriptor &operator=(const FileDescriptor &) = delete;
+    ~FileDescriptor();
+    int get() const { return fd_; }
+};
+/**
+ * @throw std::filesystem::filesystem_error made from errno
+ */
+[[noreturn]] void throw_errno(const char *what, const std::filesystem::path &path);
+/**
+ * @brief write src_fd from its current offset to its end at current offset of dst_fd
+ * @details copy_file_range() is tried first. read()/write() is used if it is not supported.
+ * @throw std::filesystem::filesystem_error
+ */
+void append_contents(int src_fd, int dst_fd, const std::filesystem::path &src);
+/**
+ * @brief write whole buffer, retrying on EINTR
+ * @throw std::filesystem::filesystem_error
+ */
+void write_all(int fd, const void *data, std::size_t size, const std::filesystem::path &path);
+}  // namespace concat
+#endif
+#endif
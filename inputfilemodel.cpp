@@ -0,0 +1,394 @@
+#include "inputfilemodel.hpp"
+
+#include <QCollator>
+#include <QDataStream>
+#include <QFileInfo>
+#include <QIODevice>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QLocale>
+#include <QMimeData>
+#include <QProcess>
+#include <QThread>
+#include <QTime>
+#include <QUrl>
+#include <algorithm>
+#include <ciso646>
+#include <numeric>
+
+#include "thumbnailprovider.hpp"
+#include "trim.hpp"
+
+namespace {
+constexpr int PROBE_TIMEOUT_MSEC = 60'000;
+QString format_duration(double seconds) {
+    return QTime::fromMSecsSinceStartOfDay(static_cast<int>(seconds * 1000)).toString("hh:mm:ss.zzz");
+}
+}  // namespace
+
+InputFileModel::InputFileModel(QObject *parent) : QAbstractTableModel(parent) {
+    // ffprobe is mostly waiting for I/O, so more threads than cores are useful on network mounts
+    pool_.setMaxThreadCount(qMax(4, QThread::idealThreadCount()));
+}
+
+InputFileModel::~InputFileModel() {
+    pool_.clear();
+    pool_.waitForDone();
+}
+
+int InputFileModel::rowCount(const QModelIndex &parent) const { return parent.isValid() ? 0 : entries_.size(); }
+int InputFileModel::columnCount(const QModelIndex &parent) const { return parent.isValid() ? 0 : COLUMN_COUNT; }
+
+QVariant InputFileModel::data(const QModelIndex &index, int role) const {
+    if (not index.isValid() || index.row() >= entries_.size()) {
+        return QVariant();
+    }
+    const auto &entry = entries_[index.row()];
+    if (role == Qt::ToolTipRole) {
+        if (index.column() == IN_POINT || index.column() == OUT_POINT) {
+            return tr("hh:mm:ss.zzz or seconds. empty to cancel trimming");
+        }
+        if (index.column() == PATH) {
+            return thumbnail_strip_(entry);
+        }
+        return entry.path;
+    }
+    if (role != Qt::DisplayRole && role != Qt::EditRole) {
+        return QVariant();
+    }
+    if (index.column() == PATH) {
+        return entry.path;
+    }
+    if (index.column() == IN_POINT || index.column() == OUT_POINT) {
+        const auto &point = index.column() == IN_POINT ? entry.in_point : entry.out_point;
+        return point.has_value() ? concat::format_time(point.value()) : QString();
+    }
+    if (entry.state == Entry::State::PENDING) {
+        return tr("...");
+    }
+    if (entry.state == Entry::State::FAILED && index.column() != SIZE) {
+        return tr("N/A");
+    }
+    switch (index.column()) {
+        case DURATION:
+            return entry.duration.has_value() ? format_duration(entry.duration.value()) : tr("N/A");
+        case VIDEO_CODEC:
+            return entry.video_codec;
+        case AUDIO_CODEC:
+            return entry.audio_codec;
+        case RESOLUTION:
+            return entry.resolution.isValid()
+                       ? QStringLiteral("%1x%2").arg(entry.resolution.width()).arg(entry.resolution.height())
+                       : tr("N/A");
+        case SIZE:
+            return entry.size.has_value() ? QLocale().formattedDataSize(entry.size.value()) : tr("N/A");
+        case CHAPTERS:
+            return entry.chapter_count.has_value() ? QVariant(entry.chapter_count.value()) : QVariant(tr("N/A"));
+        default:
+            return QVariant();
+    }
+}
+
+QVariant InputFileModel::headerData(int section, Qt::Orientation orientation, int role) const {
+    if (role != Qt::DisplayRole) {
+        return QVariant();
+    }
+    if (orientation == Qt::Vertical) {
+        return section + 1;
+    }
+    switch (section) {
+        case PATH:
+            return tr("path");
+        case DURATION:
+            return tr("duration");
+        case VIDEO_CODEC:
+            return tr("video codec");
+        case AUDIO_CODEC:
+            return tr("audio codec");
+        case RESOLUTION:
+            return tr("resolution");
+        case SIZE:
+            return tr("size");
+        case CHAPTERS:
+            return tr("chapters");
+        case IN_POINT:
+            return tr("in");
+        case OUT_POINT:
+            return tr("out");
+        default:
+            return QVariant();
+    }
+}
+
+Qt::ItemFlags InputFileModel::flags(const QModelIndex &index) const {
+    auto result = QAbstractTableModel::flags(index);
+    if (index.isValid()) {
+        result |= Qt::ItemIsDragEnabled;
+        if (index.column() == IN_POINT || index.column() == OUT_POINT) {
+            result |= Qt::ItemIsEditable;
+        }
+    } else {
+        result |= Qt::ItemIsDropEnabled;
+    }
+    return result;
+}
+
+bool InputFileModel::setData(const QModelIndex &index, const QVariant &value, int role) {
+    if (role != Qt::EditRole || not index.isValid() ||
+        (index.column() != IN_POINT && index.column() != OUT_POINT)) {
+        return false;
+    }
+    auto &entry = entries_[index.row()];
+    std::optional<double> point = std::nullopt;
+    auto text = value.toString();
+    if (not text.trimmed().isEmpty()) {
+        point = concat::parse_time(text);
+        if (not point.has_value()) {
+            return false;
+        }
+    }
+    auto in_point = index.column() == IN_POINT ? point : entry.in_point;
+    auto out_point = index.column() == OUT_POINT ? point : entry.out_point;
+    if (in_point.has_value() && out_point.has_value() && in_point.value() >= out_point.value()) {
+        return false;
+    }
+    if (point.has_value() && entry.duration.has_value() && point.value() > entry.duration.value()) {
+        return false;
+    }
+    entry.in_point = in_point;
+    entry.out_point = out_point;
+    emit dataChanged(index, index, {Qt::DisplayRole, Qt::EditRole});
+    return true;
+}
+
+Qt::DropActions InputFileModel::supportedDropActions() const { return Qt::MoveAction; }
+
+QStringList InputFileModel::mimeTypes() const { return {MIME_TYPE}; }
+
+QMimeData *InputFileModel::mimeData(const QModelIndexList &indexes) const {
+    QVector<int> rows;
+    for (const auto &index : indexes) {
+        if (index.isValid()) {
+            rows << index.row();
+        }
+    }
+    std::sort(rows.begin(), rows.end());
+    rows.erase(std::unique(rows.begin(), rows.end()), rows.end());
+    QByteArray encoded;
+    QDataStream stream(&encoded, QIODevice::WriteOnly);
+    stream << rows;
+    auto result = new QMimeData;
+    result->setData(MIME_TYPE, encoded);
+    return result;
+}
+
+bool InputFileModel::dropMimeData(const QMimeData *data, Qt::DropAction action, int row, int,
+                                  const QModelIndex &parent) {
+    if (action != Qt::MoveAction || not data->hasFormat(MIME_TYPE)) {
+        return false;
+    }
+    QVector<int> moved_rows;
+    QDataStream stream(data->data(MIME_TYPE));
+    stream >> moved_rows;
+    std::sort(moved_rows.begin(), moved_rows.end());
+    if (row < 0) {
+        row = parent.isValid() ? parent.row() : entries_.size();
+    }
+    QVector<int> order;
+    order.reserve(entries_.size());
+    for (int i = 0; i < entries_.size(); i++) {
+        if (i == row) {
+            order += moved_rows;
+        }
+        if (not std::binary_search(moved_rows.begin(), moved_rows.end(), i)) {
+            order << i;
+        }
+    }
+    if (row >= entries_.size()) {
+        order += moved_rows;
+    }
+    reorder_(order);
+    // rows are already moved here. Returning false prevents the view from removing the source rows.
+    return false;
+}
+
+void InputFileModel::sort(int column, Qt::SortOrder order) {
+    if (column < 0 || column >= COLUMN_COUNT || entries_.isEmpty()) {
+        return;
+    }
+    QCollator collator;
+    collator.setNumericMode(true);
+    auto less = [&](const Entry &a, const Entry &b) -> bool {
+        switch (column) {
+            case DURATION:
+                return a.duration.value_or(-1) < b.duration.value_or(-1);
+            case VIDEO_CODEC:
+                return collator.compare(a.video_codec, b.video_codec) < 0;
+            case AUDIO_CODEC:
+                return collator.compare(a.audio_codec, b.audio_codec) < 0;
+            case RESOLUTION:
+                return a.resolution.width() * a.resolution.height() < b.resolution.width() * b.resolution.height();
+            case SIZE:
+                return a.size.value_or(-1) < b.size.value_or(-1);
+            case CHAPTERS:
+                return a.chapter_count.value_or(-1) < b.chapter_count.value_or(-1);
+            case IN_POINT:
+                return a.in_point.value_or(-1) < b.in_point.value_or(-1);
+            case OUT_POINT:
+                return a.out_point.value_or(-1) < b.out_point.value_or(-1);
+            case PATH:
+            default:
+                return collator.compare(a.path, b.path) < 0;
+        }
+    };
+    QVector<int> new_order(entries_.size());
+    std::iota(new_order.begin(), new_order.end(), 0);
+    std::stable_sort(new_order.begin(), new_order.end(), [&](int a, int b) {
+        return order == Qt::AscendingOrder ? less(entries_[a], entries_[b]) : less(entries_[b], entries_[a]);
+    });
+    reorder_(new_order);
+}
+
+void InputFileModel::add_files(const QStringList &paths) {
+    if (paths.isEmpty()) {
+        return;
+    }
+    beginInsertRows(QModelIndex(), entries_.size(), entries_.size() + paths.size() - 1);
+    for (const auto &path : paths) {
+        Entry entry{};
+        entry.id = next_id_++;
+        entry.path = path;
+        row_cache_.insert(entry.id, entries_.size());
+        entries_.push_back(entry);
+    }
+    endInsertRows();
+    for (auto i = entries_.size() - paths.size(); i < entries_.size(); i++) {
+        request_probe_(entries_[i]);
+    }
+}
+
+void InputFileModel::clear() {
+    pool_.clear();  // drop queued probes. results of running ones are ignored as their ids are not found.
+    beginResetModel();
+    entries_.clear();
+    row_cache_.clear();
+    row_cache_is_valid_ = true;
+    endResetModel();
+}
+
+const InputFileModel::Entry &InputFileModel::entry(int row) const { return entries_.at(row); }
+QString InputFileModel::path(int row) const { return entries_.at(row).path; }
+
+void InputFileModel::set_thumbnail_provider(ThumbnailProvider *provider) { thumbnails_ = provider; }
+
+QString InputFileModel::thumbnail_strip_(const Entry &entry) const {
+    if (thumbnails_ == nullptr || entry.state != Entry::State::DONE || not entry.duration.has_value()) {
+        return entry.path;
+    }
+    QString images;
+    bool is_complete = true;
+    for (auto i = 0; i < STRIP_LENGTH; i++) {
+        // middles of equal sections, so that the first and last frames (often black) are not taken
+        auto thumbnail = thumbnails_->request(entry.path, entry.duration.value() * (i + 0.5) / STRIP_LENGTH, this);
+        if (thumbnail.isEmpty()) {
+            is_complete = false;  // the strip is shown the next time the tooltip is shown
+        } else {
+            images += QStringLiteral(R"(<img src="%1">)").arg(QUrl::fromLocalFile(thumbnail).toString());
+        }
+    }
+    if (not is_complete) {
+        return entry.path;
+    }
+    return QStringLiteral("<p>%1</p><p style=\"white-space:nowrap\">%2</p>").arg(entry.path.toHtmlEscaped(), images);
+}
+
+void InputFileModel::request_probe_(const Entry &entry) {
+    pool_.start([this, id = entry.id, path = entry.path] {
+        std::optional<qint64> size = std::nullopt;
+        QFileInfo file_info(path);
+        if (file_info.exists()) {
+            size = file_info.size();
+        }
+        QProcess ffprobe;
+        ffprobe.start("ffprobe", {"-hide_banner", "-show_streams", "-show_format", "-show_chapters", "-show_data_hash",
+                                  "MD5", "-of", "json", "-v", "quiet", path});
+        QJsonObject probe;
+        bool is_success = ffprobe.waitForFinished(PROBE_TIMEOUT_MSEC) && ffprobe.exitStatus() == QProcess::NormalExit &&
+                          ffprobe.exitCode() == 0;
+        if (is_success) {
+            auto document = QJsonDocument::fromJson(ffprobe.readAllStandardOutput());
+            is_success = document.isObject();
+            probe = document.object();
+        }
+        QMetaObject::invokeMethod(
+            this, [=] { this->apply_probe_(id, probe, size, is_success); }, Qt::QueuedConnection);
+    });
+}
+
+void InputFileModel::apply_probe_(quint64 id, QJsonObject probe, std::optional<qint64> size, bool is_success) {
+    auto row = row_of_(id);
+    if (row < 0) {
+        return;  // removed while probing
+    }
+    auto &entry = entries_[row];
+    entry.size = size;
+    if (is_success) {
+        entry.state = Entry::State::DONE;
+        entry.probe = probe;
+        bool ok;
+        double duration = probe["format"].toObject()["duration"].toString().toDouble(&ok);
+        if (ok) {
+            entry.duration = duration;
+        }
+        for (auto stream_value : probe["streams"].toArray()) {
+            auto stream = stream_value.toObject();
+            if (stream["codec_type"] == "video" && entry.video_codec.isEmpty()) {
+                entry.video_codec = stream["codec_name"].toString();
+                entry.resolution = QSize(stream["width"].toInt(), stream["height"].toInt());
+            } else if (stream["codec_type"] == "audio" && entry.audio_codec.isEmpty()) {
+                entry.audio_codec = stream["codec_name"].toString();
+            }
+        }
+        entry.chapter_count = probe["chapters"].toArray().size();
+    } else {
+        entry.state = Entry::State::FAILED;
+    }
+    emit dataChanged(index(row, DURATION), index(row, COLUMN_COUNT - 1), {Qt::DisplayRole});
+}
+
+int InputFileModel::row_of_(quint64 id) const {
+    if (not row_cache_is_valid_) {
+        row_cache_.clear();
+        for (int i = 0; i < entries_.size(); i++) {
+            row_cache_.insert(entries_[i].id, i);
+        }
+        row_cache_is_valid_ = true;
+    }
+    return row_cache_.value(id, -1);
+}
+
+void InputFileModel::reorder_(const QVector<int> &order) {
+    Q_ASSERT(order.size() == entries_.size());
+    emit layoutAboutToBeChanged({}, QAbstractItemModel::VerticalSortHint);
+    QVector<int> new_row_of(order.size());
+    for (int i = 0; i < order.size(); i++) {
+        new_row_of[order[i]] = i;
+    }
+    auto from = persistentIndexList();
+    QModelIndexList to;
+    to.reserve(from.size());
+    for (const auto &index : from) {
+        to << this->index(new_row_of[index.row()], index.column());
+    }
+    changePersistentIndexList(from, to);
+    QVector<Entry> reordered;
+    reordered.reserve(entries_.size());
+    for (auto old_row : order) {
+        reordered.push_back(std::move(entries_[old_row]));
+    }
+    entries_ = std::move(reordered);
+    row_cache_is_valid_ = false;
+    emit layoutChanged({}, QAbstractItemModel::VerticalSortHint);
+}
+
+void InputFileProxyModel::sort(int column, Qt::SortOrder order) { sourceModel()->sort(column, order); }
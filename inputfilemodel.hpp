@@ -0,0 +1,112 @@
+#ifndef INPUTFILEMODEL_HPP
+#define INPUTFILEMODEL_HPP
+
+#include <QAbstractTableModel>
+#include <QHash>
+#include <QJsonObject>
+#include <QSize>
+#include <QSortFilterProxyModel>
+#include <QString>
+#include <QStringList>
+#include <QThreadPool>
+#include <QVector>
+#include <optional>
+
+class ThumbnailProvider;
+
+/**
+ * @brief list of input files. Metadata columns are filled asynchronously by ffprobe running on a thread pool.
+ * @note Order of rows is order of concatenation. sort() reorders rows themselves.
+ */
+class InputFileModel : public QAbstractTableModel {
+    Q_OBJECT
+
+   public:
+    enum Column {
+        PATH,
+        DURATION,
+        VIDEO_CODEC,
+        AUDIO_CODEC,
+        RESOLUTION,
+        SIZE,
+        CHAPTERS,
+        IN_POINT,
+        OUT_POINT,
+        COLUMN_COUNT
+    };
+    struct Entry {
+        enum class State { PENDING, DONE, FAILED };
+        quint64 id;
+        QString path;
+        State state = State::PENDING;
+        std::optional<double> duration;  // seconds
+        QString video_codec;
+        QString audio_codec;
+        QSize resolution;
+        std::optional<qint64> size;
+        std::optional<int> chapter_count;
+        std::optional<double> in_point;   // seconds from start of file. edited by user
+        std::optional<double> out_point;  // seconds from start of file. edited by user
+        QJsonObject probe;  // raw result of ffprobe. valid only if state is DONE
+    };
+
+    explicit InputFileModel(QObject *parent = nullptr);
+    ~InputFileModel();
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    bool setData(const QModelIndex &index, const QVariant &value, int role = Qt::EditRole) override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+    Qt::ItemFlags flags(const QModelIndex &index) const override;
+    Qt::DropActions supportedDropActions() const override;
+    QStringList mimeTypes() const override;
+    QMimeData *mimeData(const QModelIndexList &indexes) const override;
+    bool dropMimeData(const QMimeData *data, Qt::DropAction action, int row, int column,
+                      const QModelIndex &parent) override;
+    void sort(int column, Qt::SortOrder order = Qt::AscendingOrder) override;
+
+    void add_files(const QStringList &paths);
+    void clear();
+    const Entry &entry(int row) const;
+    QString path(int row) const;
+    /**
+     * @brief show a strip of keyframes in the tooltip of paths. thumbnails are requested when the tooltip is shown
+     */
+    void set_thumbnail_provider(ThumbnailProvider *provider);
+
+   private:
+    QVector<Entry> entries_;
+    quint64 next_id_ = 0;
+    QThreadPool pool_;
+    mutable QHash<quint64, int> row_cache_;
+    mutable bool row_cache_is_valid_ = false;
+    static constexpr auto MIME_TYPE = "application/x-video-concatenater-rows";
+    ThumbnailProvider *thumbnails_ = nullptr;  // not owned
+    static constexpr int STRIP_LENGTH = 6;     // thumbnails in the tooltip of a path
+
+    QString thumbnail_strip_(const Entry &entry) const;
+
+    void request_probe_(const Entry &entry);
+    void apply_probe_(quint64 id, QJsonObject probe, std::optional<qint64> size, bool is_success);
+    int row_of_(quint64 id) const;
+    /**
+     * @brief reorder rows keeping persistent indexes valid
+     *
+     * @param order order[i] is the old row which will be placed at row i
+     */
+    void reorder_(const QVector<int> &order);
+};
+
+/**
+ * @brief filters rows by path. sorting is forwarded to source model as the order of rows is meaningful.
+ */
+class InputFileProxyModel : public QSortFilterProxyModel {
+    Q_OBJECT
+
+   public:
+    using QSortFilterProxyModel::QSortFilterProxyModel;
+    void sort(int column, Qt::SortOrder order = Qt::AscendingOrder) override;
+};
+
+#endif  // INPUTFILEMODEL_HPP
@@ -0,0 +1,61 @@
+#include "joinrepair.hpp"
+
+#include <QObject>
+#include <ciso646>
+#include <cmath>
+
+namespace concat {
+namespace {
+// smaller differences than this are within one audio frame and cannot be fixed on stream copy
+constexpr double TOLERANCE = 0.001;
+QString format_ms(double seconds) { return QString::number(seconds * 1000, 'f', 1) + "ms"; }
+}  // namespace
+std::optional<SegmentTiming> SegmentTiming::from_streams(double file_start, const StreamParams &video,
+                                                          const StreamParams &audio) {
+    if (video.duration < 0 || audio.duration < 0) {
+        return std::nullopt;
+    }
+    return SegmentTiming{file_start, video.start_time, video.start_time + video.duration, audio.start_time,
+                         audio.start_time + audio.duration};
+}
+SegmentPlan plan_segment(const SegmentTiming &timing) {
+    SegmentPlan result{timing.video_end - timing.file_start, std::nullopt, std::nullopt};
+    if (timing.audio_end - timing.video_end > TOLERANCE) {
+        result.outpoint = timing.video_end;
+    }
+    return result;
+}
+QString join_report(const QVector<SegmentTiming> &timings, const QStringList &names) {
+    QString result;
+    double accumulated_drift = 0;
+    for (auto i = 0; i < timings.size(); i++) {
+        const auto &timing = timings[i];
+        auto drift = timing.audio_end - timing.video_end;  // positive: audio is longer than video
+        auto priming = timing.video_start - timing.audio_start;
+        accumulated_drift += drift;
+        result += QObject::tr("segment %1 [%2]").arg(i + 1).arg(names.value(i)) + "\n";
+        result += "  " + QObject::tr("audio end - video end: %1").arg(format_ms(drift));
+        if (drift > TOLERANCE) {
+            result += " " + QObject::tr("(trailing audio is cut at end of video)");
+        } else if (drift < -TOLERANCE) {
+            result += " " + QObject::tr("(audio gap before next segment)");
+        }
+        result += "\n";
+        if (std::abs(priming) > TOLERANCE) {
+            result += "  " + QObject::tr("audio starts %1 before video (priming)").arg(format_ms(priming));
+            if (i > 0) {
+                // only the edit list of the first segment survives stream copy
+                result += " " + QObject::tr("(not removed: priming samples of this segment are kept at the join)");
+            }
+            result += "\n";
+        }
+        if (i + 1 < timings.size()) {
+            result += "  " + QObject::tr("drift accumulated without repair after join %1: %2")
+                                 .arg(i + 1)
+                                 .arg(format_ms(accumulated_drift)) +
+                      "\n";
+        }
+    }
+    return result;
+}
+}  // namespace concat
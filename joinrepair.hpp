@@ -0,0 +1,45 @@
+#ifndef VIDEO_CONCATENATER_JOINREPAIR
+#define VIDEO_CONCATENATER_JOINREPAIR
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <optional>
+
+#include "copysafety.hpp"
+
+namespace concat {
+/**
+ * @brief timestamps (in seconds, on the timeline of the file) where streams of a segment start and end
+ */
+struct SegmentTiming {
+    double file_start;  // start_time of container. includes AAC priming (negative start of audio)
+    double video_start;
+    double video_end;
+    double audio_start;
+    double audio_end;
+
+    /**
+     * @retval std::nullopt durations of streams are unknown
+     */
+    static std::optional<SegmentTiming> from_streams(double file_start, const StreamParams &video,
+                                                     const StreamParams &audio);
+};
+/**
+ * @brief how a segment is written in concat list so that its length on the output timeline is exact
+ */
+struct SegmentPlan {
+    double duration;                 // length on output timeline (video is master)
+    std::optional<double> outpoint;  // set if audio runs past the end of video. trailing audio packets are dropped
+    std::optional<double> inpoint;   // set if the segment starts at a keyframe in the middle of the file
+};
+SegmentPlan plan_segment(const SegmentTiming &timing);
+/**
+ * @brief describe measured A/V drift at every join and how much would accumulate without repair
+ * @note AAC priming of segments after the first is reported but not removed. Removing it needs either re-encoding
+ * the audio at the join or an edit list per segment, neither of which is possible with the concat demuxer on stream
+ * copy.
+ */
+QString join_report(const QVector<SegmentTiming> &timings, const QStringList &names);
+}  // namespace concat
+#endif
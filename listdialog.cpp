@@ -1,32 +1,86 @@
 #include "listdialog.hpp"
 
+#include <ciso646>
+
+#include "textlistmodel.hpp"
 #include "ui_listdialog.h"
 
 ListDialog::ListDialog(QWidget *parent) : QDialog(parent), ui_(new Ui::ListDialog) {
     ui_->setupUi(this);
-    connect(ui_->listWidget, &QListWidget::itemActivated, ui_->listWidget, &QListWidget::editItem);
+    connect(ui_->listView, &QListView::activated, ui_->listView, qOverload<const QModelIndex &>(&QListView::edit));
+    connect(ui_->pushButton_replace, &QPushButton::clicked, this, &ListDialog::replace_);
+    connect(ui_->lineEdit_replace, &QLineEdit::returnPressed, this, &ListDialog::replace_);
+    connect(ui_->pushButton_rename, &QPushButton::clicked, this, &ListDialog::rename_);
+    connect(ui_->lineEdit_pattern, &QLineEdit::returnPressed, this, &ListDialog::rename_);
+    connect(ui_->pushButton_add, &QPushButton::clicked, this, &ListDialog::add_);
+    connect(ui_->pushButton_remove, &QPushButton::clicked, this, &ListDialog::remove_);
+    set_rows_addable(false);
 }
 
 ListDialog::~ListDialog() { delete ui_; }
 
+void ListDialog::set_texts_(const QStringList &texts) {
+    model_ = new TextListModel(texts, this);
+    ui_->listView->setModel(model_);
+}
+
+void ListDialog::replace_() {
+    auto find = ui_->lineEdit_find->text();
+    if (find.isEmpty()) {
+        return;
+    }
+    QRegularExpression pattern(ui_->checkBox_regex->isChecked() ? find : QRegularExpression::escape(find));
+    if (not pattern.isValid()) {
+        ui_->label_status->setText(tr("invalid regex: %1").arg(pattern.errorString()));
+        return;
+    }
+    auto count =
+        model_->replace(pattern, ui_->lineEdit_replace->text(), ui_->listView->selectionModel()->selectedIndexes());
+    ui_->label_status->setText(tr("%n text(s) changed", nullptr, count));
+}
+
+void ListDialog::rename_() {
+    auto pattern = ui_->lineEdit_pattern->text();
+    if (pattern.isEmpty()) {
+        return;
+    }
+    model_->rename(pattern, ui_->listView->selectionModel()->selectedIndexes());
+}
+
+void ListDialog::add_() {
+    auto index = model_->index(model_->append(QString()));
+    ui_->listView->setCurrentIndex(index);
+    ui_->listView->edit(index);
+}
+
+void ListDialog::remove_() { model_->remove(ui_->listView->selectionModel()->selectedIndexes()); }
+
+void ListDialog::set_rows_addable(bool is_addable) {
+    ui_->pushButton_add->setVisible(is_addable);
+    ui_->pushButton_remove->setVisible(is_addable);
+}
+
+void ListDialog::set_icon_size(const QSize &size) { ui_->listView->setIconSize(size); }
+
+void ListDialog::set_icon(int row, const QIcon &icon) { model_->set_decoration(row, icon); }
+
 QStringList ListDialog::get_texts(QWidget *parent, const QString &title, const QString &label, const QStringList &texts,
-                                  bool *ok, Qt::WindowFlags flags, Qt::InputMethodHints input_method_hints) {
+                                  bool *ok, Qt::WindowFlags flags, Qt::InputMethodHints input_method_hints,
+                                  const std::function<void(ListDialog *)> &prepare) {
     ListDialog dialog(parent);
     dialog.setWindowFlags(flags);
     dialog.setInputMethodHints(input_method_hints);
     dialog.setWindowTitle(title);
     dialog.ui_->label->setText(label);
-    dialog.ui_->listWidget->addItems(texts);
-    for (int i = 0; i < dialog.ui_->listWidget->count(); i++) {
-        dialog.ui_->listWidget->item(i)->setFlags(Qt::ItemIsEditable | Qt::ItemIsEnabled);
+    dialog.set_texts_(texts);
+    if (prepare) {
+        prepare(&dialog);
     }
     QStringList result;
     switch (dialog.exec()) {
         case QDialog::Accepted:
             *ok = true;
-            for (int i = 0; i < dialog.ui_->listWidget->count(); i++) {
-                result << dialog.ui_->listWidget->item(i)->text();
-            }
+            result = dialog.model_->texts();
             break;
         case QDialog::Rejected:
             *ok = false;
@@ -2,11 +2,15 @@
 #define LISTDIALOG_H
 
 #include <QDialog>
+#include <QIcon>
+#include <QSize>
 #include <QStringList>
+#include <functional>
 
 namespace Ui {
 class ListDialog;
 }
+class TextListModel;
 
 class ListDialog : public QDialog {
     Q_OBJECT
@@ -15,12 +19,30 @@ class ListDialog : public QDialog {
     explicit ListDialog(QWidget *parent = nullptr);
     ~ListDialog();
 
+    /**
+     * @param prepare called with the dialog before it is shown. e.g. to set icons, also while it is shown
+     */
     static QStringList get_texts(QWidget *parent, const QString &title, const QString &label, const QStringList &texts,
                                  bool *ok = nullptr, Qt::WindowFlags flags = Qt::WindowFlags(),
-                                 Qt::InputMethodHints input_method_hints = Qt::ImhNone);
+                                 Qt::InputMethodHints input_method_hints = Qt::ImhNone,
+                                 const std::function<void(ListDialog *)> &prepare = {});
+    void set_icon_size(const QSize &size);
+    void set_icon(int row, const QIcon &icon);
+    /**
+     * @brief show buttons which add an empty row and remove selected rows. hidden by default, e.g. for chapter names
+     * whose count is fixed
+     */
+    void set_rows_addable(bool is_addable);
 
    private:
     Ui::ListDialog *ui_;
+    TextListModel *model_ = nullptr;  // deleted when this(ListDialog) is deleted
+
+    void set_texts_(const QStringList &texts);
+    void replace_();
+    void rename_();
+    void add_();
+    void remove_();
 };
 
 #endif  // LISTDIALOG_H
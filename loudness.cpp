@@ -0,0 +1,95 @@
+#include "loudness.hpp"
+
+#include <QRegularExpression>
+#include <algorithm>
+#include <ciso646>
+#include <cmath>
+
+namespace concat {
+namespace {
+// ebur128 reports this for inputs which are silent as a whole
+constexpr double SILENCE = -70;
+// gains smaller than this are not audible
+constexpr double NEGLIGIBLE_GAIN = 0.1;
+QString format_seconds(double seconds) { return QString::number(seconds, 'f', 6); }
+}  // namespace
+QStringList loudness_probe_arguments(const QString &path, std::optional<double> start,
+                                     std::optional<double> duration) {
+    QStringList result;
+    result << "-hide_banner" << "-nostats" << "-nostdin";
+    if (start.has_value()) {
+        // -seek_timestamp makes -ss a timestamp of the source, in which cuts are expressed
+        result << "-seek_timestamp" << "1" << "-ss" << format_seconds(start.value());
+    }
+    if (duration.has_value()) {
+        result << "-t" << format_seconds(duration.value());
+    }
+    // clang-format off
+    result << "-i" << path
+           << "-map" << "0:a:0"
+           << "-af" << "ebur128=framelog=quiet"
+           << "-f" << "null"
+           << "-";
+    // clang-format on
+    return result;
+}
+std::optional<double> parse_integrated_loudness(const QString &log) {
+    // the summary is the last "I:" in the log. lines of each frame are not written with framelog=quiet
+    static const QRegularExpression INTEGRATED(R"(Integrated loudness:\s*I:\s*(-?[0-9.]+|-inf)\s*LUFS)");
+    auto summary = log.lastIndexOf("Summary:");
+    auto match = INTEGRATED.match(log, std::max(summary, 0));
+    if (not match.hasMatch()) {
+        return std::nullopt;
+    }
+    auto text = match.captured(1);
+    return text == "-inf" ? SILENCE : text.toDouble();
+}
+QVector<double> loudness_gains(const QVector<MeasuredLoudness> &inputs, double target, bool per_input) {
+    auto is_audible = [](const MeasuredLoudness &input) {
+        return input.integrated.has_value() && input.integrated.value() > SILENCE;
+    };
+    auto clamp = [](double gain) { return std::clamp(gain, -MAX_LOUDNESS_GAIN, MAX_LOUDNESS_GAIN); };
+    QVector<double> result;
+    if (per_input) {
+        for (const auto &input : inputs) {
+            result << (is_audible(input) ? clamp(target - input.integrated.value()) : 0.0);
+        }
+        return result;
+    }
+    double energy = 0;
+    double duration = 0;
+    for (const auto &input : inputs) {
+        if (is_audible(input)) {
+            energy += input.duration * std::pow(10, input.integrated.value() / 10);
+            duration += input.duration;
+        }
+    }
+    auto gain = duration > 0 ? clamp(target - 10 * std::log10(energy / duration)) : 0.0;
+    for (const auto &input : inputs) {
+        result << (is_audible(input) ? gain : 0.0);
+    }
+    return result;
+}
+QString loudness_filter(const QVector<double> &gains, const QVector<double> &durations) {
+    if (std::all_of(gains.begin(), gains.end(), [](double gain) { return std::abs(gain) < NEGLIGIBLE_GAIN; })) {
+        return {};
+    }
+    auto factor_of = [](double gain) { return QString::number(std::pow(10, gain / 20), 'g', 6); };
+    // if(lt(t,end0),factor0,if(lt(t,end1),factor1,...factorN))
+    QString expression = factor_of(gains.isEmpty() ? 0.0 : gains.back());
+    double end = 0;
+    QVector<double> ends;
+    for (auto i = 0; i < gains.size() && i < durations.size(); i++) {
+        end += durations[i];
+        ends << end;
+    }
+    for (auto i = static_cast<int>(ends.size()) - 2; i >= 0; i--) {
+        expression = QStringLiteral("if(lt(t,%1),%2,%3)").arg(format_seconds(ends[i]), factor_of(gains[i]), expression);
+    }
+    auto result = QStringLiteral("volume='%1':eval=frame").arg(expression);
+    if (std::any_of(gains.begin(), gains.end(), [](double gain) { return gain >= NEGLIGIBLE_GAIN; })) {
+        result += ",alimiter=limit=0.891251:level=disabled";  // -1 dBFS
+    }
+    return result;
+}
+}  // namespace concat
@@ -0,0 +1,44 @@
+#ifndef VIDEO_CONCATENATER_LOUDNESS
+#define VIDEO_CONCATENATER_LOUDNESS
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <optional>
+
+namespace concat {
+/**
+ * @brief arguments of ffmpeg which measure integrated loudness (EBU R128) of the first audio stream
+ * @details Only audio is decoded. The result is printed to stderr, which parse_integrated_loudness() reads.
+ * @param start timestamp of the source in seconds. whole file is measured if std::nullopt
+ * @param duration seconds from start. measured to the end if std::nullopt
+ */
+QStringList loudness_probe_arguments(const QString &path, std::optional<double> start = std::nullopt,
+                                     std::optional<double> duration = std::nullopt);
+/**
+ * @return integrated loudness in LUFS
+ * @retval std::nullopt summary of ebur128 is not found
+ */
+std::optional<double> parse_integrated_loudness(const QString &log);
+struct MeasuredLoudness {
+    double duration;                    // seconds on the output timeline
+    std::optional<double> integrated;   // LUFS. std::nullopt if not measured
+};
+/**
+ * @brief gain of each input in dB
+ * @details If per_input is true, every input is brought to target on its own. Otherwise one gain brings the whole
+ * output to target and keeps the balance between inputs. The loudness of the whole output is estimated from the
+ * duration-weighted energy of the inputs, which is close to a measurement of it unless inputs are mostly silent.
+ * Inputs which are not measured or silent get 0 dB, and gains are limited to MAX_LOUDNESS_GAIN.
+ */
+QVector<double> loudness_gains(const QVector<MeasuredLoudness> &inputs, double target, bool per_input);
+constexpr double MAX_LOUDNESS_GAIN = 20;  // dB
+/**
+ * @brief audio filter which applies gains[i] while inputs[i] plays on the concatenated timeline
+ * @details Gains switch at frame boundaries of the decoded audio. A limiter follows if any gain is positive, so
+ * that amplified peaks do not clip.
+ * @retval "" no input needs a gain
+ */
+QString loudness_filter(const QVector<double> &gains, const QVector<double> &durations);
+}  // namespace concat
+#endif
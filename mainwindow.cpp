@@ -5,7 +5,9 @@
 #include <fmt/core.h>
 #include <fmt/ranges.h>
 
+#include <QAbstractButton>
 #include <QApplication>
+#include <QCryptographicHash>
 #include <QDataStream>
 #include <QDebug>
 #include <QDir>
@@ -13,39 +15,64 @@
 #include <QFileDialog>
 #include <QFileInfo>
 #include <QGridLayout>
+#include <QHeaderView>
+#include <QIcon>
 #include <QHBoxLayout>
 #include <QInputDialog>
 #include <QJsonArray>
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QLabel>
-#include <QListWidget>
+#include <QLocale>
 #include <QMessageBox>
 #include <QMetaEnum>
 #include <QPair>
 #include <QPushButton>
 #include <QRegularExpression>
+#include <QSaveFile>
 #include <QStandardPaths>
+#include <QStorageInfo>
 #include <QStringList>
 #include <QTextStream>
+#include <QThreadPool>
 #include <QTime>
 #include <QUrl>
 #include <QVBoxLayout>
 #include <QVector>
+#include <algorithm>
 #include <chrono>
 #include <ciso646>
+#include <cmath>
 #include <cuchar>
 #include <filesystem>
 #include <functional>
 #include <iomanip>
+#include <memory>
 #include <sstream>
 #include <stdexcept>
 #include <string>
 #include <timedialog.hpp>
 
 #include "./ui_mainwindow.h"
+#include "chapterdetect.hpp"
+#include "chaptersplit.hpp"
+#include "concatlist.hpp"
+#include "copysafety.hpp"
 #include "listdialog.hpp"
+#include "loudness.hpp"
+#include "manifest.hpp"
+#include "metrics.hpp"
+#include "mp4box.hpp"
+#include "placement.hpp"
+#include "preflight.hpp"
+#include "previewwidget.hpp"
 #include "processwidget.hpp"
+#include "rendition.hpp"
+#include "staging.hpp"
+#include "thumbnailprovider.hpp"
+#include "transcodecache.hpp"
+#include "tsjoin.hpp"
+#include "validation.hpp"
 #include "videoinfodialog.hpp"
 #include "videoinfowidget.hpp"
 
@@ -70,6 +97,9 @@ concat::VideoInfo retrieve_input_info(const concat::VideoInfo &info) {
     return result;
 }
 constexpr auto INITIAL_ANIMATION_DURATION = 200;
+constexpr std::chrono::seconds METRICS_INTERVAL{15};
+// seconds. steps range from a dialog answered at once to an encode of hours
+const QVector<double> DURATION_BUCKETS{0.1, 0.5, 1, 5, 15, 60, 300, 900, 3600, 14400};
 }  // namespace
 MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent), ui_(new Ui::MainWindow) {
     ui_->setupUi(this);
@@ -77,7 +107,27 @@ MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent), ui_(new Ui::MainW
     this->setWindowTitle(QStringLiteral("%1 (debug build)").arg(this->windowTitle()));
 #endif
 
+    input_files_ = new InputFileModel(this);
+    thumbnails_ = new ThumbnailProvider(
+        QDir(QStandardPaths::writableLocation(QStandardPaths::CacheLocation)).filePath("thumbnails"), this);
+    input_files_->set_thumbnail_provider(thumbnails_);
+    input_files_proxy_ = new InputFileProxyModel(this);
+    input_files_proxy_->setSourceModel(input_files_);
+    input_files_proxy_->setFilterKeyColumn(InputFileModel::PATH);
+    input_files_proxy_->setFilterCaseSensitivity(Qt::CaseInsensitive);
+    ui_->tableView_filenames->setModel(input_files_proxy_);
+    ui_->tableView_filenames->verticalHeader()->setDefaultSectionSize(
+        ui_->tableView_filenames->fontMetrics().height() + 4);  // fixed height keeps scrolling cheap at 10k rows
+    ui_->tableView_filenames->verticalHeader()->setSectionResizeMode(QHeaderView::Fixed);
+    ui_->tableView_filenames->horizontalHeader()->setSectionResizeMode(InputFileModel::PATH, QHeaderView::Interactive);
+    ui_->tableView_filenames->setColumnWidth(InputFileModel::PATH, 320);
+
+    connect(ui_->lineEdit_filter, &QLineEdit::textChanged, input_files_proxy_,
+            &QSortFilterProxyModel::setFilterFixedString);
+    connect(ui_->pushButton_clear, &QPushButton::clicked, input_files_, &InputFileModel::clear);
     connect(ui_->actionopen, &QAction::triggered, this, &MainWindow::open_video_);
+    connect(ui_->actionsplit_by_chapters, &QAction::triggered, this, &MainWindow::split_by_chapters_);
+    connect(ui_->actionpreview, &QAction::triggered, this, &MainWindow::open_preview_);
     connect(ui_->pushButton_save, &QPushButton::pressed, this, &MainWindow::save_result_);
     connect(ui_->actiondefault_extractor, &QAction::triggered, this, &MainWindow::select_default_chaptername_plugin_);
     connect(ui_->actionsavefile_name_generator, &QAction::triggered, this, &MainWindow::select_savefile_name_plugin_);
@@ -86,6 +136,17 @@ MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent), ui_(new Ui::MainW
     connect(ui_->actiondefault_video_info, &QAction::triggered, this, &MainWindow::edit_default_video_info_);
     connect(ui_->actionanimation_duration_of_collapsible_section, &QAction::triggered, this,
             &MainWindow::update_animation_duration);
+    connect(ui_->actionfragmented_output, &QAction::toggled, this,
+            [this](bool checked) { this->settings_->setValue("fragmented_output", checked); });
+    connect(ui_->actionbackup_destinations, &QAction::triggered, this, &MainWindow::edit_backup_destinations_);
+    connect(ui_->actiontranscode_cache_size, &QAction::triggered, this, &MainWindow::update_transcode_cache_size_);
+    connect(ui_->actionstaging_directory, &QAction::triggered, this, &MainWindow::edit_staging_directory_);
+    connect(ui_->actiontrace_directory, &QAction::triggered, this, &MainWindow::edit_trace_directory_);
+    connect(ui_->actionmetrics_file, &QAction::triggered, this, &MainWindow::edit_metrics_file_);
+    connect(ui_->actionwrite_manifest, &QAction::toggled, this,
+            [this](bool checked) { this->settings_->setValue("write_manifest", checked); });
+    connect(ui_->actiondetect_chapters, &QAction::toggled, this,
+            [this](bool checked) { this->settings_->setValue("detect_chapters", checked); });
     QDir settings_dir(QApplication::applicationDirPath() + "/settings");
     if (QDir().mkpath(settings_dir.absolutePath())) {  // QDir::mkpath() returns true even when path already exists
         settings_ = new QSettings(settings_dir.filePath("settings.ini"), QSettings::IniFormat);
@@ -102,9 +163,18 @@ MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent), ui_(new Ui::MainW
         auto default_video_info = settings_->value("default_video_info").value<concat::VideoInfo>();
         video_info_widget_->set_infos(default_video_info, retrieve_input_info(default_video_info));
     }
+    ui_->actionfragmented_output->setChecked(settings_->value("fragmented_output", false).toBool());
+    ui_->actionwrite_manifest->setChecked(settings_->value("write_manifest", false).toBool());
+    ui_->actiondetect_chapters->setChecked(settings_->value("detect_chapters", false).toBool());
+    describe_metrics_();
+    metrics_timer_ = new QTimer(this);
+    connect(metrics_timer_, &QTimer::timeout, this, &MainWindow::write_metrics_);
+    metrics_timer_->start(METRICS_INTERVAL);
 }
 
 MainWindow::~MainWindow() {
+    disconnect(job_.window_closed);  // the process window is deleted after this(MainWindow)
+    finish_job_("abandoned");        // a save still running
     delete ui_;
     if (settings_ != nullptr) {
         settings_->deleteLater();
@@ -112,6 +182,8 @@ MainWindow::~MainWindow() {
     if (tmpdir_ != nullptr) {
         delete tmpdir_;
     }
+    staging_.stager.reset();  // readers are joined before their directory is removed
+    delete staging_.dir;
 }
 QUrl MainWindow::read_video_dir_cache_() {
     settings_->beginGroup("video_dir_cache");
@@ -141,6 +213,63 @@ void MainWindow::update_effective_period_of_cache_() {
     }
 }
 
+void MainWindow::update_transcode_cache_size_() {
+    bool confirmed = false;
+    auto size = QInputDialog::getInt(
+        nullptr, tr("transcode cache"),
+        tr("enter maximum size of transcode cache in MiB (0 disables it)\ncache directory: %1")
+            .arg(transcode_cache_directory_()),
+        settings_->value("transcode_cache/max_size", 0).toInt(), 0, INT_MAX, 1024, &confirmed);
+    if (confirmed) {
+        settings_->setValue("transcode_cache/max_size", size);
+    }
+}
+void MainWindow::edit_staging_directory_() {
+    bool confirmed = false;
+    auto directory = QInputDialog::getText(
+        nullptr, tr("staging directory"),
+        tr("directory on a local disk where inputs on other filesystems are copied before being read\n"
+           "(empty disables staging)"),
+        QLineEdit::Normal, settings_->value("staging/directory").toString(), &confirmed);
+    if (confirmed) {
+        settings_->setValue("staging/directory", directory.trimmed());
+    }
+}
+void MainWindow::edit_trace_directory_() {
+    bool confirmed = false;
+    auto directory = QInputDialog::getText(
+        nullptr, tr("trace directory"),
+        tr("directory where a Chrome trace (loadable in Perfetto) of each save is written\n(empty disables tracing)"),
+        QLineEdit::Normal, settings_->value("trace/directory").toString(), &confirmed);
+    if (confirmed) {
+        settings_->setValue("trace/directory", directory.trimmed());
+    }
+}
+void MainWindow::edit_metrics_file_() {
+    bool confirmed = false;
+    auto path = QInputDialog::getText(
+        nullptr, tr("metrics file"),
+        tr("*.prom file in the textfile collector directory of node_exporter, rewritten every %1 seconds\n"
+           "(empty disables metrics)")
+            .arg(METRICS_INTERVAL.count()),
+        QLineEdit::Normal, settings_->value("metrics/textfile").toString(), &confirmed);
+    if (confirmed) {
+        settings_->setValue("metrics/textfile", path.trimmed());
+        write_metrics_();
+    }
+}
+void MainWindow::edit_backup_destinations_() {
+    bool confirmed = false;
+    auto directories = ListDialog::get_texts(nullptr, tr("backup destinations"),
+                                             tr("directories where a copy of each result is written"),
+                                             settings_->value("backup_destinations").toStringList(), &confirmed,
+                                             Qt::WindowFlags(), Qt::ImhNone,
+                                             [](ListDialog *dialog) { dialog->set_rows_addable(true); });
+    if (confirmed) {
+        directories.removeAll(QString());
+        settings_->setValue("backup_destinations", directories);
+    }
+}
 void MainWindow::update_animation_duration() {
     bool confirmed = false;
     auto period = QInputDialog::getInt(
@@ -171,7 +300,7 @@ void MainWindow::open_video_() {
         videodir = QUrl::fromLocalFile(videodirs[0]);
     }
     auto filenames =
-        QFileDialog::getOpenFileNames(this, tr("open video file"), videodir.toLocalFile(), tr("Videos (*.mp4)"));
+        QFileDialog::getOpenFileNames(this, tr("open video file"), videodir.toLocalFile(), tr("Videos (*.mp4 *.ts)"));
     if (filenames.isEmpty()) {
         QMessageBox::warning(nullptr, tr("warning"), tr("no file was selected"));
         return;
@@ -179,7 +308,7 @@ void MainWindow::open_video_() {
     QDir filepath{filenames[0]};
     filepath.cdUp();
     write_video_dir_cache_(QUrl::fromLocalFile(filepath.path()));
-    ui_->listWidget_filenames->addItems(filenames);
+    input_files_->add_files(filenames);
     ui_->pushButton_save->setEnabled(true);
 }
 namespace impl_ {
@@ -196,7 +325,7 @@ class OnTrue {
         }
     }
 };
-constexpr auto INVALID_SIZE = static_cast<std::uintmax_t>(-1);
+constexpr auto INVALID_SIZE = concat::PreflightResult::INVALID_SIZE;
 #ifndef __STDC_UTF_16__
 static_assert(false, "encoding of char16_t is not guaranteed to be UTF-16");
 #endif
@@ -232,91 +361,165 @@ QString format_path(std::filesystem::path path) {
         return QString::fromStdU16String(path.u16string());
     }
 }
-}  // namespace impl_
-void MainWindow::show_size_() {
-    namespace fs = std::filesystem;
-    std::uintmax_t tmpdir_available_size = impl_::INVALID_SIZE;
-    fs::path tmpdir{};
-    std::uintmax_t dstdir_available_size = impl_::INVALID_SIZE;
-    fs::path dstdir{};
-    std::uintmax_t estimated_result_size = impl_::INVALID_SIZE;
-    bool error_has_ocurred = false;
-    auto on_error = [&error_has_ocurred](std::exception &e) {
-        QMessageBox::critical(nullptr, tr("error"), QString::fromLocal8Bit(e.what()));
-        error_has_ocurred = true;
-    };
-    try {
-        tmpdir = fs::canonical(tmpdir_->path().toStdU16String());
-        auto tmpdir_size = fs::space(tmpdir).available;
-        if (tmpdir_size != static_cast<std::uintmax_t>(-1)) {
-            tmpdir_available_size = tmpdir_size;
-        }
-    } catch (std::exception &e) {
-        on_error(e);
+std::vector<std::filesystem::path> to_paths(const QStringList &paths) {
+    std::vector<std::filesystem::path> result;
+    for (const auto &path : paths) {
+        result.push_back(path.toStdU16String());
     }
-    for (auto i = 0; i < ui_->listWidget_filenames->count(); i++) {
-        fs::path filepath{};
-        try {
-            filepath = ui_->listWidget_filenames->item(i)->text().toStdU16String();
-            filepath = fs::canonical(filepath);
-        } catch (std::exception &e) {
-            on_error(e);
-            continue;  // 以下の処理はfilepathに依存する
-        }
-        if (i == 0) {
-            try {
-                dstdir = filepath.parent_path();
-                auto dstdir_size = fs::space(dstdir).available;
-                if (dstdir_size != static_cast<std::uintmax_t>(-1)) {
-                    dstdir_available_size = dstdir_size;
-                }
-            } catch (std::exception &e) {
-                on_error(e);
-            }
-        }
-        try {
-            auto size = fs::file_size(filepath);
-            if (estimated_result_size == impl_::INVALID_SIZE) {
-                estimated_result_size = size;
-            } else {
-                estimated_result_size += size;
-            }
-        } catch (std::exception &e) {
-            on_error(e);
-        }
+    return result;
+}
+QString format_wall_time(std::chrono::duration<double> wall_time) {
+    auto total_seconds = static_cast<qint64>(wall_time.count());
+    return QObject::tr("%1h%2m%3s")
+        .arg(total_seconds / 3600)
+        .arg(total_seconds / 60 % 60, 2, 10, QChar('0'))
+        .arg(total_seconds % 60, 2, 10, QChar('0'));
+}
+QString format_sample_estimate(const std::optional<SampleEstimator::Estimate> &maybe_estimate, bool is_running) {
+    QString message;
+    message += "<h2>" + MainWindow::tr("sample encoding") + "</h2>";
+    message += "<p>";
+    if (is_running) {
+        message += MainWindow::tr("encoding samples...");
+    } else if (not maybe_estimate.has_value()) {
+        message += MainWindow::tr("not needed (streams are copied) or durations are unknown");
+    } else if (maybe_estimate->sample_count == 0) {
+        message += MainWindow::tr("failed to encode samples") + "<br>" + maybe_estimate->errors.join("<br>");
+    } else {
+        message += MainWindow::tr("estimated result size: %1").arg(format_size(maybe_estimate->size)) + "<br>";
+        message += MainWindow::tr("estimated wall time: %1").arg(format_wall_time(maybe_estimate->wall_time)) + "<br>";
+        message += MainWindow::tr("(from %n sample(s))", nullptr, maybe_estimate->sample_count);
     }
+    message += "</p>";
+    return message;
+}
+QString format_preflight_result(const std::optional<concat::PreflightResult> &maybe_result) {
     QString message;
-    message += "<h1>" + tr("size informations") + "</h1>";
-    message += "<b>";
-    message += tr("when videos are re-encoded(e.g. when video-codec is changed), estimation will be inaccurate.");
-    message += "</b>";
+    message += "<h1>" + MainWindow::tr("size informations") + "</h1>";
+    if (not maybe_result.has_value()) {
+        message += "<p>" + MainWindow::tr("checking sizes and available spaces...") + "</p>";
+        return message;
+    }
+    const auto &result = maybe_result.value();
+    if (not result.is_estimated_from_bitrate) {
+        message += "<b>";
+        message += MainWindow::tr(
+            "when videos are re-encoded(e.g. when video-codec is changed), estimation will be inaccurate.");
+        message += "</b>";
+    }
     message += "<p>";
-    message += (error_has_ocurred ? tr("warning: some error has ocurred. result may be incorrect")
-                                  : tr("no error has ocurred"));
+    message += (result.errors.isEmpty() ? MainWindow::tr("no error has ocurred")
+                                        : MainWindow::tr("warning: some error has ocurred. result may be incorrect") +
+                                              "<br>" + result.errors.join("<br>"));
     message += "</p>";
-    message += "<h2>" + tr("necessary space") + "</h2>";
+    message += "<h2>" + MainWindow::tr("necessary space") + "</h2>";
     message += "<p>";
-    message += tr("estimated result size: %1").arg(impl_::format_size(estimated_result_size)) + "<br>";
-    message += tr("(2*estimated result size: %1)").arg(impl_::format_size(2 * estimated_result_size));
+    message += MainWindow::tr("estimated result size: %1").arg(format_size(result.estimated_result_size));
+    if (result.is_estimated_from_bitrate) {
+        message += " " + MainWindow::tr("(duration x target bitrate)");
+    }
+    message += "<br>";
+    if (result.estimated_rendition_size == 0) {
+        message += MainWindow::tr("(2*estimated result size: %1)").arg(format_size(2 * result.estimated_result_size));
+    } else {
+        auto total_size =
+            result.estimated_result_size == INVALID_SIZE || result.estimated_rendition_size == INVALID_SIZE
+                ? INVALID_SIZE
+                : result.estimated_result_size + result.estimated_rendition_size;
+        message += MainWindow::tr("estimated size of renditions: %1").arg(format_size(result.estimated_rendition_size));
+        message += "<br>";
+        message += MainWindow::tr("(2*(estimated result size + renditions): %1)")
+                       .arg(format_size(total_size == INVALID_SIZE ? INVALID_SIZE : 2 * total_size));
+    }
     message += "</p>";
-    message += "<h2>" + tr("available space") + "</h2>";
+    message += "<h2>" + MainWindow::tr("available space") + "</h2>";
     message += "<p>";
-    message += tr("%1: %2").arg(impl_::format_path(tmpdir)).arg(impl_::format_size(tmpdir_available_size)) + "<br>";
-    message += tr("%1: %2").arg(impl_::format_path(dstdir)).arg(impl_::format_size(dstdir_available_size));
+    message += MainWindow::tr("%1: %2").arg(format_path(result.tmpdir)).arg(format_size(result.tmpdir_available_size)) +
+               "<br>";
+    message += MainWindow::tr("%1: %2").arg(format_path(result.dstdir)).arg(format_size(result.dstdir_available_size));
     message += "</p>";
-    message += "<p>" + tr("do you want to proceed?") + "</p>";
-    switch (QMessageBox::question(nullptr, "size info", message)) {
-        case QMessageBox::Yes:
-            create_savefile_name_();
-            break;
-        case QMessageBox::No:
-            break;
-        default:
-            Q_UNREACHABLE();
+    return message;
+}
+}  // namespace impl_
+void MainWindow::show_size_() {
+    enter_step_(__func__);
+    QVector<concat::PreflightInput> inputs;
+    QVector<SampleEstimator::Input> sample_inputs;
+    for (auto i = 0; i < input_files_->rowCount(); i++) {
+        const auto &entry = input_files_->entry(i);
+        std::optional<std::uintmax_t> size = std::nullopt;
+        if (entry.size.has_value()) {
+            size = entry.size.value();
+        }
+        inputs.push_back({entry.path, size, entry.duration});
+        if (entry.duration.has_value()) {
+            sample_inputs.push_back({entry.path, entry.duration.value()});
+        }
     }
+    auto output_info = output_video_info_;
+    // the same comparison as the actual encode decides whether anything is encoded
+    auto changes = output_changes_();
+    changes.audio_codec = changes.audio_codec || output_info.loudness_target != 0;
+    // copied video keeps the size of inputs, whatever "-b:v" says
+    auto bitrate = changes.video_codec || changes.resolution ? concat::target_bitrate(output_info) : std::nullopt;
+    auto tmpdir = tmpdir_->path();
+
+    preflight_result_ = std::nullopt;
+    sample_estimate_ = std::nullopt;
+    delete sample_estimator_;
+    sample_estimator_ = new SampleEstimator(tmpdir_->filePath("samples"), this);
+    connect(sample_estimator_, &SampleEstimator::finished, this, [this](const SampleEstimator::Estimate &estimate) {
+        this->sample_estimate_ = estimate;
+        this->update_preflight_box_();
+    });
+    if (changes.any() && sample_inputs.size() == inputs.size()) {
+        sample_estimator_->start(sample_inputs, output_info.input_file_args,
+                                 codec_arguments_(changes) + output_info.encoding_args);
+    }
+
+    // filesystem may be slow (e.g. network mounts), so the question is shown first and updated when checks finish
+    preflight_box_ = new QMessageBox(QMessageBox::Question, tr("size info"), QString(),
+                                     QMessageBox::Yes | QMessageBox::No, process_);
+    preflight_box_->setAttribute(Qt::WA_DeleteOnClose, true);
+    preflight_box_->setWindowModality(Qt::WindowModal);
+    connect(preflight_box_, &QMessageBox::buttonClicked, this, [this](QAbstractButton *button) {
+        this->sample_estimator_->cancel();  // samples would compete with actual encoding
+        if (this->preflight_box_->standardButton(button) == QMessageBox::Yes) {
+            this->measure_loudness_();
+        } else {
+            this->process_->finish();  // inputs are already probed, so the window is left closable
+        }
+    });
+    update_preflight_box_();
+    preflight_box_->open();
+    QVector<concat::PreflightRendition> renditions;
+    if (has_renditions_()) {
+        for (const auto &rendition : output_info.renditions) {
+            renditions.push_back({rendition.video_codec.isEmpty(), concat::target_bitrate(rendition.encoding_args)});
+        }
+    }
+    QThreadPool::globalInstance()->start([this, tmpdir, inputs, bitrate, renditions] {
+        auto result = concat::run_preflight(tmpdir, inputs, bitrate, renditions);
+        QMetaObject::invokeMethod(
+            this,
+            [this, result] {
+                this->preflight_result_ = result;
+                this->update_preflight_box_();
+            },
+            Qt::QueuedConnection);
+    });
+}
+void MainWindow::update_preflight_box_() {
+    if (preflight_box_.isNull()) {
+        return;
+    }
+    preflight_box_->setText(impl_::format_preflight_result(preflight_result_) +
+                            impl_::format_sample_estimate(sample_estimate_, sample_estimator_->is_running()) + "<p>" +
+                            tr("do you want to proceed?") + "</p>");
 }
 void MainWindow::create_savefile_name_() {
-    QString filename = QUrl::fromLocalFile(ui_->listWidget_filenames->item(current_index_)->text()).fileName();
+    enter_step_(__func__);
+    QString filename = QUrl::fromLocalFile(input_files_->path(current_index_)).fileName();
     if (settings_->contains("savefile_name_plugin") && settings_->value("savefile_name_plugin") != NO_PLUGIN) {
         process_->start(
             PYTHON,
@@ -330,7 +533,8 @@ void MainWindow::create_savefile_name_() {
     }
 }
 void MainWindow::confirm_savefile_name_() {
-    auto source_filepath = QUrl::fromLocalFile(ui_->listWidget_filenames->item(0)->text());
+    enter_step_(__func__);
+    auto source_filepath = QUrl::fromLocalFile(input_files_->path(0));
     QString default_savefile_name = source_filepath.fileName();
     if (settings_->contains("savefile_name_plugin") && settings_->value("savefile_name_plugin") != NO_PLUGIN) {
         default_savefile_name = process_->get_stdout();
@@ -352,11 +556,22 @@ void MainWindow::confirm_savefile_name_() {
                 return;
             }
         } else if (save_filename == source_filepath.fileName() || QFile::exists(save_filepath.toLocalFile())) {
-            auto button =
-                QMessageBox::warning(this, tr("overwrite source"),
-                                     tr("provided filename already exists. Are you sure you want to OVERWRITE it?"),
-                                     QMessageBox::Retry | QMessageBox::Abort | QMessageBox::Yes, QMessageBox::Retry);
-            switch (button) {
+            QMessageBox box(QMessageBox::Warning, tr("overwrite source"),
+                            tr("provided filename already exists. Are you sure you want to OVERWRITE it?"),
+                            QMessageBox::Retry | QMessageBox::Abort | QMessageBox::Yes, this);
+            box.setDefaultButton(QMessageBox::Retry);
+            QAbstractButton *append_button = nullptr;
+            if (save_filename != source_filepath.fileName() &&
+                concat::is_fragmented_mp4(save_filepath.toLocalFile().toStdU16String())) {
+                box.setText(box.text() + "\n" + tr("It is a fragmented MP4, so new inputs can be appended to it."));
+                append_button = box.addButton(tr("append"), QMessageBox::AcceptRole);
+            }
+            box.exec();
+            if (append_button != nullptr && box.clickedButton() == append_button) {
+                append_mode_ = true;
+                break;
+            }
+            switch (box.standardButton(box.clickedButton())) {
                 case QMessageBox::Retry:
                     save_filename = "";
                     break;
@@ -375,6 +590,7 @@ void MainWindow::confirm_savefile_name_() {
     confirm_chaptername_plugin_();
 }
 void MainWindow::confirm_chaptername_plugin_() {
+    enter_step_(__func__);
     QDir plugin_dir = chaptername_plugins_dir_();
     QString plugin = NO_PLUGIN;
     bool confirmed;
@@ -394,15 +610,24 @@ void MainWindow::confirm_chaptername_plugin_() {
     probe_for_duration_();
 }
 void MainWindow::probe_for_duration_() {
-    QStringList ffprobe_arguments{"-hide_banner", "-show_streams", "-show_format", "-of", "json", "-v", "quiet"};
-    QString filename = ui_->listWidget_filenames->item(current_index_)->text();
+    enter_step_(__func__, current_index_);
+    const auto &entry = input_files_->entry(current_index_);
+    if (entry.state == InputFileModel::Entry::State::DONE) {  // already probed in background
+        metrics_.increment("video_concatenater_probe_cache_requests_total", {{"result", "hit"}});
+        register_probe_result_(entry.probe);
+        return;
+    }
+    metrics_.increment("video_concatenater_probe_cache_requests_total", {{"result", "miss"}});
+    QStringList ffprobe_arguments{"-hide_banner", "-show_streams",   "-show_format", "-show_data_hash",
+                                  "MD5",          "-show_chapters", "-of",          "json",
+                                  "-v",           "quiet"};
+    QString filename = input_files_->path(current_index_);
     process_->start("ffprobe", ffprobe_arguments + QStringList{filename}, false);
     connect(process_, &ProcessWidget::finished, this, impl_::OnTrue([=] { this->register_duration_(); }),
             impl_::ONESHOT_AUTO_CONNECTION);
 }
 void MainWindow::register_duration_() {
-    QString filepath = ui_->listWidget_filenames->item(current_index_)->text();
-    QRegularExpression fraction_pattern(R"((\d+)/(\d+))");
+    enter_step_(__func__, current_index_);
     QJsonParseError err;
     auto prove_result = QJsonDocument::fromJson(process_->get_stdout().toUtf8(), &err);
     if (prove_result.isNull()) {
@@ -410,7 +635,12 @@ void MainWindow::register_duration_() {
                               tr("failed to parse result of ffprobe\nerror message:%1").arg(err.errorString()));
         return;
     }
-    auto duration_str = prove_result.object()["format"].toObject()["duration"].toString();
+    register_probe_result_(prove_result.object());
+}
+void MainWindow::register_probe_result_(const QJsonObject &prove_result) {
+    QString filepath = input_files_->path(current_index_);
+    QRegularExpression fraction_pattern(R"((\d+)/(\d+))");
+    auto duration_str = prove_result["format"].toObject()["duration"].toString();
     bool ok;
     double duration = duration_str.toDouble(&ok);
     if (not ok) {
@@ -418,11 +648,13 @@ void MainWindow::register_duration_() {
         return;
     }
     concat::VideoInfo info{};
+    concat::StreamParams video_stream, audio_stream;
     bool video_found = false, audio_found = false;
-    for (auto stream_value : prove_result.object()["streams"].toArray()) {
+    for (auto stream_value : prove_result["streams"].toArray()) {
         auto stream = stream_value.toObject();
-        if (stream["codec_type"] == "video") {
+        if (stream["codec_type"] == "video" && not video_found) {
             video_found = true;
+            video_stream = concat::StreamParams::from_ffprobe(stream);
             info.video_codec = stream["codec_name"].toString();
             info.resolution = QSize(stream["width"].toInt(), stream["height"].toInt());
             auto match = fraction_pattern.match(stream["r_frame_rate"].toString());
@@ -442,8 +674,9 @@ void MainWindow::register_duration_() {
             }
             info.is_vfr = std::get<double>(info.framerate) != avg_framerate;
             info.video_codec = stream["codec_name"].toString();
-        } else if (stream["codec_type"] == "audio") {
+        } else if (stream["codec_type"] == "audio" && not audio_found) {
             audio_found = true;
+            audio_stream = concat::StreamParams::from_ffprobe(stream);
             info.audio_codec = stream["codec_name"].toString();
         }
     }
@@ -455,10 +688,72 @@ void MainWindow::register_duration_() {
         QMessageBox::critical(this, tr("ffprobe parse error"), tr("audio stream was not found"));
         return;
     }
-    current_file_info_ = {filepath, FileInfo::seconds(duration), info, {}};
+    // length on the output timeline is taken from stream timestamps, as duration of container is the longest
+    // stream and makes audio drift away at every join
+    concat::SegmentPlan segment{duration, std::nullopt, std::nullopt};
+    std::optional<concat::SegmentTiming> timing = std::nullopt;
+    auto file_start_str = prove_result["format"].toObject()["start_time"].toString();
+    double file_start = file_start_str.toDouble(&ok);
+    if (ok) {
+        timing = concat::SegmentTiming::from_streams(file_start, video_stream, audio_stream);
+        if (timing.has_value()) {
+            segment = concat::plan_segment(timing.value());
+        }
+    }
+    current_file_info_ = {filepath, FileInfo::seconds(segment.duration), info, video_stream, audio_stream, timing,
+                          segment,  filepath, {}, std::nullopt, {}, {}};
+    const auto &entry = input_files_->entry(current_index_);
+    if (entry.in_point.has_value() || entry.out_point.has_value()) {
+        probe_keyframes_();
+        return;
+    }
     tmpfile_paths_.current_src_metadata = tmpdir_->filePath(QStringLiteral("metadata%1.ini").arg(file_infos_.size()));
     retrieve_metadata_(current_file_info_.path, tmpfile_paths_.current_src_metadata, [=] { this->check_metadata_(); });
 }
+void MainWindow::probe_keyframes_() {
+    enter_step_(__func__, current_index_);
+    const auto &entry = input_files_->entry(current_index_);
+    auto start = current_file_info_.timing.has_value() ? current_file_info_.timing->file_start : 0.0;
+    auto end = start + current_file_info_.segment.duration;
+    process_->start("ffprobe",
+                    concat::keyframe_probe_arguments(current_file_info_.path, start + entry.in_point.value_or(0),
+                                                     start + entry.out_point.value_or(end - start)),
+                    false);
+    connect(process_, &ProcessWidget::finished, this, impl_::OnTrue([=] { this->register_keyframes_(); }),
+            impl_::ONESHOT_AUTO_CONNECTION);
+}
+void MainWindow::register_keyframes_() {
+    enter_step_(__func__, current_index_);
+    const auto &entry = input_files_->entry(current_index_);
+    auto &file_info = current_file_info_;
+    auto start = file_info.timing.has_value() ? file_info.timing->file_start : 0.0;
+    auto end = start + file_info.segment.duration;
+    // in/out points of the model are relative to start of file
+    auto to_timestamp = [=](std::optional<double> point) -> std::optional<double> {
+        return point.has_value() ? std::optional<double>(start + point.value()) : std::nullopt;
+    };
+    auto cut = concat::find_cut(concat::parse_keyframes(process_->get_stdout().toUtf8()),
+                                to_timestamp(entry.in_point), to_timestamp(entry.out_point), start, end);
+    file_info.cut = cut;
+    file_info.duration = FileInfo::seconds(cut.out_point - cut.in_point);
+    // the middle is copied with inpoint/outpoint. outpoint of join repair is kept if the end is not trimmed
+    file_info.segment.duration = cut.out_keyframe - cut.in_keyframe;
+    if (entry.in_point.has_value()) {
+        file_info.segment.inpoint = cut.in_keyframe;
+    }
+    if (entry.out_point.has_value()) {
+        file_info.segment.outpoint = cut.out_keyframe;
+    }
+    auto index = file_infos_.size();
+    if (cut.has_head()) {
+        file_info.head_path = tmpdir_->filePath(QStringLiteral("head%1.ts").arg(index));
+    }
+    if (cut.has_tail()) {
+        file_info.tail_path = tmpdir_->filePath(QStringLiteral("tail%1.ts").arg(index));
+    }
+    tmpfile_paths_.current_src_metadata = tmpdir_->filePath(QStringLiteral("metadata%1.ini").arg(index));
+    retrieve_metadata_(file_info.path, tmpfile_paths_.current_src_metadata, [=] { this->check_metadata_(); });
+}
 QVector<MainWindow::FileInfo::ChapterInfo> MainWindow::retrieve_chapters_(QString src_filename) {
     QFile src_file(src_filename);
     if (not src_file.open(QFile::ReadOnly | QFile::Text)) {
@@ -505,6 +800,7 @@ QVector<MainWindow::FileInfo::ChapterInfo> MainWindow::retrieve_chapters_(QStrin
     return result;
 }
 void MainWindow::check_metadata_() {
+    enter_step_(__func__, current_index_);
     decltype(retrieve_chapters_("")) chapters;
     try {
         chapters = retrieve_chapters_(tmpfile_paths_.current_src_metadata);
@@ -512,6 +808,25 @@ void MainWindow::check_metadata_() {
         QMessageBox::critical(this, tr("error"), QString::fromStdString(e.what()));
         return;
     }
+    if (current_file_info_.cut.has_value()) {
+        // move chapters to the trimmed timeline and drop ones outside of it
+        auto start = current_file_info_.timing.has_value() ? current_file_info_.timing->file_start : 0.0;
+        auto shift = current_file_info_.cut->in_point - start;
+        auto length = current_file_info_.duration.count();
+        decltype(chapters) trimmed_chapters;
+        for (auto chapter : chapters) {
+            auto timebase = static_cast<double>(chapter.timebase_numerator) / chapter.timebase_denominator;
+            auto chapter_start = std::max(chapter.start_time * timebase - shift, 0.0);
+            auto chapter_end = std::min(chapter.end_time * timebase - shift, length);
+            if (chapter_end <= chapter_start) {
+                continue;
+            }
+            chapter.start_time = static_cast<qint64>(chapter_start / timebase);
+            chapter.end_time = static_cast<qint64>(chapter_end / timebase);
+            trimmed_chapters << chapter;
+        }
+        chapters = trimmed_chapters;
+    }
     if (chapters.isEmpty()) {
         create_chapter_();
     } else {
@@ -520,28 +835,56 @@ void MainWindow::check_metadata_() {
     }
 }
 void MainWindow::create_chapter_() {
+    enter_step_(__func__, current_index_);
+    auto path = input_files_->path(current_index_);
+    auto detection = chapter_detection_.inputs.constFind(path);
+    if (detection != chapter_detection_.inputs.constEnd() && not detection->boundaries.has_value()) {
+        process_->show_status(tr("detecting chapters of %1").arg(QFileInfo(path).fileName()));
+        chapter_detection_.on_detected = [this] { this->create_chapter_(); };
+        return;
+    }
+    auto length = current_file_info_.duration.count();
+    QVector<double> starts{0};
+    if (detection != chapter_detection_.inputs.constEnd()) {
+        // boundaries are from the start of the file, and the trimmed timeline starts at the in point
+        auto start = current_file_info_.timing.has_value() ? current_file_info_.timing->file_start : 0.0;
+        auto shift = current_file_info_.cut.has_value() ? current_file_info_.cut->in_point - start : 0.0;
+        for (auto boundary : detection->boundaries.value()) {
+            if (boundary - shift > 0 && boundary - shift < length) {
+                starts << boundary - shift;
+            }
+        }
+    }
     using std::chrono::duration_cast;
     using std::chrono::microseconds;
-    current_file_info_.chapters.push_back(
-        {1, 1'000'000, 0, duration_cast<microseconds>(current_file_info_.duration).count(), ""});
-    QString filename = QUrl::fromLocalFile(ui_->listWidget_filenames->item(current_index_)->text()).fileName();
+    for (auto i = 0; i < starts.size(); i++) {
+        auto end = i + 1 < starts.size() ? static_cast<qint64>(starts[i + 1] * 1'000'000)
+                                         : duration_cast<microseconds>(current_file_info_.duration).count();
+        current_file_info_.chapters.push_back({1, 1'000'000, static_cast<qint64>(starts[i] * 1'000'000), end, ""});
+    }
+    QString filename = QUrl::fromLocalFile(path).fileName();
     if (chaptername_plugin_.has_value()) {
-        process_->start(
-            PYTHON,
-            {chaptername_plugin_.value(), filename, QString::number(current_file_info_.duration.count(), 'g', 10)},
-            false);
+        process_->start(PYTHON, {chaptername_plugin_.value(), filename, QString::number(length, 'g', 10)}, false);
         connect(process_, &ProcessWidget::finished, this, impl_::OnTrue([=] { this->register_chapter_title_(); }),
                 impl_::ONESHOT_AUTO_CONNECTION);
     } else {
-        current_file_info_.chapters[0].title = filename;
-        register_file_info_();
+        name_created_chapters_(filename);
     }
 }
 void MainWindow::register_chapter_title_() {
-    current_file_info_.chapters[0].title = process_->get_stdout().remove('\n');
+    enter_step_(__func__, current_index_);
+    name_created_chapters_(process_->get_stdout().remove('\n'));
+}
+void MainWindow::name_created_chapters_(const QString &title) {
+    auto &chapters = current_file_info_.chapters;
+    for (auto i = 0; i < chapters.size(); i++) {
+        // detected chapters are numbered after the title of the file
+        chapters[i].title = chapters.size() == 1 ? title : QStringLiteral("%1 %2").arg(title).arg(i + 1);
+    }
     register_file_info_();
 }
 void MainWindow::register_file_info_() {
+    enter_step_(__func__, current_index_);
     FileInfo::seconds raw_offset(0.0);
     for (const auto &file_info : file_infos_) {
         raw_offset += file_info.duration;
@@ -553,7 +896,7 @@ void MainWindow::register_file_info_() {
         chapter.end_time += offset;
     }
     file_infos_.push_back(current_file_info_);
-    if (current_index_ == ui_->listWidget_filenames->count() - 1) {
+    if (current_index_ == input_files_->rowCount() - 1) {
         confirm_video_info_();
     } else {
         current_index_++;
@@ -561,6 +904,7 @@ void MainWindow::register_file_info_() {
     }
 }
 void MainWindow::confirm_video_info_() {
+    enter_step_(__func__);
     concat::VideoInfo input_info;
     input_info.audio_codec = QSet<QString>{};
     input_info.video_codec = QSet<QString>{};
@@ -619,17 +963,45 @@ void MainWindow::confirm_video_info_() {
     }
 }
 void MainWindow::confirm_chaptername_() {
+    enter_step_(__func__);
     bool confirmed;
     QStringList created_chapternames;
+    QVector<QPair<QString, double>> chapter_frames;  // source and seconds from its start of each chapter
+    FileInfo::seconds offset(0.0);
     for (const auto &file_info : file_infos_) {
+        // chapters are on the concatenated timeline, which starts at the in point of trimmed inputs
+        auto start = file_info.timing.has_value() ? file_info.timing->file_start : 0.0;
+        auto shift = file_info.cut.has_value() ? file_info.cut->in_point - start : 0.0;
         for (const auto &chapter : file_info.chapters) {
             created_chapternames << chapter.title;
+            auto timebase = static_cast<double>(chapter.timebase_numerator) / chapter.timebase_denominator;
+            chapter_frames.push_back({file_info.path, chapter.start_time * timebase - offset.count() + shift});
         }
+        offset += file_info.duration;
     }
+    auto show_thumbnails = [this, chapter_frames](ListDialog *dialog) {
+        dialog->set_icon_size(QSize(ThumbnailProvider::WIDTH / 2, ThumbnailProvider::WIDTH * 9 / 32));
+        for (auto row = 0; row < chapter_frames.size(); row++) {
+            auto thumbnail = this->thumbnails_->request(chapter_frames[row].first, chapter_frames[row].second, this);
+            if (not thumbnail.isEmpty()) {
+                dialog->set_icon(row, QIcon(thumbnail));
+            }
+        }
+        // thumbnails which are not cached arrive while the dialog is shown
+        connect(this->thumbnails_, &ThumbnailProvider::ready, dialog,
+                [=](const QString &path, double time, const QString &thumbnail) {
+                    for (auto row = 0; row < chapter_frames.size(); row++) {
+                        if (chapter_frames[row].first == path && chapter_frames[row].second == time) {
+                            dialog->set_icon(row, QIcon(thumbnail));
+                        }
+                    }
+                });
+    };
     QStringList confirmed_chapternames =
         ListDialog::get_texts(nullptr, tr("confirm chapternames"),
                               tr("Chapter names of result video will be texts below.The texts are editable."),
-                              created_chapternames, &confirmed);
+                              created_chapternames, &confirmed, Qt::WindowFlags(), Qt::ImhNone, show_thumbnails);
+    thumbnails_->cancel_pending(this);  // thumbnails requested for tooltips of the input list are still generated
     if (confirmed) {
         auto confirmed_chaptername_iter = confirmed_chapternames.constBegin();
         for (auto &file_info : file_infos_) {
@@ -638,9 +1010,172 @@ void MainWindow::confirm_chaptername_() {
                 confirmed_chaptername_iter++;
             }
         }
-        concatenate_videos_();
+        if (not(check_chapter_count_() && confirm_extra_outputs_())) {
+            process_->finish();
+            return;
+        }
+        analyze_copy_safety_();
     }
 }
+void MainWindow::analyze_copy_safety_() {
+    enter_step_(__func__);
+    QVector<concat::AnalyzedInput> inputs;
+    for (const auto &file_info : file_infos_) {
+        inputs.push_back({file_info.path, file_info.video_stream, file_info.audio_stream,
+                          not(file_info.head_path.isEmpty() && file_info.tail_path.isEmpty())});
+    }
+    copy_analysis_ = concat::analyze_copy_safety(inputs);
+    process_->add_report(tr("copy analysis"), copy_analysis_.report());
+    QVector<concat::SegmentTiming> timings;
+    QStringList names;
+    for (const auto &file_info : file_infos_) {
+        if (file_info.timing.has_value()) {
+            timings << file_info.timing.value();
+            names << QFileInfo(file_info.path).fileName();
+        }
+    }
+    if (timings.size() == file_infos_.size()) {
+        process_->add_report(tr("join repair"), concat::join_report(timings, names));
+    }
+    // sizes are estimated once the output is confirmed and compared with the inputs
+    show_size_();
+}
+void MainWindow::measure_loudness_() {
+    enter_step_(__func__);
+    loudness_.gains.clear();
+    if (output_video_info_.loudness_target == 0) {
+        current_index_ = 0;
+        render_cut_points_();
+        return;
+    }
+    if (loudness_.pool != nullptr) {  // left by a previous run which failed
+        loudness_.pool->kill_all();
+        loudness_.pool->deleteLater();
+    }
+    loudness_.pool = new ProcessPool(QThread::idealThreadCount(), this);
+    loudness_.integrated = QVector<std::optional<double>>(file_infos_.size());
+    loudness_.finished_count = 0;
+    process_->show_status(tr("measuring loudness of %n input(s)", nullptr, static_cast<int>(file_infos_.size())));
+    for (auto i = 0; i < file_infos_.size(); i++) {
+        const auto &file_info = file_infos_[i];
+        // only the part which is joined is measured
+        std::optional<double> start;
+        std::optional<double> duration;
+        if (file_info.cut.has_value()) {
+            start = file_info.cut->in_point;
+            duration = file_info.duration.count();
+        }
+        loudness_.pool->enqueue(
+            "ffmpeg", concat::loudness_probe_arguments(file_info.path, start, duration),
+            [=](const ProcessPool::Result &result) {
+                if (result.is_success) {  // an input without audio fails, and gets no gain
+                    this->loudness_.integrated[i] =
+                        concat::parse_integrated_loudness(QString::fromUtf8(result.stderr_data));
+                }
+                if (++this->loudness_.finished_count == this->file_infos_.size()) {
+                    this->register_loudness_();
+                }
+            });
+    }
+}
+void MainWindow::register_loudness_() {
+    enter_step_(__func__);
+    loudness_.pool->deleteLater();  // this is called in a callback of it
+    loudness_.pool = nullptr;
+    QVector<concat::MeasuredLoudness> inputs;
+    QVector<double> durations;
+    for (auto i = 0; i < file_infos_.size(); i++) {
+        inputs.push_back({file_infos_[i].duration.count(), loudness_.integrated[i]});
+        durations << file_infos_[i].duration.count();
+    }
+    loudness_.gains = concat::loudness_gains(inputs, output_video_info_.loudness_target,
+                                             output_video_info_.normalizes_each_input);
+    QString report;
+    QTextStream report_stream(&report);
+    report_stream << tr("target: %1 LUFS").arg(output_video_info_.loudness_target) << "\n";
+    for (auto i = 0; i < file_infos_.size(); i++) {
+        auto integrated = loudness_.integrated[i].has_value() ? QString::number(loudness_.integrated[i].value(), 'f', 1)
+                                                              : tr("not measured");
+        report_stream << QFileInfo(file_infos_[i].path).fileName() << ": " << integrated << " LUFS, "
+                      << tr("gain %1 dB").arg(loudness_.gains[i], 0, 'f', 1) << "\n";
+    }
+    if (concat::loudness_filter(loudness_.gains, durations).isEmpty()) {
+        loudness_.gains.clear();  // audio is copied as no input needs a gain
+        report_stream << tr("no gain is needed") << "\n";
+    }
+    process_->add_report(tr("loudness"), report);
+    current_index_ = 0;
+    render_cut_points_();
+}
+void MainWindow::render_cut_points_() {
+    enter_step_(__func__, current_index_);
+    auto next = [=] {
+        if (this->current_index_ == this->file_infos_.size() - 1) {
+            this->current_index_ = 0;
+            this->normalize_inputs_();
+        } else {
+            this->current_index_++;
+            this->render_cut_points_();
+        }
+    };
+    const auto &file_info = file_infos_[current_index_];
+    if (not file_info.cut.has_value()) {
+        next();
+        return;
+    }
+    const auto &cut = file_info.cut.value();
+    auto render_tail = [=] {
+        if (cut.has_tail()) {
+            this->render_part_(file_info, cut.out_keyframe, cut.out_point, file_info.tail_path, next);
+        } else {
+            next();
+        }
+    };
+    if (cut.has_head()) {
+        render_part_(file_info, cut.in_point, cut.in_keyframe, file_info.head_path, render_tail);
+    } else {
+        render_tail();
+    }
+}
+void MainWindow::remux_to_annexb_() {
+    enter_step_(__func__, current_index_);
+    auto &file_info = file_infos_[current_index_];
+    auto next = [=] {
+        if (this->current_index_ == this->file_infos_.size() - 1) {
+            this->concatenate_videos_();
+        } else {
+            this->current_index_++;
+            this->remux_to_annexb_();
+        }
+    };
+    if (file_info.cut.has_value() && not file_info.cut->has_middle()) {
+        next();  // whole range is re-encoded as the head
+        return;
+    }
+    file_info.concat_path = tmpdir_->filePath(QStringLiteral("annexb%1.ts").arg(current_index_));
+    QStringList arguments{"-y"};
+    // timestamps are shifted by mpegts muxer, so the segment is cut here instead of by inpoint/outpoint
+    if (file_info.segment.inpoint.has_value()) {
+        // inpoint is a timestamp of the file, including its start_time
+        arguments << "-seek_timestamp" << "1"
+                  << "-ss" << QString::number(file_info.segment.inpoint.value(), 'f', 6);  // at a keyframe
+        file_info.segment.inpoint = std::nullopt;
+    }
+    // clang-format off
+    arguments << "-i" << file_info.path
+              << "-map" << "0:v:0" << "-map" << "0:a:0"
+              << "-c" << "copy"
+              << "-bsf:v" << concat::annexb_filter_of(file_info.video_stream.codec_name)
+              << "-f" << "mpegts";
+    // clang-format on
+    if (file_info.segment.outpoint.has_value()) {
+        arguments << "-t" << QString::number(file_info.segment.duration, 'f', 6);
+        file_info.segment.outpoint = std::nullopt;
+    }
+    arguments << file_info.concat_path;
+    process_->start("ffmpeg", arguments, false);
+    connect(process_, &ProcessWidget::finished, this, impl_::OnTrue(next), impl_::ONESHOT_AUTO_CONNECTION);
+}
 namespace impl_ {
 int decode_ffmpeg(QStringView, QStringView new_stderr) {
     QRegularExpression time_pattern(R"(time=(?<hours>\d\d):(?<minutes>\d\d):(?<seconds>\d\d).(?<centiseconds>\d\d))");
@@ -666,14 +1201,173 @@ auto format_time(VT value) {
 auto format_time_progress(VT, VT current, VT total) {
     return QStringLiteral("%1/%2").arg(format_time(current)).arg(format_time(total));
 }
+// longest GOP expected in stream copied inputs. parts may exceed the limits by this if it is longer
+constexpr double KEYFRAME_MARGIN_FOR_COPY = 10;
+QString muxer_of(const QString &suffix) {
+    if (suffix == "mp4" || suffix == "m4v") {
+        return "mp4";
+    } else if (suffix == "mkv") {
+        return "matroska";
+    } else if (suffix == "ts") {
+        return "mpegts";
+    }
+    return suffix;
+}
+// readers per staged input. network filesystems serve parallel requests faster than one sequential stream
+constexpr int STAGING_READER_COUNT = 4;
+constexpr int STAGING_POLL_INTERVAL_MSEC = 50;
+// ffmpeg is paused this close to the end of a staged input until the next one is staged. ffmpeg reads much less than
+// this in STAGING_POLL_INTERVAL_MSEC, so it never opens an input which is not staged yet
+constexpr std::uintmax_t STAGING_GATE_MARGIN = 256 << 20;
 }  // namespace impl_
+QStringList MainWindow::codec_arguments_(const OutputChanges &changes) {
+    QStringList arguments;
+    // clang-format off
+    arguments << "-c:a" << (changes.audio_codec? std::get<QString>(output_video_info_.audio_codec) : "copy")
+              << "-c:v" << (changes.video_codec? std::get<QString>(output_video_info_.video_codec) : "copy");
+    // clang-format on
+    if (changes.resolution) {
+        auto resolution = std::get<QSize>(output_video_info_.resolution);
+        arguments << "-s" << QStringLiteral("%1x%2").arg(resolution.width()).arg(resolution.height());
+    }
+    return arguments;
+}
+MainWindow::OutputChanges MainWindow::output_changes_() {
+    // codec names are compared here. other parameters are compared in analyze_copy_safety_()
+    OutputChanges result{false, copy_analysis_.audio_requires_encoding, copy_analysis_.video_requires_encoding};
+    for (const auto &fileinfo : file_infos_) {
+        if (std::get<QSize>(output_video_info_.resolution) != std::get<QSize>(fileinfo.video_info.resolution)) {
+            result.resolution = true;
+        }
+        if (std::get<QString>(output_video_info_.audio_codec) != std::get<QString>(fileinfo.video_info.audio_codec)) {
+            result.audio_codec = true;
+        }
+        if (std::get<QString>(output_video_info_.video_codec) != std::get<QString>(fileinfo.video_info.video_codec)) {
+            result.video_codec = true;
+        }
+    }
+    return result;
+}
+QString MainWindow::transcode_cache_directory_() {
+    return settings_
+        ->value("transcode_cache/directory",
+                QDir(QStandardPaths::writableLocation(QStandardPaths::CacheLocation)).filePath("transcode"))
+        .toString();
+}
+void MainWindow::normalize_inputs_() {
+    enter_step_(__func__);
+    inputs_are_normalized_ = false;
+    auto max_size = settings_->value("transcode_cache/max_size", 0).toLongLong() * 1024 * 1024;
+    // trimmed inputs are joined from parts of the source, which cannot be mixed with intermediates
+    auto has_cut = std::any_of(file_infos_.begin(), file_infos_.end(),
+                               [](const auto &file_info) { return file_info.cut.has_value(); });
+    if (max_size <= 0 || has_cut || not output_changes_().any()) {
+        auto changes = output_changes_();
+        // Annex B segments only matter to copied video. encoded video is decoded from the inputs as they are
+        if (copy_analysis_.video_requires_annexb_segments && not(changes.video_codec || changes.resolution)) {
+            remux_to_annexb_();
+        } else {
+            concatenate_videos_();
+        }
+        return;
+    }
+    transcode_cache_.emplace(transcode_cache_directory_(), max_size);
+    if (not transcode_cache_->is_valid()) {
+        QMessageBox::critical(this, tr("transcode cache error"),
+                              tr("failed to create directory [%1]").arg(transcode_cache_directory_()));
+        process_->finish();
+        cleanup_after_saving_("failed");
+        return;
+    }
+    QVector<QPair<QString, double>> inputs;
+    for (const auto &file_info : file_infos_) {
+        inputs.push_back({file_info.path, file_info.duration.count()});
+    }
+    auto output_info = output_video_info_;
+    process_->show_status(tr("identifying inputs for transcode cache"));
+    // only the head and tail of each input are read, but inputs on slow disks still take a while
+    QThreadPool::globalInstance()->start([this, inputs, output_info] {
+        QStringList keys;
+        QString error;
+        try {
+            for (const auto &[path, duration] : inputs) {
+                keys << concat::cache_key(concat::content_identity(path),
+                                          concat::normalize_arguments({}, duration, output_info, {}));
+            }
+        } catch (std::exception &e) {
+            error = QString::fromLocal8Bit(e.what());
+        }
+        QMetaObject::invokeMethod(
+            this,
+            [this, keys, error] {
+                if (not error.isEmpty()) {
+                    QMessageBox::critical(this, tr("error"), error);
+                    this->process_->finish();
+                    this->cleanup_after_saving_("failed");
+                    return;
+                }
+                this->normalize_keys_ = keys;
+                this->normalize_report_.clear();
+                this->current_index_ = 0;
+                this->normalize_next_input_();
+            },
+            Qt::QueuedConnection);
+    });
+}
+void MainWindow::normalize_next_input_() {
+    enter_step_(__func__, current_index_);
+    if (current_index_ == file_infos_.size()) {
+        auto removed = transcode_cache_->evict(QSet<QString>(normalize_keys_.begin(), normalize_keys_.end()));
+        normalize_report_ << tr("%1 least recently used intermediates were removed").arg(removed);
+        process_->add_report(tr("transcode cache"), normalize_report_.join("\n"));
+        inputs_are_normalized_ = true;
+        concatenate_videos_();
+        return;
+    }
+    const auto &file_info = file_infos_[current_index_];
+    auto key = normalize_keys_[current_index_];
+    auto use_intermediate = [=] {
+        auto &normalized = this->file_infos_[this->current_index_];
+        normalized.concat_path = this->transcode_cache_->path_of(key);
+        normalized.segment = {normalized.duration.count(), std::nullopt, std::nullopt};
+        this->current_index_++;
+        this->normalize_next_input_();
+    };
+    if (transcode_cache_->lookup(key)) {
+        normalize_report_ << tr("reused: %1").arg(QFileInfo(file_info.path).fileName());
+        use_intermediate();
+        return;
+    }
+    normalize_report_ << tr("encoded: %1").arg(QFileInfo(file_info.path).fileName());
+    using std::chrono::duration_cast;
+    using std::chrono::milliseconds;
+    process_->start("ffmpeg",
+                    concat::normalize_arguments(file_info.path, file_info.duration.count(), output_video_info_,
+                                                transcode_cache_->partial_path_of(key)),
+                    false,
+                    {0, static_cast<int>(duration_cast<milliseconds>(file_info.duration).count()),
+                     impl_::decode_ffmpeg, impl_::format_time_progress});
+    connect(
+        process_, &ProcessWidget::finished, this, impl_::OnTrue([=] {
+            if (not this->transcode_cache_->commit(key)) {
+                QMessageBox::critical(this, tr("transcode cache error"),
+                                      tr("failed to store [%1]").arg(this->transcode_cache_->path_of(key)));
+                this->process_->finish();
+                this->cleanup_after_saving_("failed");
+                return;
+            }
+            use_intermediate();
+        }),
+        impl_::ONESHOT_AUTO_CONNECTION);
+}
 void MainWindow::concatenate_videos_() {
+    enter_step_(__func__);
     if (not tmpdir_->isValid()) {
         QMessageBox::critical(this, tr("temporary directory error"),
                               tr("failed to create temporary directory \n%1").arg(tmpdir_->errorString()));
         return;
     }
-    QFile concat_file(tmpdir_->filePath("concat.txt"));
+    QFile concat_file(tmpdir_->filePath("concat.ffconcat"));
     if (not concat_file.open(QIODevice::WriteOnly | QIODevice::Text)) {
         QMessageBox::critical(
             this, tr("file open error"),
@@ -684,51 +1378,391 @@ void MainWindow::concatenate_videos_() {
     using milliseconds = std::chrono::duration<int, std::milli>;
     using seconds = std::chrono::duration<double>;
     using namespace std::chrono_literals;
-    QTextStream concat_file_stream(&concat_file);
     total_length_ = 0ms;
-    for (const auto &file_info : file_infos_) {
-        concat_file_stream << "file '" << file_info.path << "'\n";
+    QVector<concat::ConcatListEntry> concat_list;
+    for (auto i = 0; i < file_infos_.size(); i++) {
+        const auto &file_info = file_infos_[i];
+        // rendered parts are mpegts, whose stream ids are PIDs
+        if (file_info.cut.has_value() && file_info.cut->has_head()) {
+            concat_list.push_back({file_info.head_path, file_info.cut->in_keyframe - file_info.cut->in_point,
+                                   std::nullopt, std::nullopt, {}, {}});
+        }
+        if (not file_info.cut.has_value() || file_info.cut->has_middle()) {
+            bool is_source = file_info.concat_path == file_info.path;
+            auto concat_path = file_info.concat_path;
+            if (staging_.stager != nullptr && staging_.index_of_input[i] >= 0) {
+                concat_path = impl_::format_path(staging_.stager->path_of(staging_.index_of_input[i]));
+            }
+            concat_list.push_back({concat_path, file_info.segment.duration, file_info.segment.inpoint,
+                                   file_info.segment.outpoint, is_source ? file_info.video_stream.id : QString(),
+                                   is_source ? file_info.audio_stream.id : QString()});
+        }
+        if (file_info.cut.has_value() && file_info.cut->has_tail()) {
+            concat_list.push_back({file_info.tail_path, file_info.cut->out_point - file_info.cut->out_keyframe,
+                                   std::nullopt, std::nullopt, {}, {}});
+        }
         total_length_ += duration_cast<milliseconds>(file_info.duration);
     }
+    QTextStream concat_file_stream(&concat_file);
+    concat_file_stream << concat::write_concat_list(concat_list);
     concat_file.close();
-    bool resolution_changed = false, audio_codec_changed = false, video_codec_changed = false;
-    for (const auto &fileinfo : file_infos_) {
-        if (std::get<QSize>(output_video_info_.resolution) != std::get<QSize>(fileinfo.video_info.resolution)) {
-            resolution_changed = true;
-        }
-        if (std::get<QString>(output_video_info_.audio_codec) != std::get<QString>(fileinfo.video_info.audio_codec)) {
-            audio_codec_changed = true;
+    // intermediates in the transcode cache already match the output, so they are joined by stream copy
+    auto changes = inputs_are_normalized_ ? OutputChanges{false, false, false} : output_changes_();
+    // gains are applied by the audio encoder of this pass, while video keeps being copied if it can
+    changes.audio_codec = changes.audio_codec || not loudness_.gains.isEmpty();
+    bool resolution_changed = changes.resolution;
+    bool audio_codec_changed = changes.audio_codec;
+    bool video_codec_changed = changes.video_codec;
+    if (not(resolution_changed || audio_codec_changed || video_codec_changed) && may_join_transport_streams_()) {
+        if (not transport_streams_are_joinable_.has_value()) {
+            check_transport_streams_();
+            return;
         }
-        if (std::get<QString>(output_video_info_.video_codec) != std::get<QString>(fileinfo.video_info.video_codec)) {
-            video_codec_changed = true;
+        if (transport_streams_are_joinable_.value()) {
+            join_transport_streams_();
+            return;
         }
     }
+    if (not staging_.is_prepared && stages_inputs_()) {
+        start_staging_();
+        return;
+    }
     QStringList arguments;
-    tmpfile_paths_.concatenated = tmpdir_->filePath("concatenated." + QFileInfo(result_path_.toLocalFile()).suffix());
+    // result is written in tmpdir first so that half-written result never appears at result_path_
+    auto suffix = QFileInfo(result_path_.toLocalFile()).suffix();
+    tmpfile_paths_.result = tmpdir_->filePath("result." + suffix);
     // clang-format off
     arguments << "-f" << "concat"
               << "-safe" << "0"
-              << output_video_info_.input_file_args
-              << "-i" << concat_file.fileName()
-              << "-c:a" << (audio_codec_changed? std::get<QString>(output_video_info_.audio_codec) : "copy")
-              << "-c:v" << (video_codec_changed? std::get<QString>(output_video_info_.video_codec) : "copy");
+              << (inputs_are_normalized_ ? QStringList() : output_video_info_.input_file_args)
+              << "-i" << concat_file.fileName();
     // clang-format on
-    if (resolution_changed) {
-        auto resolution = std::get<QSize>(output_video_info_.resolution);
-        arguments << "-s" << QStringLiteral("%1x%2").arg(resolution.width()).arg(resolution.height());
+    if (not is_split_output_()) {
+        // chapters are muxed in this pass, so the result is not rewritten only to add them
+        if (not write_chapter_metadata_()) {
+            return;
+        }
+        arguments << "-i" << tmpfile_paths_.metadata;
+    }
+    arguments << codec_arguments_(changes);
+    QString loudness_filter;
+    if (not loudness_.gains.isEmpty()) {
+        QVector<double> durations;
+        for (const auto &file_info : file_infos_) {
+            durations << file_info.duration.count();
+        }
+        loudness_filter = concat::loudness_filter(loudness_.gains, durations);
+        arguments << "-af" << loudness_filter;
+    }
+    if (not inputs_are_normalized_) {
+        arguments += output_video_info_.encoding_args;
     }
-    arguments += output_video_info_.encoding_args;
-    arguments << tmpfile_paths_.concatenated;
+    if (is_split_output_()) {
+        // parts are written by the segment muxer in this pass. chapters are added to each part afterwards
+        QVector<concat::RatedSpan> spans;
+        auto bitrate = concat::target_bitrate(output_video_info_);
+        for (auto i = 0; i < file_infos_.size(); i++) {
+            const auto &entry = input_files_->entry(i);
+            double bytes_per_second = 0;
+            if (video_codec_changed && bitrate.has_value()) {
+                bytes_per_second = bitrate.value() / 8.0;
+            } else if (entry.size.has_value() && entry.duration.value_or(0) > 0) {
+                bytes_per_second = entry.size.value() / entry.duration.value();
+            }
+            spans.push_back({file_infos_[i].duration.count(), bytes_per_second});
+        }
+        // keyframes are forced at split points when video is encoded. otherwise a part may grow by one GOP
+        QVector<double> points;
+        try {
+            points = concat::split_points(spans, output_video_info_.max_part_size,
+                                          output_video_info_.max_part_duration,
+                                          video_codec_changed ? 0 : impl_::KEYFRAME_MARGIN_FOR_COPY);
+        } catch (std::invalid_argument &e) {
+            QMessageBox::critical(this, tr("split error"),
+                                  tr("%1\nmargin for the next keyframe: %2 seconds")
+                                      .arg(QString::fromLocal8Bit(e.what()))
+                                      .arg(video_codec_changed ? 0 : impl_::KEYFRAME_MARGIN_FOR_COPY));
+            process_->finish();
+            cleanup_after_saving_("failed");
+            return;
+        }
+        QStringList point_texts;
+        for (auto point : points) {
+            point_texts << QString::number(point, 'f', 6);
+        }
+        if (video_codec_changed && not points.isEmpty()) {
+            arguments << "-force_key_frames" << point_texts.join(",");
+        }
+        tmpfile_paths_.segment_list = tmpdir_->filePath("parts.csv");
+        arguments << concat::segment_arguments(points, impl_::muxer_of(suffix.toLower()), tmpfile_paths_.segment_list);
+        arguments << tmpdir_->filePath("part%03d." + suffix.toLower());
+    } else if (writes_tee_output_()) {
+        // the result, its backups and the hashes of its packets are written by this pass, so that none of them reads
+        // the result back. the tee muxer passes no chapters to its outputs. they are added by add_tee_chapters_()
+        auto muxer = impl_::muxer_of(suffix.toLower());
+        QVector<QPair<QString, QString>> options{{"f", muxer}};
+        if (is_fragmented_output_()) {
+            options.push_back({"movflags", "+frag_keyframe+empty_moov+default_base_moof"});
+        }
+        QStringList outputs{concat::tee_output(options, tmpfile_paths_.result)};
+        if (not is_fragmented_output_()) {  // otherwise backups are written with the appendable rewrite by placement
+            tmpfile_paths_.tee_backups = backup_paths_();
+            for (const auto &backup : tmpfile_paths_.tee_backups) {
+                outputs << concat::tee_output(options,
+                                              impl_::format_path(concat::partial_path_of(backup.toStdU16String())));
+            }
+        }
+        if (writes_manifest_()) {
+            tmpfile_paths_.stream_hashes = tmpdir_->filePath("streamhash.txt");
+            outputs << concat::stream_hash_output(tmpfile_paths_.stream_hashes);
+        }
+        // the tee muxer selects no streams by itself, and cannot ask encoders for the global headers of its outputs
+        arguments << "-map" << "0:v:0" << "-map" << "0:a:0?" << "-map_chapters" << "-1";
+        if ((video_codec_changed || resolution_changed || audio_codec_changed) && muxer != "mpegts") {
+            arguments << "-flags" << "+global_header";
+        }
+        arguments << "-f" << "tee" << outputs.join("|");
+    } else {
+        arguments << chapter_arguments_() << tmpfile_paths_.result;
+    }
+    if (has_renditions_()) {
+        // additional outputs of the same run share demuxing and decoding with the main output.
+        // every rendition gets the same chapters, as they share the timeline of the main output
+        for (auto i = 0; i < output_video_info_.renditions.size(); i++) {
+            tmpfile_paths_.rendition_results << tmpdir_->filePath(
+                QStringLiteral("rendition_result%1.%2").arg(i).arg(suffix));
+            const auto &rendition = output_video_info_.renditions[i];
+            arguments << concat::rendition_arguments(rendition);
+            if (not loudness_filter.isEmpty() && not rendition.audio_codec.isEmpty()) {
+                arguments << "-af" << loudness_filter;  // copied audio is left as the source
+            }
+            arguments << "-map_chapters" << "1" << tmpfile_paths_.rendition_results[i];
+        }
+    }
+    metrics_.increment("video_concatenater_concatenated_streams_total",
+                       {{"stream", "video"}, {"mode", video_codec_changed || resolution_changed ? "encode" : "copy"}});
+    metrics_.increment("video_concatenater_concatenated_streams_total",
+                       {{"stream", "audio"}, {"mode", audio_codec_changed ? "encode" : "copy"}});
     using VT = ProcessWidget::ProgressParams::ValueType;
     process_->start("ffmpeg", arguments, false,
                     {0, total_length_.count(), impl_::decode_ffmpeg, impl_::format_time_progress});
-    tmpfile_paths_.metadata = tmpdir_->filePath("metadata.ini");
-    connect(process_, &ProcessWidget::finished, this, impl_::OnTrue([=] {
-                this->retrieve_metadata_(this->tmpfile_paths_.concatenated, this->tmpfile_paths_.metadata,
-                                         [=] { this->add_chapters_(); });
-            }),
+    if (staging_.stager != nullptr) {
+        // ffmpeg must not be left stopped, and staged inputs are not needed whether it succeeds or not
+        connect(process_, &ProcessWidget::finished, this, [this](bool) { this->finish_staging_(); },
+                impl_::ONESHOT_AUTO_CONNECTION);
+    }
+    if (not tmpfile_paths_.tee_backups.isEmpty()) {
+        // backups half-written by a failed run must not be left in their directories
+        auto backups = impl_::to_paths(tmpfile_paths_.tee_backups);
+        connect(
+            process_, &ProcessWidget::finished, this,
+            [backups](bool is_success) {
+                if (not is_success) {
+                    concat::remove_partials(backups);
+                }
+            },
+            impl_::ONESHOT_AUTO_CONNECTION);
+    }
+    if (is_split_output_()) {
+        connect(process_, &ProcessWidget::finished, this, impl_::OnTrue([=] { this->place_parts_(); }),
+                impl_::ONESHOT_AUTO_CONNECTION);
+        return;
+    }
+    if (writes_tee_output_()) {
+        connect(process_, &ProcessWidget::finished, this, impl_::OnTrue([=] { this->add_tee_chapters_(); }),
+                impl_::ONESHOT_AUTO_CONNECTION);
+        return;
+    }
+    connect(process_, &ProcessWidget::finished, this, impl_::OnTrue([=] { this->validate_result_(); }),
             impl_::ONESHOT_AUTO_CONNECTION);
 }
+bool MainWindow::stages_inputs_() {
+    return concat::Stager::is_supported() && not settings_->value("staging/directory").toString().isEmpty();
+}
+void MainWindow::start_staging_() {
+    staging_.is_prepared = true;
+    auto directory = settings_->value("staging/directory").toString();
+    auto staging_root = QStorageInfo(directory).rootPath();
+    staging_.index_of_input = QVector<int>(file_infos_.size(), -1);
+    std::vector<std::filesystem::path> srcs;
+    for (auto i = 0; i < file_infos_.size(); i++) {
+        const auto &file_info = file_infos_[i];
+        bool reads_source = file_info.concat_path == file_info.path &&
+                            (not file_info.cut.has_value() || file_info.cut->has_middle());
+        // inputs on the filesystem of the staging directory gain nothing from being copied
+        if (reads_source && QStorageInfo(file_info.path).rootPath() != staging_root) {
+            staging_.index_of_input[i] = static_cast<int>(srcs.size());
+            srcs.push_back(file_info.path.toStdU16String());
+        }
+    }
+    if (srcs.empty()) {
+        concatenate_videos_();
+        return;
+    }
+    staging_.dir = new QTemporaryDir(QDir(directory).filePath("video_concatenater-XXXXXX"));
+    if (not staging_.dir->isValid()) {
+        QMessageBox::critical(this, tr("staging error"),
+                              tr("failed to create directory in [%1]\n%2").arg(directory, staging_.dir->errorString()));
+        finish_staging_();
+        process_->finish();
+        return;
+    }
+    // half of the free space is left for other files, including the result if it is written there
+    auto available = std::max<qint64>(QStorageInfo(directory).bytesAvailable(), 0);
+    auto max_staged_bytes = static_cast<std::uintmax_t>(available) / 2;
+    staging_.stager = std::make_unique<concat::Stager>(srcs, staging_.dir->path().toStdU16String(),
+                                                       impl_::STAGING_READER_COUNT, max_staged_bytes);
+    staging_.timer = new QTimer(this);
+    staging_.timer->setInterval(impl_::STAGING_POLL_INTERVAL_MSEC);
+    connect(staging_.timer, &QTimer::timeout, this, &MainWindow::watch_staging_);
+    staging_.timer->start();
+    process_->show_status(tr("staging %n input(s) to %1", nullptr, static_cast<int>(srcs.size())).arg(directory));
+}
+void MainWindow::watch_staging_() {
+    auto &stager = *staging_.stager;
+    if (auto error = stager.error(); error.has_value()) {
+        bool is_running = staging_.is_started;
+        finish_staging_();
+        if (not is_running) {
+            QMessageBox::critical(this, tr("staging error"), QString::fromStdString(error.value()));
+            process_->finish();
+        }
+        // otherwise ffmpeg fails to open the input which is not staged, and reports it
+        return;
+    }
+    if (not staging_.is_started) {
+        if (stager.is_staged(0)) {
+            staging_.is_started = true;
+            concatenate_videos_();
+        }
+        return;
+    }
+    auto pid = process_->process_id();
+    if (pid == 0) {
+        return;
+    }
+    auto count = static_cast<int>(stager.size());
+    // ffmpeg reads inputs in order, so only the current one and the next one can be open
+    std::optional<std::uintmax_t> offset;
+    for (auto i = std::max(staging_.position, 0); i < std::min(staging_.position + 2, count); i++) {
+        if (auto found = concat::open_file_position(pid, stager.path_of(i)); found.has_value()) {
+            staging_.position = i;
+            offset = found;
+        }
+    }
+    if (staging_.position >= 0) {
+        stager.set_reading(staging_.position);
+    }
+    for (auto i = 0; i < staging_.position; i++) {
+        stager.evict(i);  // consumed
+    }
+    auto next = staging_.position + 1;
+    bool next_is_staged = next >= count || stager.is_staged(next);
+    // no staged input is open between inputs, or while one which is not staged (e.g. a rendered cut) is read
+    bool is_near_end = not offset.has_value() ||
+                       offset.value() + impl_::STAGING_GATE_MARGIN >= stager.size_of(staging_.position);
+    bool should_pause = is_near_end && not next_is_staged;
+    if (should_pause != staging_.is_paused) {
+        concat::pause_process(pid, should_pause);
+        staging_.is_paused = should_pause;
+        process_->show_status(should_pause ? tr("waiting for input %1/%2 to be staged").arg(next + 1).arg(count)
+                                           : tr("reading staged inputs"));
+    }
+}
+void MainWindow::finish_staging_() {
+    if (staging_.timer != nullptr) {
+        staging_.timer->stop();
+        staging_.timer->deleteLater();
+    }
+    if (staging_.is_paused) {
+        concat::pause_process(process_->process_id(), false);
+    }
+    staging_.stager.reset();  // joins readers
+    delete staging_.dir;
+    staging_ = {};
+}
+bool MainWindow::may_join_transport_streams_() {
+    // backups and hashes are written with the result by the tee muxer, which the byte join cannot do
+    if (is_split_output_() || has_renditions_() || writes_tee_output_()) {
+        return false;
+    }
+    if (not(output_video_info_.encoding_args.isEmpty() && output_video_info_.input_file_args.isEmpty() &&
+            not copy_analysis_.video_requires_annexb_segments)) {
+        return false;
+    }
+    const auto &first = file_infos_.front();
+    for (const auto &file_info : file_infos_) {
+        // trimming and outpoint of join repair need the concat demuxer
+        bool is_plain_input = not file_info.cut.has_value() && not file_info.segment.outpoint.has_value() &&
+                              file_info.concat_path == file_info.path;
+        bool has_same_pids = file_info.video_stream.id == first.video_stream.id &&
+                             file_info.audio_stream.id == first.audio_stream.id;
+        if (not(is_plain_input && has_same_pids && QFileInfo(file_info.path).suffix().toLower() == "ts")) {
+            return false;
+        }
+    }
+    return true;
+}
+void MainWindow::check_transport_streams_() {
+    enter_step_(__func__);
+    std::vector<std::filesystem::path> paths;
+    for (const auto &file_info : file_infos_) {
+        paths.push_back(file_info.path.toStdU16String());
+    }
+    process_->show_status(tr("checking packets of %n MPEG-TS input(s)", nullptr, static_cast<int>(paths.size())));
+    // inputs are opened and read, which may block on network mounts
+    QThreadPool::globalInstance()->start([this, paths] {
+        auto is_joinable = std::all_of(paths.begin(), paths.end(), [](const auto &path) {
+            return concat::is_byte_joinable_transport_stream(path);
+        });
+        QMetaObject::invokeMethod(
+            this,
+            [this, is_joinable] {
+                this->transport_streams_are_joinable_ = is_joinable;
+                this->concatenate_videos_();
+            },
+            Qt::QueuedConnection);
+    });
+}
+void MainWindow::join_transport_streams_() {
+    enter_step_(__func__);
+    std::vector<std::filesystem::path> srcs;
+    for (const auto &file_info : file_infos_) {
+        srcs.push_back(file_info.path.toStdU16String());
+    }
+    for (auto stream : {"video", "audio"}) {
+        metrics_.increment("video_concatenater_concatenated_streams_total", {{"stream", stream}, {"mode", "copy"}});
+    }
+    tmpfile_paths_.concatenated = tmpdir_->filePath("concatenated.ts");
+    auto dst = tmpfile_paths_.concatenated;
+    // runs at disk speed, but that may still take minutes for long recordings
+    QThreadPool::globalInstance()->start([this, srcs, dst] {
+        QString error;
+        concat::TsJoinResult result{};
+        try {
+            result = concat::join_transport_streams(srcs, dst.toStdU16String());
+        } catch (std::exception &e) {
+            error = QString::fromLocal8Bit(e.what());
+        }
+        QMetaObject::invokeMethod(
+            this,
+            [this, result, error] {
+                if (not error.isEmpty()) {
+                    QMessageBox::critical(this, tr("error"), tr("failed to join MPEG-TS files\n%1").arg(error));
+                    return;
+                }
+                this->process_->add_report(
+                    tr("mpeg-ts join"),
+                    tr("inputs were joined at the byte level\nsize: %1\nfirst input reflinked: %2\n"
+                       "discontinuity packets inserted: %3")
+                        .arg(QLocale().formattedDataSize(result.size))
+                        .arg(result.is_first_file_reflinked ? tr("yes") : tr("no"))
+                        .arg(result.discontinuity_packets));
+                this->remux_joined_stream_();
+            },
+            Qt::QueuedConnection);
+    });
+}
 void MainWindow::retrieve_metadata_(QString src_filepath, QString dst_filepath, std::function<void(void)> on_success) {
     QStringList arguments;
     // clang-format off
@@ -739,19 +1773,27 @@ void MainWindow::retrieve_metadata_(QString src_filepath, QString dst_filepath,
     process_->start("ffmpeg", arguments, false);
     connect(process_, &ProcessWidget::finished, this, impl_::OnTrue(on_success), impl_::ONESHOT_AUTO_CONNECTION);
 }
-void MainWindow::add_chapters_() {
+void MainWindow::render_part_(const FileInfo &file_info, double from, double to, QString dst_filepath,
+                              std::function<void(void)> on_success) {
+    process_->start("ffmpeg",
+                    concat::render_arguments(file_info.path, from, to, file_info.video_stream, file_info.audio_stream,
+                                             dst_filepath),
+                    false);
+    connect(process_, &ProcessWidget::finished, this, impl_::OnTrue(on_success), impl_::ONESHOT_AUTO_CONNECTION);
+}
+bool MainWindow::write_chapter_metadata_() {
+    tmpfile_paths_.metadata = tmpdir_->filePath("metadata.ini");
     QFile metadata_file(tmpfile_paths_.metadata);
-    if (not metadata_file.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text)) {
+    if (not metadata_file.open(QIODevice::WriteOnly | QIODevice::Text)) {
         QMessageBox::critical(this, tr("file open error"),
                               tr("failed to open file [%1]. QFile::error(): %2")
                                   .arg(metadata_file.fileName())
                                   .arg(metadata_file.error()));
-        return;
+        process_->finish();
+        return false;
     }
     QTextStream metadata_stream(&metadata_file);
-    metadata_stream << Qt::endl;
-    using micro_seconds = std::chrono::duration<double, std::micro>;
-    using std::chrono::duration_cast;
+    metadata_stream << ";FFMETADATA1" << Qt::endl;
     for (const auto &file_info : file_infos_) {
         for (const auto &chapter : file_info.chapters) {
             metadata_stream << "[CHAPTER]" << Qt::endl;
@@ -763,47 +1805,919 @@ void MainWindow::add_chapters_() {
         }
     }
     metadata_file.close();
-
+    return true;
+}
+QStringList MainWindow::chapter_arguments_() {
     QStringList arguments;
+    if (is_fragmented_output_()) {
+        // chapters are written as chpl with reserved space by place_result_(), instead of a chapter track
+        arguments << "-map_chapters" << "-1"
+                  << "-movflags" << "+frag_keyframe+empty_moov+default_base_moof";
+    } else {
+        arguments << "-map_chapters" << "1";
+    }
+    return arguments;
+}
+void MainWindow::remux_joined_stream_() {
+    enter_step_(__func__);
+    if (QFileInfo(result_path_.toLocalFile()).suffix().toLower() == "ts") {
+        // the joined stream is the result. MPEG-TS has no chapters, so there is nothing to add
+        tmpfile_paths_.result = tmpfile_paths_.concatenated;
+        validate_result_();
+        return;
+    }
+    // the joined stream is not in the container of the result yet. chapters are added by the same remux
+    if (not write_chapter_metadata_()) {
+        return;
+    }
+    QStringList arguments;
+    tmpfile_paths_.result = tmpdir_->filePath("result." + QFileInfo(result_path_.toLocalFile()).suffix());
     // clang-format off
     arguments << "-i" << tmpfile_paths_.concatenated
               << "-i" << tmpfile_paths_.metadata
-              << "-map_metadata" << "1"
-              << "-map_chapters" << "1"
-              << "-c" << "copy" 
-              << result_path_.toLocalFile();
+              << "-map" << "0"
+              << "-c" << "copy"
+              << chapter_arguments_()
+              << tmpfile_paths_.result;
     // clang-format on
-
-    // process_->start(
-    //     "py", {"-c", "import time;[print(i,flush=True) or time.sleep(1) for i in range(120)]",
-    //     tmpfile_paths_.metadata}, true);
-
-    process_->start("ffmpeg", arguments, true,
+    process_->start("ffmpeg", arguments, false,
                     {0, total_length_.count(), impl_::decode_ffmpeg, impl_::format_time_progress});
-    connect(process_, &ProcessWidget::finished, this, impl_::OnTrue([=] { this->cleanup_after_saving_(); }),
+    connect(process_, &ProcessWidget::finished, this, impl_::OnTrue([=] { this->validate_result_(); }),
+            impl_::ONESHOT_AUTO_CONNECTION);
+}
+void MainWindow::add_tee_chapters_() {
+    enter_step_(__func__);
+    auto suffix = QFileInfo(result_path_.toLocalFile()).suffix().toLower();
+    auto is_mp4 = suffix == "mp4" || suffix == "m4v" || suffix == "mov";
+    auto chapters = mp4_chapters_();
+    // chapters of fragmented output are written by place_result_(). other formats are written without chapters
+    if (is_fragmented_output_() || not is_mp4 || chapters.empty()) {
+        validate_result_();
+        return;
+    }
+    QStringList paths{tmpfile_paths_.result};
+    for (const auto &backup : tmpfile_paths_.tee_backups) {
+        paths << impl_::format_path(concat::partial_path_of(backup.toStdU16String()));
+    }
+    // only moov at the end of each file is rewritten
+    QThreadPool::globalInstance()->start([this, paths, chapters] {
+        QString error;
+        try {
+            for (const auto &path : paths) {
+                concat::write_chapters_to_trailing_moov(path.toStdU16String(), chapters);
+            }
+        } catch (std::exception &e) {
+            error = QString::fromLocal8Bit(e.what());
+        }
+        QMetaObject::invokeMethod(
+            this,
+            [this, error] {
+                if (not error.isEmpty()) {
+                    QMessageBox::critical(this, tr("error"), tr("failed to write chapters\n%1").arg(error));
+                    this->process_->finish();
+                    this->cleanup_after_saving_("failed");
+                    return;
+                }
+                this->validate_result_();
+            },
+            Qt::QueuedConnection);
+    });
+}
+void MainWindow::validate_result_() {
+    enter_step_(__func__);
+    process_->start("ffprobe", concat::validation_probe_arguments(tmpfile_paths_.result), true);
+    connect(process_, &ProcessWidget::finished, this, impl_::OnTrue([=] { this->register_validation_(); }),
             impl_::ONESHOT_AUTO_CONNECTION);
 }
-void MainWindow::cleanup_after_saving_() {
+void MainWindow::register_validation_() {
+    enter_step_(__func__);
+    concat::ExpectedOutput expected{0, file_infos_.front().audio_stream.codec_type == "audio", std::nullopt};
+    QVector<concat::ExpectedChapter> chapters;
+    for (const auto &file_info : file_infos_) {
+        expected.duration += file_info.duration.count();
+        for (const auto &chapter : file_info.chapters) {
+            auto timebase = static_cast<double>(chapter.timebase_numerator) / chapter.timebase_denominator;
+            chapters.push_back({chapter.start_time * timebase, chapter.end_time * timebase});
+        }
+    }
+    auto suffix = QFileInfo(result_path_.toLocalFile()).suffix().toLower();
+    auto is_mp4 = suffix == "mp4" || suffix == "m4v" || suffix == "mov";
+    // chapters of fragmented output are written by place_result_(). the tee muxer writes no chapters but chpl of mp4
+    if (not is_fragmented_output_() && (is_mp4 || not writes_tee_output_())) {
+        expected.chapters = chapters;
+    }
+    // packets of copied streams are carried over from the inputs. trimmed inputs keep the share of their range
+    auto expected_packets = [this](concat::StreamParams FileInfo::*member) -> std::optional<qint64> {
+        double total = 0;
+        for (const auto &file_info : file_infos_) {
+            const auto &stream = file_info.*member;
+            if (stream.nb_frames < 0 || stream.duration <= 0) {
+                return std::nullopt;
+            }
+            total += stream.nb_frames * std::min(1.0, file_info.duration.count() / stream.duration);
+        }
+        return std::llround(total);
+    };
+    auto changes = output_changes_();
+    if (not(changes.video_codec || changes.resolution)) {
+        expected.video_packets = expected_packets(&FileInfo::video_stream);
+    }
+    if (expected.has_audio && not changes.audio_codec && loudness_.gains.isEmpty()) {
+        expected.audio_packets = expected_packets(&FileInfo::audio_stream);
+    }
+    expected.join_count = static_cast<int>(file_infos_.size()) - 1;
+    auto probe = QJsonDocument::fromJson(process_->get_stdout().toUtf8()).object();
+    auto result = concat::validate_output(probe, expected);
+    process_->add_report(tr("validation"), result.report());
+    if (not result.is_valid()) {
+        auto button = QMessageBox::warning(
+            this, tr("validation failed"),
+            tr("the result may be broken.\n%1\n\nDo you want to save it anyway?").arg(result.errors.join("\n")),
+            QMessageBox::Save | QMessageBox::Abort, QMessageBox::Abort);
+        if (button != QMessageBox::Save) {
+            tmpdir_->setAutoRemove(false);  // keep the result for investigation
+            process_->add_report(tr("aborted"), tr("the result is kept in %1").arg(tmpdir_->path()));
+            cleanup_after_saving_("failed");
+            return;
+        }
+    }
+    place_result_();
+}
+bool MainWindow::is_fragmented_output_() {
+    auto suffix = QFileInfo(result_path_.toLocalFile()).suffix().toLower();
+    return append_mode_ ||
+           (settings_->value("fragmented_output", false).toBool() && (suffix == "mp4" || suffix == "m4v"));
+}
+std::vector<concat::Mp4Chapter> MainWindow::mp4_chapters_() const {
+    std::vector<concat::Mp4Chapter> chapters;
+    for (const auto &file_info : file_infos_) {
+        for (const auto &chapter : file_info.chapters) {
+            auto timebase = static_cast<double>(chapter.timebase_numerator) / chapter.timebase_denominator;
+            chapters.push_back({chapter.start_time * timebase, chapter.title.toStdString()});
+        }
+    }
+    return chapters;
+}
+bool MainWindow::check_chapter_count_() {
+    auto suffix = QFileInfo(result_path_.toLocalFile()).suffix().toLower();
+    auto is_mp4 = suffix == "mp4" || suffix == "m4v" || suffix == "mov";
+    auto count = mp4_chapters_().size();
+    if (is_split_output_() && not is_mp4 && count > 0) {
+        // the segment muxer writes no chapters, and chpl is read by mp4 family only
+        auto button = QMessageBox::warning(
+            this, tr("chapters are dropped"),
+            tr("%1 chapters cannot be written to parts of .%2 files, and the parts are written without chapters.\n"
+               "Do you want to continue?")
+                .arg(count)
+                .arg(suffix),
+            QMessageBox::Yes | QMessageBox::No, QMessageBox::No);
+        return button == QMessageBox::Yes;
+    }
+    if (writes_tee_output_() && not is_mp4 && suffix != "ts" && count > 0) {  // MPEG-TS has no chapters anyway
+        // the tee muxer, which writes backups and stream hashes with the result, passes no chapters to its outputs
+        auto button = QMessageBox::warning(
+            this, tr("chapters are dropped"),
+            tr("%1 chapters cannot be written to .%2 files with backups or a manifest, and the result is written "
+               "without chapters.\nDo you want to continue?")
+                .arg(count)
+                .arg(suffix),
+            QMessageBox::Yes | QMessageBox::No, QMessageBox::No);
+        return button == QMessageBox::Yes;
+    }
+    // chpl is written after the whole encode
+    if (not(is_fragmented_output_() || ((is_split_output_() || writes_tee_output_()) && is_mp4))) {
+        return true;
+    }
+    if (append_mode_) {
+        try {
+            count += concat::read_appendable_chapters(result_path_.toLocalFile().toStdU16String()).size();
+        } catch (std::exception &e) {
+            QMessageBox::critical(this, tr("error"), QString::fromLocal8Bit(e.what()));
+            return false;
+        }
+    }
+    if (count > concat::MAX_MP4_CHAPTERS) {
+        QMessageBox::critical(this, tr("too many chapters"),
+                              tr("%1 chapters cannot be written to this output. at most %2 chapters are supported")
+                                  .arg(count)
+                                  .arg(concat::MAX_MP4_CHAPTERS));
+        return false;
+    }
+    return true;
+}
+bool MainWindow::confirm_extra_outputs_() {
+    auto dst = result_path_.toLocalFile();
+    if (is_split_output_()) {
+        if (backup_paths_().isEmpty() && not settings_->value("write_manifest", false).toBool()) {
+            return true;
+        }
+        auto button = QMessageBox::warning(
+            this, tr("backups and manifest are skipped"),
+            tr("parts of split output are neither backed up nor listed in a manifest.\nDo you want to continue?"),
+            QMessageBox::Yes | QMessageBox::No, QMessageBox::No);
+        return button == QMessageBox::Yes;
+    }
+    auto destinations = backup_paths_();
+    if (writes_manifest_()) {
+        QStringList manifest_paths{concat::manifest_path(dst)};
+        for (const auto &copy : destinations) {
+            manifest_paths << concat::manifest_path(copy);
+        }
+        destinations += manifest_paths;
+    }
+    if (has_renditions_()) {
+        for (const auto &rendition : output_video_info_.renditions) {
+            destinations << concat::rendition_path(dst, rendition.name);
+        }
+    }
+    QStringList existing;
+    for (const auto &destination : destinations) {
+        if (QFileInfo::exists(destination)) {
+            existing << destination;
+        }
+    }
+    if (existing.isEmpty()) {
+        return true;
+    }
+    auto button = QMessageBox::warning(
+        this, tr("files exist"),
+        tr("the files below exist and will be overwritten.\n%1\n\nDo you want to continue?").arg(existing.join("\n")),
+        QMessageBox::Yes | QMessageBox::No, QMessageBox::No);
+    return button == QMessageBox::Yes;
+}
+bool MainWindow::writes_manifest_() {
+    return not append_mode_ && settings_->value("write_manifest", false).toBool();
+}
+QStringList MainWindow::backup_paths_() {
+    QStringList result;
+    if (append_mode_) {
+        return result;
+    }
+    for (const auto &directory : settings_->value("backup_destinations").toStringList()) {
+        result << QDir(directory).filePath(QFileInfo(result_path_.toLocalFile()).fileName());
+    }
+    return result;
+}
+bool MainWindow::writes_tee_output_() {
+    return not is_split_output_() && (writes_manifest_() || not backup_paths_().isEmpty());
+}
+bool MainWindow::has_renditions_() {
+    return not append_mode_ && not is_split_output_() && not output_video_info_.renditions.isEmpty();
+}
+bool MainWindow::is_split_output_() {
+    return not append_mode_ && (output_video_info_.max_part_size > 0 || output_video_info_.max_part_duration > 0);
+}
+void MainWindow::place_parts_() {
+    enter_step_(__func__);
+    QFile list_file(tmpfile_paths_.segment_list);
+    if (not list_file.open(QIODevice::ReadOnly)) {
+        QMessageBox::critical(this, tr("error"), tr("failed to read list of parts [%1]").arg(list_file.fileName()));
+        return;
+    }
+    auto parts = concat::parse_segment_list(list_file.readAll());
+    list_file.close();
+    auto dst = result_path_.toLocalFile();
+    auto suffix = QFileInfo(dst).suffix().toLower();
+    // chpl is read by mp4 family only. other formats are written without chapters
+    auto has_chapters = suffix == "mp4" || suffix == "m4v" || suffix == "mov";
+    auto chapters = mp4_chapters_();
+    auto dir = QDir(tmpdir_->path());
+    QThreadPool::globalInstance()->start([this, parts, dst, has_chapters, chapters, dir] {
+        QString error;
+        QStringList placed;
+        try {
+            for (auto i = 0; i < parts.size(); i++) {
+                auto src = dir.filePath(QFileInfo(parts[i].filename).fileName());
+                if (has_chapters) {
+                    concat::write_chapters_to_trailing_moov(
+                        src.toStdU16String(), concat::chapters_of_part(chapters, parts[i].start, parts[i].end));
+                }
+                auto part_dst = concat::part_path(dst, i + 1);
+                concat::place_file(src.toStdU16String(), part_dst.toStdU16String());
+                placed << QStringLiteral("%1 [%2, %3)")
+                              .arg(QFileInfo(part_dst).fileName())
+                              .arg(impl_::format_wall_time(std::chrono::duration<double>(parts[i].start)))
+                              .arg(impl_::format_wall_time(std::chrono::duration<double>(parts[i].end)));
+            }
+        } catch (std::exception &e) {
+            error = QString::fromLocal8Bit(e.what());
+        }
+        QMetaObject::invokeMethod(
+            this,
+            [this, error, placed] {
+                if (not error.isEmpty()) {
+                    this->tmpdir_->setAutoRemove(false);  // keep the parts so that they can be recovered manually
+                    QMessageBox::critical(this, tr("error"), tr("failed to write parts\n%1").arg(error));
+                }
+                this->process_->add_report(tr("split"), placed.join("\n"));
+                this->process_->finish();
+                this->cleanup_after_saving_(error.isEmpty() ? "succeeded" : "failed");
+            },
+            Qt::QueuedConnection);
+    });
+}
+void MainWindow::place_result_() {
+    enter_step_(__func__);
+    auto src = tmpfile_paths_.result;
+    auto dst = result_path_.toLocalFile();
+    auto is_fragmented = is_fragmented_output_();
+    auto is_append = append_mode_;
+    auto appendable = tmpdir_->filePath("appendable." + QFileInfo(dst).suffix());
+    auto chapters = mp4_chapters_();
+    QVector<QPair<QString, QString>> renditions;  // (src, dst)
+    for (auto i = 0; i < tmpfile_paths_.rendition_results.size(); i++) {
+        renditions.push_back({tmpfile_paths_.rendition_results[i],
+                              concat::rendition_path(dst, output_video_info_.renditions[i].name)});
+    }
+    auto copies = backup_paths_();
+    auto tee_backups = tmpfile_paths_.tee_backups;
+    auto writes_manifest = writes_manifest_();
+    QVector<concat::StreamHash> stream_hashes;
+    if (writes_manifest) {
+        QFile stream_hash_file(tmpfile_paths_.stream_hashes);
+        if (stream_hash_file.open(QIODevice::ReadOnly)) {
+            stream_hashes = concat::parse_stream_hashes(stream_hash_file.readAll());
+        }
+        if (stream_hashes.isEmpty()) {
+            auto button = QMessageBox::warning(
+                this, tr("stream hashes are missing"),
+                tr("failed to read stream hashes from [%1].\nDo you want to write the manifest without them?")
+                    .arg(tmpfile_paths_.stream_hashes),
+                QMessageBox::Yes | QMessageBox::Abort, QMessageBox::Abort);
+            if (button != QMessageBox::Yes) {
+                tmpdir_->setAutoRemove(false);
+                process_->add_report(tr("aborted"), tr("the result is kept in %1").arg(tmpdir_->path()));
+                process_->finish();
+                cleanup_after_saving_("failed");
+                return;
+            }
+        }
+    }
+    // copying may take long if tmpdir is on another filesystem, so this is done in a worker thread
+    QThreadPool::globalInstance()->start([this, src, dst, is_fragmented, is_append, appendable, chapters, renditions,
+                                          copies, tee_backups, writes_manifest, stream_hashes] {
+        QString error;
+        std::optional<concat::AppendResult> append_result = std::nullopt;
+        QStringList placed_renditions;
+        try {
+            if (is_append) {
+                append_result = concat::append_fragments(dst.toStdU16String(), src.toStdU16String(), chapters);
+            } else {
+                auto final_src = src;
+                std::optional<QString> sha256 = std::nullopt;
+                if (is_fragmented) {
+                    // the appendable rewrite is the only pass writing the final bytes in-process. backups are written
+                    // and the whole file is hashed as it is written
+                    QCryptographicHash hash(QCryptographicHash::Sha256);
+                    concat::write_to_all(impl_::to_paths(copies), [&](const concat::DataSink &sink) {
+                        auto on_data = [&](const char *data, std::size_t size) {
+                            hash.addData(QByteArrayView(data, static_cast<qsizetype>(size)));
+                            sink(data, size);
+                        };
+                        concat::write_appendable_mp4(src.toStdU16String(), appendable.toStdU16String(), chapters,
+                                                     on_data);
+                    });
+                    sha256 = QString::fromLatin1(hash.result().toHex());
+                    final_src = appendable;
+                } else {
+                    // written with the result by the tee muxer, which seeks back to finish each file. so the whole
+                    // file is not hashed, and the manifest relies on the hashes of the packets
+                    concat::commit_partials(impl_::to_paths(tee_backups));
+                }
+                auto size = std::filesystem::file_size(final_src.toStdU16String());
+                concat::place_file(final_src.toStdU16String(), dst.toStdU16String());
+                if (writes_manifest) {
+                    auto json = concat::manifest_json(
+                        concat::Manifest{QFileInfo(dst).fileName(), size, sha256, stream_hashes, copies});
+                    QStringList manifest_paths{concat::manifest_path(dst)};
+                    for (const auto &copy : copies) {
+                        manifest_paths << concat::manifest_path(copy);
+                    }
+                    for (const auto &manifest_path : manifest_paths) {
+                        QSaveFile manifest_file(manifest_path);
+                        if (not(manifest_file.open(QIODevice::WriteOnly) && manifest_file.write(json) == json.size() &&
+                                manifest_file.commit())) {
+                            throw std::runtime_error(
+                                tr("failed to write manifest [%1]").arg(manifest_path).toStdString());
+                        }
+                    }
+                }
+            }
+            for (const auto &[rendition_src, rendition_dst] : renditions) {
+                concat::place_file(rendition_src.toStdU16String(), rendition_dst.toStdU16String());
+                placed_renditions << rendition_dst;
+            }
+        } catch (std::exception &e) {
+            error = QString::fromLocal8Bit(e.what());
+        }
+        QMetaObject::invokeMethod(
+            this,
+            [this, src, error, append_result, placed_renditions, copies] {
+                if (not placed_renditions.isEmpty()) {
+                    this->process_->add_report(tr("renditions"), placed_renditions.join("\n"));
+                }
+                if (not copies.isEmpty()) {
+                    this->process_->add_report(tr("backups"), copies.join("\n"));
+                }
+                if (not error.isEmpty()) {
+                    this->tmpdir_->setAutoRemove(false);  // keep the result so that it can be recovered manually
+                    QMessageBox::critical(this, tr("error"),
+                                          tr("failed to write result [%1]\n%2").arg(src).arg(error));
+                } else if (append_result.has_value()) {
+                    this->process_->add_report(
+                        tr("append"), tr("%1 fragments (%2) were appended after %3")
+                                          .arg(append_result->fragment_count)
+                                          .arg(QLocale().formattedDataSize(append_result->appended_size))
+                                          .arg(impl_::format_wall_time(
+                                              std::chrono::duration<double>(append_result->previous_duration))));
+                }
+                this->cleanup_after_saving_(error.isEmpty() ? "succeeded" : "failed");
+            },
+            Qt::QueuedConnection);
+    });
+}
+void MainWindow::cleanup_after_saving_(const QString &result) {
+    enter_step_(__func__);
+    finish_staging_();
+    concat::remove_partials(impl_::to_paths(tmpfile_paths_.tee_backups));  // left unless they are placed
+    delete sample_estimator_;
+    sample_estimator_ = nullptr;
+    if (split_.pool != nullptr) {
+        split_.pool->deleteLater();  // this may be called in a handler of its signal
+        split_.pool = nullptr;
+    }
+    if (chapter_detection_.pool != nullptr) {
+        chapter_detection_.pool->kill_all();
+        chapter_detection_.pool->deleteLater();
+    }
+    chapter_detection_ = {};
+    if (loudness_.pool != nullptr) {
+        loudness_.pool->kill_all();
+        loudness_.pool->deleteLater();
+        loudness_.pool = nullptr;
+    }
     delete tmpdir_;
     tmpdir_ = nullptr;
+    finish_job_(result);
 }
-void MainWindow::start_saving_() {
+void MainWindow::enter_step_(const QString &name, std::optional<int> input) {
+    auto now = std::chrono::steady_clock::now();
+    if (job_.is_running && not job_.step.isEmpty()) {
+        metrics_.observe("video_concatenater_step_duration_seconds", {{"step", job_.step}},
+                         std::chrono::duration<double>(now - job_.step_started).count());
+    }
+    job_.step = name;
+    job_.step_started = now;
+    if (tracer_.has_value()) {
+        tracer_->step(name, input.has_value() ? QJsonObject{{"input", input.value()}} : QJsonObject());
+    }
+}
+void MainWindow::record_command_(const ProcessWidget::CommandRecord &record) {
+    auto program = QFileInfo(record.program).fileName();
+    std::chrono::duration<double> wall = record.finished - record.started;
+    metrics_.increment("video_concatenater_commands_total",
+                       {{"program", program}, {"result", record.is_success ? "succeeded" : "failed"}});
+    metrics_.observe("video_concatenater_command_duration_seconds", {{"program", program}}, wall.count());
+    if (record.usage.has_value()) {
+        metrics_.increment("video_concatenater_command_cpu_seconds_total", {{"program", program}},
+                           record.usage->cpu_seconds);
+        metrics_.increment("video_concatenater_command_read_bytes_total", {{"program", program}},
+                           static_cast<double>(record.usage->read_chars));
+        metrics_.increment("video_concatenater_command_written_bytes_total", {{"program", program}},
+                           static_cast<double>(record.usage->write_chars));
+    }
+    if (not tracer_.has_value()) {
+        return;
+    }
+    QJsonObject args{{"pid", record.process_id},
+                     {"arguments", QJsonArray::fromStringList(record.arguments)},
+                     {"success", record.is_success},
+                     {"wall_seconds", wall.count()}};
+    if (record.usage.has_value()) {
+        const auto &usage = record.usage.value();
+        args["cpu_seconds"] = usage.cpu_seconds;
+        args["cpu_utilization"] = wall.count() > 0 ? usage.cpu_seconds / wall.count() : 0.0;
+        args["rss_bytes"] = static_cast<qint64>(usage.rss_bytes);
+        args["read_chars"] = static_cast<qint64>(usage.read_chars);
+        args["write_chars"] = static_cast<qint64>(usage.write_chars);
+        args["read_bytes"] = static_cast<qint64>(usage.read_bytes);
+        args["write_bytes"] = static_cast<qint64>(usage.write_bytes);
+    }
+    tracer_->span(program, "command", record.started, record.finished,
+                  concat::Tracer::COMMANDS, args);
+}
+void MainWindow::write_trace_() {
+    if (not tracer_.has_value()) {
+        return;
+    }
+    auto directory = settings_->value("trace/directory").toString();
+    if (tracer_->write(directory).isEmpty()) {
+        qWarning() << "failed to write trace into" << directory;
+    }
+    tracer_ = std::nullopt;
+}
+void MainWindow::describe_metrics_() {
+    using Type = concat::Metrics::Type;
+    metrics_.describe("video_concatenater_start_time_seconds", Type::GAUGE,
+                      "Start time of the application since unix epoch in seconds.");
+    metrics_.set("video_concatenater_start_time_seconds", {}, QDateTime::currentSecsSinceEpoch());
+    metrics_.describe("video_concatenater_jobs_started_total", Type::COUNTER, "Saves which were started.");
+    metrics_.increment("video_concatenater_jobs_started_total", {}, 0);
+    metrics_.describe("video_concatenater_jobs_total", Type::COUNTER,
+                      "Saves which ended, by result (succeeded, failed, or abandoned before finishing).");
+    metrics_.describe("video_concatenater_job_duration_seconds", Type::HISTOGRAM,
+                      "Duration of saves from start to end.", DURATION_BUCKETS);
+    metrics_.describe("video_concatenater_job_running", Type::GAUGE, "1 while a save is running.");
+    metrics_.describe("video_concatenater_input_bytes_total", Type::COUNTER, "Size of inputs of succeeded saves.");
+    metrics_.describe("video_concatenater_output_bytes_total", Type::COUNTER, "Size of results of succeeded saves.");
+    metrics_.describe("video_concatenater_step_duration_seconds", Type::HISTOGRAM,
+                      "Duration of each step of saves, including time waiting for dialogs.", DURATION_BUCKETS);
+    metrics_.describe("video_concatenater_commands_total", Type::COUNTER,
+                      "Commands run in the process window, by program and result.");
+    metrics_.describe("video_concatenater_command_duration_seconds", Type::HISTOGRAM,
+                      "Wall time of commands run in the process window.", DURATION_BUCKETS);
+    metrics_.describe("video_concatenater_command_cpu_seconds_total", Type::COUNTER,
+                      "CPU time of commands run in the process window.");
+    metrics_.describe("video_concatenater_command_read_bytes_total", Type::COUNTER,
+                      "Bytes read by commands run in the process window, including pipes and network filesystems.");
+    metrics_.describe("video_concatenater_command_written_bytes_total", Type::COUNTER,
+                      "Bytes written by commands run in the process window.");
+    metrics_.describe("video_concatenater_probe_cache_requests_total", Type::COUNTER,
+                      "Inputs whose probe was reused from the input list (hit) or run again (miss).");
+    metrics_.describe("video_concatenater_concatenated_streams_total", Type::COUNTER,
+                      "Streams of concatenations, by stream and mode (copy or encode).");
+    metrics_.describe("video_concatenater_pending_commands", Type::GAUGE,
+                      "Background commands (chapter detection, loudness, chapter export) waiting to run.");
+    metrics_.describe("video_concatenater_running_commands", Type::GAUGE, "Background commands running.");
+}
+void MainWindow::finish_job_(const QString &result) {
+    if (not job_.is_running) {
+        return;
+    }
+    job_.is_running = false;
+    auto now = std::chrono::steady_clock::now();
+    if (not job_.step.isEmpty()) {
+        metrics_.observe("video_concatenater_step_duration_seconds", {{"step", job_.step}},
+                         std::chrono::duration<double>(now - job_.step_started).count());
+    }
+    metrics_.increment("video_concatenater_jobs_total", {{"result", result}});
+    metrics_.observe("video_concatenater_job_duration_seconds", {},
+                     std::chrono::duration<double>(now - job_.started).count());
+    if (result == "succeeded") {
+        qint64 input_bytes = 0;
+        for (const auto &file_info : file_infos_) {
+            input_bytes += QFileInfo(file_info.path).size();
+        }
+        auto dst = result_path_.toLocalFile();
+        qint64 output_bytes = QFileInfo(dst).size();
+        if (is_split_output_()) {
+            for (auto i = 1; QFileInfo::exists(concat::part_path(dst, i)); i++) {
+                output_bytes += QFileInfo(concat::part_path(dst, i)).size();
+            }
+        }
+        metrics_.increment("video_concatenater_input_bytes_total", {}, static_cast<double>(input_bytes));
+        metrics_.increment("video_concatenater_output_bytes_total", {}, static_cast<double>(output_bytes));
+    }
+    write_metrics_();
+    write_trace_();
+}
+void MainWindow::write_metrics_() {
+    auto path = settings_->value("metrics/textfile").toString();
+    if (path.isEmpty()) {
+        return;
+    }
+    auto pending = 0;
+    auto running = 0;
+    for (auto pool : {split_.pool, chapter_detection_.pool, loudness_.pool}) {
+        if (pool != nullptr) {
+            pending += pool->pending_count();
+            running += pool->running_count();
+        }
+    }
+    metrics_.set("video_concatenater_job_running", {}, job_.is_running ? 1 : 0);
+    metrics_.set("video_concatenater_pending_commands", {}, pending);
+    metrics_.set("video_concatenater_running_commands", {}, running);
+    if (not metrics_.write(path)) {
+        qWarning() << "failed to write metrics into" << path;
+    }
+}
+void MainWindow::open_preview_() {
+    QVector<concat::PreviewInput> inputs;
+    for (auto i = 0; i < input_files_->rowCount(); i++) {
+        const auto &entry = input_files_->entry(i);
+        if (entry.state != InputFileModel::Entry::State::DONE || not entry.duration.has_value()) {
+            QMessageBox::warning(
+                this, tr("preview"),
+                tr("durations of some inputs are unknown yet (or failed to probe)\n%1").arg(entry.path));
+            return;
+        }
+        auto format = entry.probe["format"].toObject();
+        inputs.push_back({entry.path, entry.duration.value(), format["start_time"].toString().toDouble(),
+                          entry.in_point, entry.out_point, entry.probe["chapters"].toArray()});
+    }
+    auto preview = new PreviewWidget(concat::build_preview_timeline(inputs), this, Qt::Window);
+    preview->setAttribute(Qt::WA_DeleteOnClose, true);
+    preview->show();
+}
+void MainWindow::split_by_chapters_() {
+    auto filename = QFileDialog::getOpenFileName(this, tr("open video file to split"),
+                                                 read_video_dir_cache_().toLocalFile(), tr("Videos (*.mp4 *.ts)"));
+    if (filename.isEmpty()) {
+        return;
+    }
+    show_process_();
+    create_tmpdir_(filename);
+    split_ = {};
+    split_.source = filename;
+    tmpfile_paths_.metadata = tmpdir_->filePath("chapters.txt");
+    retrieve_metadata_(split_.source, tmpfile_paths_.metadata, [=] { this->probe_chapter_keyframes_(); });
+}
+void MainWindow::probe_chapter_keyframes_() {
+    decltype(retrieve_chapters_("")) chapters;
+    try {
+        chapters = retrieve_chapters_(tmpfile_paths_.metadata);
+    } catch (std::exception &e) {
+        QMessageBox::critical(this, tr("error"), QString::fromStdString(e.what()));
+        process_->finish();
+        cleanup_after_saving_("failed");
+        return;
+    }
+    if (chapters.isEmpty()) {
+        QMessageBox::critical(this, tr("no chapters"), tr("[%1] has no chapters").arg(split_.source));
+        process_->finish();
+        cleanup_after_saving_("failed");
+        return;
+    }
+    QVector<double> boundaries;
+    for (const auto &chapter : chapters) {
+        auto timebase = static_cast<double>(chapter.timebase_numerator) / chapter.timebase_denominator;
+        split_.parts.push_back({chapter.start_time * timebase, chapter.end_time * timebase, chapter.title});
+        boundaries << chapter.start_time * timebase;
+    }
+    std::sort(split_.parts.begin(), split_.parts.end(),
+              [](const auto &lhs, const auto &rhs) { return lhs.start < rhs.start; });
+    process_->start("ffprobe", concat::boundary_probe_arguments(split_.source, boundaries), false);
+    connect(process_, &ProcessWidget::finished, this, impl_::OnTrue([=] { this->name_chapter_parts_(); }),
+            impl_::ONESHOT_AUTO_CONNECTION);
+}
+void MainWindow::name_chapter_parts_() {
+    split_.parts = concat::snap_to_keyframes(split_.parts, concat::parse_keyframes(process_->get_stdout().toUtf8()));
+    for (auto i = 0; i < split_.parts.size(); i++) {
+        split_.names << concat::chapter_file_name(split_.source, i + 1, split_.parts.size(), split_.parts[i].title);
+    }
+    if (split_.parts.isEmpty()) {
+        QMessageBox::critical(this, tr("no chapters"), tr("all chapters of [%1] are empty").arg(split_.source));
+        process_->finish();
+        cleanup_after_saving_("failed");
+        return;
+    }
+    split_.pool = new ProcessPool(QThread::idealThreadCount(), this);
+    if (not settings_->contains("savefile_name_plugin") || settings_->value("savefile_name_plugin") == NO_PLUGIN) {
+        export_chapter_parts_();
+        return;
+    }
+    // the plugin converts the default name of each part as it does for the result of concatenation
+    auto plugin = savefile_name_plugins_dir_().absoluteFilePath(settings_->value("savefile_name_plugin").toString());
+    connect(
+        split_.pool, &ProcessPool::all_finished, this, [this] { this->export_chapter_parts_(); },
+        impl_::ONESHOT_AUTO_CONNECTION);
+    process_->show_status(tr("generating names of %1 parts").arg(split_.parts.size()));
+    for (auto i = 0; i < split_.parts.size(); i++) {
+        split_.pool->enqueue(PYTHON, {plugin, split_.names[i]}, [this, i](const ProcessPool::Result &result) {
+            auto name = QString::fromUtf8(result.stdout_data).trimmed();
+            if (result.is_success && not name.isEmpty()) {
+                split_.names[i] = name;
+            } else {
+                split_.errors << tr("savefile name plugin failed for %1 (exit code %2)")
+                                     .arg(split_.names[i])
+                                     .arg(result.exit_code);
+            }
+        });
+    }
+}
+void MainWindow::export_chapter_parts_() {
+    auto dir = QFileInfo(split_.source).absoluteDir();
+    QStringList existing;
+    for (const auto &name : split_.names) {
+        if (QFile::exists(dir.filePath(name))) {
+            existing << name;
+        }
+    }
+    if (not existing.isEmpty()) {
+        auto button = QMessageBox::warning(
+            this, tr("overwrite"),
+            tr("following files already exist. Are you sure you want to OVERWRITE them?\n%1").arg(existing.join("\n")),
+            QMessageBox::Yes | QMessageBox::Abort, QMessageBox::Abort);
+        if (button != QMessageBox::Yes) {
+            process_->finish();
+            cleanup_after_saving_("abandoned");
+            return;
+        }
+    }
+    // parts are stream-copied concurrently. each job reads only its own range of the source
+    auto suffix = QFileInfo(split_.source).suffix();
+    split_.exported.fill(false, split_.parts.size());
+    split_.finished_count = 0;
+    connect(
+        split_.pool, &ProcessPool::all_finished, this, [this] { this->place_chapter_parts_(); },
+        impl_::ONESHOT_AUTO_CONNECTION);
+    process_->show_status(tr("exporting %1 chapters").arg(split_.parts.size()));
+    for (auto i = 0; i < split_.parts.size(); i++) {
+        auto tmpfile = tmpdir_->filePath(QStringLiteral("chapter%1.%2").arg(i).arg(suffix));
+        split_.pool->enqueue("ffmpeg", concat::chapter_export_arguments(split_.source, split_.parts[i], tmpfile),
+                             [this, i](const ProcessPool::Result &result) {
+                                 split_.finished_count++;
+                                 split_.exported[i] = result.is_success;
+                                 if (not result.is_success) {
+                                     split_.errors << tr("failed to export chapter %1 (exit code %2)")
+                                                          .arg(i + 1)
+                                                          .arg(result.exit_code);
+                                 }
+                                 process_->show_status(tr("exported %1/%2 chapters")
+                                                           .arg(split_.finished_count)
+                                                           .arg(split_.parts.size()));
+                             });
+    }
+}
+void MainWindow::place_chapter_parts_() {
+    auto dir = QFileInfo(split_.source).absoluteDir();
+    auto suffix = QFileInfo(split_.source).suffix();
+    auto tmpdir = QDir(tmpdir_->path());
+    auto split = split_;
+    split.pool = nullptr;  // not touched from the worker
+    QThreadPool::globalInstance()->start([this, dir, suffix, tmpdir, split] {
+        auto errors = split.errors;
+        QStringList placed;
+        for (auto i = 0; i < split.parts.size(); i++) {
+            if (not split.exported[i]) {
+                continue;
+            }
+            auto src = tmpdir.filePath(QStringLiteral("chapter%1.%2").arg(i).arg(suffix));
+            auto dst = dir.filePath(split.names[i]);
+            try {
+                concat::place_file(src.toStdU16String(), dst.toStdU16String());
+                placed << QStringLiteral("%1 [%2, %3)")
+                              .arg(split.names[i])
+                              .arg(concat::format_time(split.parts[i].start))
+                              .arg(concat::format_time(split.parts[i].end));
+            } catch (std::exception &e) {
+                errors << tr("failed to write %1\n%2").arg(dst).arg(QString::fromLocal8Bit(e.what()));
+            }
+        }
+        QMetaObject::invokeMethod(
+            this,
+            [this, placed, errors] {
+                this->process_->add_report(tr("split by chapters"), placed.join("\n"));
+                if (not errors.isEmpty()) {
+                    this->tmpdir_->setAutoRemove(false);  // keep the parts so that they can be recovered manually
+                    QMessageBox::critical(this, tr("error"), errors.join("\n"));
+                }
+                this->process_->show_status(tr("%1 chapters were exported").arg(placed.size()));
+                this->process_->finish();
+                this->cleanup_after_saving_(errors.isEmpty() ? "succeeded" : "failed");
+            },
+            Qt::QueuedConnection);
+    });
+}
+void MainWindow::show_process_() {
     process_ = new ProcessWidget(this, Qt::Window | Qt::CustomizeWindowHint | Qt::WindowMinMaxButtonsHint);
     process_->setWindowModality(Qt::WindowModal);
     process_->setAttribute(Qt::WA_DeleteOnClose, true);
     process_->show();
-
+}
+void MainWindow::create_tmpdir_(const QString &dst_filepath) {
     if (settings_->contains("temporary_directory_template")) {
         tmpdir_ = new QTemporaryDir(settings_->value("temporary_directory_template").toString());
     } else {
-        tmpdir_ = new QTemporaryDir();
+        // on the filesystem of the result, result can be placed by rename() instead of copying
+        auto dstdir = QFileInfo(dst_filepath).absoluteDir();
+        tmpdir_ = new QTemporaryDir(dstdir.filePath(".video_concatenater-XXXXXX"));
+        if (not tmpdir_->isValid()) {
+            delete tmpdir_;
+            tmpdir_ = new QTemporaryDir();
+        }
+    }
+}
+void MainWindow::start_saving_() {
+    // left by a previous run which failed or was cancelled
+    finish_job_("abandoned");
+    if (not settings_->value("trace/directory").toString().isEmpty()) {
+        tracer_.emplace(QStringLiteral("save"));
     }
+    job_.is_running = true;
+    job_.started = std::chrono::steady_clock::now();
+    job_.step.clear();
+    metrics_.increment("video_concatenater_jobs_started_total");
+    enter_step_(__func__);
+    append_mode_ = false;
+    inputs_are_normalized_ = false;
+    transport_streams_are_joinable_ = std::nullopt;
+    finish_staging_();  // left by a previous run which failed
+    tmpfile_paths_ = {};
+    show_process_();
+    connect(process_, &ProcessWidget::command_finished, this, &MainWindow::record_command_);
+    connect(process_, &ProcessWidget::finished, this, [this](bool is_success) {
+        if (not is_success) {
+            this->finish_job_("failed");
+        }
+    });
+    // a save cancelled from a dialog ends when its window is closed
+    job_.window_closed = connect(process_, &QObject::destroyed, this, [this] { this->finish_job_("abandoned"); });
+    create_tmpdir_(input_files_->path(0));
     file_infos_.clear();
     current_index_ = 0;
-    show_size_();
+    start_chapter_detection_();
+    create_savefile_name_();
+}
+void MainWindow::start_chapter_detection_() {
+    if (chapter_detection_.pool != nullptr) {  // left by a previous run which failed
+        chapter_detection_.pool->kill_all();
+        chapter_detection_.pool->deleteLater();
+    }
+    chapter_detection_ = {};
+    if (not settings_->value("detect_chapters", false).toBool()) {
+        return;
+    }
+    auto pool = new ProcessPool(QThread::idealThreadCount(), this);
+    chapter_detection_.pool = pool;
+    concat::DetectionParams params;  // the same as in analyze_chapter_detection_()
+    auto window_size = static_cast<std::size_t>(params.envelope_window * concat::DETECTION_SAMPLE_RATE);
+    for (auto i = 0; i < input_files_->rowCount(); i++) {
+        const auto &entry = input_files_->entry(i);
+        // the count is unknown if probing has not finished. such inputs are analyzed just in case
+        if (entry.chapter_count.value_or(0) > 0 || chapter_detection_.inputs.contains(entry.path)) {
+            continue;
+        }
+        auto path = entry.path;
+        chapter_detection_.inputs[path].duration = entry.duration.value_or(0);
+        // a failed process (e.g. no audio stream) leaves its data empty, and the other one is used alone
+        pool->enqueue("ffmpeg", concat::keyframe_arguments(path), [=](const ProcessPool::Result &result) {
+            auto &detection = this->chapter_detection_.inputs[path];
+            if (result.is_success) {
+                detection.frames = result.stdout_data;
+                detection.frame_log = result.stderr_data;
+            }
+            if (++detection.finished_count == 2) {
+                this->analyze_chapter_detection_(path);
+            }
+        });
+        // samples are reduced to the envelope as they arrive, so that the audio of a whole input is never kept
+        auto envelope = std::make_shared<concat::EnvelopeAccumulator>(window_size);
+        pool->enqueue(
+            "ffmpeg", concat::envelope_arguments(path),
+            [=](const ProcessPool::Result &result) {
+                auto &detection = this->chapter_detection_.inputs[path];
+                if (result.is_success) {
+                    detection.envelope = envelope->envelope();
+                }
+                if (++detection.finished_count == 2) {
+                    this->analyze_chapter_detection_(path);
+                }
+            },
+            [envelope](const QByteArray &data) {
+                envelope->add(data.constData(), static_cast<std::size_t>(data.size()));
+            });
+    }
+}
+void MainWindow::analyze_chapter_detection_(const QString &path) {
+    auto detection = chapter_detection_.inputs.value(path);  // raw data is shared, not copied
+    auto pool = chapter_detection_.pool;
+    QThreadPool::globalInstance()->start([=] {
+        auto times = concat::parse_frame_times(detection.frame_log);
+        // audio is taken to start with the first keyframe
+        auto first = times.empty() ? 0.0 : times.front();
+        for (auto &time : times) {
+            time -= first;
+        }
+        auto scores = concat::scene_scores(reinterpret_cast<const std::uint8_t *>(detection.frames.constData()),
+                                           detection.frames.size() / concat::DETECTION_FRAME_SIZE);
+        concat::DetectionParams params;
+        const auto &envelope = detection.envelope;
+        auto duration = detection.duration;
+        if (duration <= 0) {
+            duration = std::max(times.empty() ? 0.0 : times.back(), envelope.size() * params.envelope_window);
+        }
+        auto boundaries = concat::propose_boundaries(times, scores, envelope, duration, params);
+        QMetaObject::invokeMethod(
+            this,
+            [=] {
+                if (this->chapter_detection_.pool != pool) {  // another run has started
+                    return;
+                }
+                auto &stored = this->chapter_detection_.inputs[path];
+                stored = {};
+                stored.boundaries = boundaries;
+                if (this->chapter_detection_.on_detected) {
+                    auto on_detected = std::move(this->chapter_detection_.on_detected);
+                    this->chapter_detection_.on_detected = nullptr;
+                    on_detected();
+                }
+            },
+            Qt::QueuedConnection);
+    });
 }
 void MainWindow::save_result_() {
-    if (ui_->listWidget_filenames->count() == 0) {
+    if (input_files_->rowCount() == 0) {
         return;
     }
     start_saving_();
@@ -3,17 +3,40 @@
 
 #include <QAudioOutput>
 #include <QDir>
+#include <QHash>
+#include <QJsonObject>
 #include <QMainWindow>
 #include <QMap>
 #include <QMediaPlayer>
+#include <QMessageBox>
+#include <QPointer>
 #include <QSettings>
 #include <QTemporaryDir>
+#include <QTimer>
 #include <QUrl>
 #include <chrono>
+#include <functional>
+#include <memory>
 #include <optional>
 #include <tuple>
 
+#include "chapterdetect.hpp"
+#include "chaptersplit.hpp"
+#include "copysafety.hpp"
+#include "inputfilemodel.hpp"
+#include "joinrepair.hpp"
+#include "loudness.hpp"
+#include "metrics.hpp"
+#include "preflight.hpp"
+#include "processpool.hpp"
 #include "processwidget.hpp"
+#include "sampleestimator.hpp"
+#include "splitoutput.hpp"
+#include "staging.hpp"
+#include "thumbnailprovider.hpp"
+#include "tracer.hpp"
+#include "transcodecache.hpp"
+#include "trim.hpp"
 #include "videoinfo.hpp"
 #include "videoinfowidget.hpp"
 
@@ -37,21 +60,36 @@ class MainWindow : public QMainWindow {
     void update_animation_duration();
 
     void open_video_();
+    void split_by_chapters_();
+    void open_preview_();
     void save_result_();
     void select_default_chaptername_plugin_();
     void select_savefile_name_plugin_();
     void edit_default_video_info_();
+    void edit_backup_destinations_();
+    void update_transcode_cache_size_();
+    void edit_staging_directory_();
+    void edit_trace_directory_();
+    void edit_metrics_file_();
 
    private:
     Ui::MainWindow *ui_;
     VideoInfoWidget *video_info_widget_;  // deleted when this(MainWindow) is deleted
     ProcessWidget *process_ = nullptr;    // deleted on close
     QSettings *settings_ = nullptr;
+    InputFileModel *input_files_;              // deleted when this(MainWindow) is deleted
+    ThumbnailProvider *thumbnails_;            // deleted when this(MainWindow) is deleted
+    InputFileProxyModel *input_files_proxy_;  // deleted when this(MainWindow) is deleted
     struct FileInfo {
         QString path;
         using seconds = std::chrono::duration<double>;
         seconds duration;
         concat::VideoInfo video_info;
+        concat::StreamParams video_stream;
+        concat::StreamParams audio_stream;
+        std::optional<concat::SegmentTiming> timing;  // std::nullopt if durations of streams are unknown
+        concat::SegmentPlan segment;
+        QString concat_path;  // path written in concat list. differs from path if input is remuxed beforehand
         struct ChapterInfo {
             qint32 timebase_numerator;
             qint32 timebase_denominator;
@@ -60,10 +98,14 @@ class MainWindow : public QMainWindow {
             QString title;
         };
         QVector<ChapterInfo> chapters;
+        std::optional<concat::TrimCut> cut;  // std::nullopt if the input is not trimmed
+        QString head_path;                   // re-encoded [in point, first keyframe). empty if not needed
+        QString tail_path;                   // re-encoded [last keyframe, out point). empty if not needed
     };
     QVector<FileInfo> file_infos_;
     FileInfo current_file_info_;
     concat::VideoInfo output_video_info_;
+    concat::CopyAnalysis copy_analysis_;
     std::chrono::duration<int, std::milli> total_length_;
     std::optional<QString> chaptername_plugin_ = std::nullopt;
     static constexpr auto NO_PLUGIN = "do not use any plugins";
@@ -77,9 +119,72 @@ class MainWindow : public QMainWindow {
         QString concatenated;
         QString metadata;
         QString current_src_metadata;
+        QString result;
+        QString segment_list;  // csv written by segment muxer if output is split
+        QStringList rendition_results;  // written with result. index is that of VideoInfo::renditions
+        QString stream_hashes;          // written by the tee muxer if manifest is written
+        QStringList tee_backups;        // backups whose partial files are written with the result by the tee muxer
     } tmpfile_paths_;
     int current_index_ = 0;
     QTemporaryDir *tmpdir_ = nullptr;
+    std::optional<concat::PreflightResult> preflight_result_;
+    std::optional<SampleEstimator::Estimate> sample_estimate_;
+    QPointer<QMessageBox> preflight_box_;
+    struct {
+        QString source;
+        QVector<concat::ChapterPart> parts;
+        QStringList names;  // file names of parts, in the directory of the source
+        QVector<bool> exported;
+        int finished_count = 0;
+        QStringList errors;
+        ProcessPool *pool = nullptr;  // deleted in cleanup_after_saving_()
+    } split_;
+    struct ChapterDetection {
+        QByteArray frames;             // concat::DETECTION_FRAME_SIZE bytes per keyframe
+        QByteArray frame_log;          // stderr of ffmpeg with the timestamp of each keyframe
+        std::vector<double> envelope;  // concat::rms_envelope() of the audio
+        double duration = 0;           // seconds. 0 if unknown
+        int finished_count = 0;        // of the two processes
+        std::optional<std::vector<double>> boundaries;  // seconds from the start of the file. set when analyzed
+    };
+    struct {
+        ProcessPool *pool = nullptr;              // deleted in cleanup_after_saving_()
+        QHash<QString, ChapterDetection> inputs;  // by path. inputs which have chapters are not analyzed
+        std::function<void(void)> on_detected;    // create_chapter_() waiting for its input
+    } chapter_detection_;
+    struct {
+        ProcessPool *pool = nullptr;  // deleted when all inputs are measured
+        QVector<std::optional<double>> integrated;  // LUFS of each input
+        int finished_count = 0;
+        QVector<double> gains;  // dB applied to each input while concatenating. empty if audio is not normalized
+    } loudness_;
+    std::optional<concat::TranscodeCache> transcode_cache_;  // set while inputs are normalized through the cache
+    QStringList normalize_keys_;                              // cache key of each input
+    QStringList normalize_report_;
+    bool inputs_are_normalized_ = false;  // concat_path of every input is an intermediate matching the output
+    std::optional<bool> transport_streams_are_joinable_ = std::nullopt;  // set by check_transport_streams_()
+    struct {
+        bool is_prepared = false;  // start_staging_() was called for this concatenation
+        bool is_started = false;   // the first input is staged and ffmpeg reads staged inputs
+        std::unique_ptr<concat::Stager> stager;
+        QTemporaryDir *dir = nullptr;
+        QTimer *timer = nullptr;
+        QVector<int> index_of_input;  // index in stager of each input. -1 if the input is not staged
+        int position = -1;            // staged input which ffmpeg reads
+        bool is_paused = false;       // ffmpeg is stopped until the next input is staged
+    } staging_;
+    bool append_mode_ = false;  // new inputs are appended to result_path_ as fragments
+    SampleEstimator *sample_estimator_ = nullptr;  // deleted when this(MainWindow) is deleted
+    std::optional<concat::Tracer> tracer_;          // set while saving if a trace directory is configured
+    concat::Metrics metrics_;
+    QTimer *metrics_timer_;  // deleted when this(MainWindow) is deleted
+    struct {
+        bool is_running = false;  // between start_saving_() and the end of the save
+        std::chrono::steady_clock::time_point started;
+        QString step;  // current step. empty until the first step
+        std::chrono::steady_clock::time_point step_started;
+        QMetaObject::Connection window_closed;  // ends the save when the process window is closed
+    } job_;
 
     QDir chaptername_plugins_dir_();
     QStringList search_chapternames_plugins_();
@@ -93,27 +198,99 @@ class MainWindow : public QMainWindow {
 
     QVector<MainWindow::FileInfo::ChapterInfo> retrieve_chapters_(QString src_filename);
 
+    void show_process_();
+    void create_tmpdir_(const QString &dst_filepath);
+    // steps for splitting a file by chapters
+    void probe_chapter_keyframes_();
+    void name_chapter_parts_();
+    void export_chapter_parts_();
+    void place_chapter_parts_();
+    // end steps
+
     // steps for creating and saving result
     void start_saving_();
-    void show_size_();
+    void start_chapter_detection_();  // runs on a ProcessPool while inputs are probed one by one
+    void analyze_chapter_detection_(const QString &path);
     void create_savefile_name_();
     void confirm_savefile_name_();
     void confirm_chaptername_plugin_();
     // iterate through all files
     void probe_for_duration_();
     void register_duration_();
+    void register_probe_result_(const QJsonObject &probe_result);
+    void probe_keyframes_();  // called if the input is trimmed
+    void register_keyframes_();
     /* call retrieve_metadata_()*/
     void check_metadata_();
     void create_chapter_();          // called if no chapters are found in metadata
     void register_chapter_title_();  // called if the title of the chapter is generated by plugin
+    void name_created_chapters_(const QString &title);
     void register_file_info_();
     // end iteration
     void confirm_video_info_();
     void confirm_chaptername_();
+    void analyze_copy_safety_();
+    void show_size_();  // with the confirmed output, before anything is encoded
+    void update_preflight_box_();
+    void measure_loudness_();  // measures all inputs concurrently if audio is normalized
+    void register_loudness_();
+    // iterate through all trimmed files
+    void render_cut_points_();
+    // end iteration
+    void normalize_inputs_();  // called if the transcode cache is enabled and inputs have to be encoded
+    // iterate through all files if inputs are normalized
+    void normalize_next_input_();
+    // end iteration
+    // iterate through all files if parameter sets have to be carried in-band
+    void remux_to_annexb_();
+    // end iteration
+    struct OutputChanges {
+        bool resolution;
+        bool audio_codec;
+        bool video_codec;
+
+        bool any() const { return resolution || audio_codec || video_codec; }
+    };
+    OutputChanges output_changes_();
+    QStringList codec_arguments_(const OutputChanges &changes);  // "-c:a", "-c:v" and "-s" of the encode
+    QString transcode_cache_directory_();
+    bool stages_inputs_();
+    void start_staging_();  // called from concatenate_videos_(), which is called again once the first input is staged
+    void watch_staging_();
+    void finish_staging_();
     void concatenate_videos_();
+    bool may_join_transport_streams_();  // checks which need no I/O
+    void check_transport_streams_();     // reads the inputs in a worker thread, then calls concatenate_videos_() again
+    void join_transport_streams_();  // instead of concatenate_videos_() for compatible MPEG-TS inputs
     void retrieve_metadata_(QString src_filepath, QString dst_filepath, std::function<void(void)> on_success);
-    void add_chapters_();
-    void cleanup_after_saving_();
+    void render_part_(const FileInfo &file_info, double from, double to, QString dst_filepath,
+                      std::function<void(void)> on_success);
+    bool write_chapter_metadata_();  // ffmetadata of chapters of all inputs. shows an error otherwise
+    QStringList chapter_arguments_();  // output options of the result that take chapters from the second input
+    void remux_joined_stream_();        // after join_transport_streams_()
+    void add_tee_chapters_();           // chpl of the outputs of the tee muxer, which passes no chapters
+    void validate_result_();  // reads only the header of the result
+    void register_validation_();
+    bool is_fragmented_output_();
+    std::vector<concat::Mp4Chapter> mp4_chapters_() const;
+    bool check_chapter_count_();  // chapters fit in the chpl written by placement. asks or shows an error otherwise
+    void place_result_();
+    bool is_split_output_();
+    bool has_renditions_();
+    bool confirm_extra_outputs_();  // asks before skipping backups of parts or overwriting files next to the result
+    bool writes_manifest_();
+    QStringList backup_paths_();  // where the result is copied. empty in append mode
+    bool writes_tee_output_();    // backups and stream hashes are written with the result by the tee muxer
+    void place_parts_();  // instead of validate_result_() and place_result_() if output is split
+    void cleanup_after_saving_(const QString &result);  // result of the save as of finish_job_()
     // end steps
+
+    void enter_step_(const QString &name, std::optional<int> input = std::nullopt);  // ends the previous step
+    void record_command_(const ProcessWidget::CommandRecord &record);
+    void write_trace_();
+    void describe_metrics_();
+    // "succeeded", "failed" or "abandoned". ignored unless saving. writes the trace of the save
+    void finish_job_(const QString &result);
+    void write_metrics_();
 };
 #endif  // MAINWINDOW_H
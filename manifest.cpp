@@ -0,0 +1,61 @@
+#include "manifest.hpp"
+
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <ciso646>
+
+namespace concat {
+namespace {
+constexpr auto HASH_ALGORITHM = "sha256";
+}  // namespace
+QString tee_output(const QVector<QPair<QString, QString>> &options, const QString &path) {
+    QStringList assignments;
+    for (const auto &[key, value] : options) {
+        assignments << key + "=" + value;
+    }
+    // quoted, so that '|', ':' and '\' in paths (e.g. "C:\") are not parsed by the tee muxer
+    auto quoted = "'" + QString(path).replace("'", "'\\''") + "'";
+    return "[" + assignments.join(":") + "]" + quoted;
+}
+QString stream_hash_output(const QString &dst) {
+    return tee_output({{"f", "streamhash"}, {"hash", HASH_ALGORITHM}}, dst);
+}
+QVector<StreamHash> parse_stream_hashes(const QByteArray &text) {
+    QVector<StreamHash> result;
+    for (const auto &line : text.split('\n')) {
+        // e.g. "0,v,SHA256=0123..."
+        auto fields = line.trimmed().split(',');
+        if (fields.size() != 3) {
+            continue;
+        }
+        auto separator = fields[2].indexOf('=');
+        bool ok;
+        auto index = fields[0].toInt(&ok);
+        if (not ok || separator < 0) {
+            continue;
+        }
+        result.push_back({index, QString::fromLatin1(fields[1]), QString::fromLatin1(fields[2].left(separator)),
+                          QString::fromLatin1(fields[2].mid(separator + 1))});
+    }
+    return result;
+}
+QByteArray manifest_json(const Manifest &manifest) {
+    QJsonArray streams;
+    for (const auto &stream : manifest.streams) {
+        streams.append(QJsonObject{{"index", stream.index},
+                                   {"type", stream.type},
+                                   {"algorithm", stream.algorithm},
+                                   {"hash", stream.hash}});
+    }
+    QJsonObject root{{"file", manifest.file},
+                     {"size", static_cast<qint64>(manifest.size)},
+                     {"streams", streams},
+                     {"copies", QJsonArray::fromStringList(manifest.copies)}};
+    if (manifest.sha256.has_value()) {
+        root.insert(HASH_ALGORITHM, manifest.sha256.value());
+    }
+    return QJsonDocument(root).toJson();
+}
+QString manifest_path(const QString &result_path) { return result_path + ".manifest.json"; }
+}  // namespace concat
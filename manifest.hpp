@@ -0,0 +1,46 @@
+#ifndef VIDEO_CONCATENATER_MANIFEST
+#define VIDEO_CONCATENATER_MANIFEST
+
+#include <QByteArray>
+#include <QPair>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <cstdint>
+#include <optional>
+
+namespace concat {
+/**
+ * @brief hash of packets of a stream, as written by ffmpeg's streamhash muxer
+ */
+struct StreamHash {
+    int index;
+    QString type;  // "v", "a", ...
+    QString algorithm;
+    QString hash;
+};
+/**
+ * @brief an output of ffmpeg's tee muxer, e.g. "[f=mp4]'/path/to/file.mp4'"
+ * @param options options of the output, such as "f" (format). values must not contain ':'
+ */
+QString tee_output(const QVector<QPair<QString, QString>> &options, const QString &path);
+/**
+ * @brief an output of ffmpeg's tee muxer which hashes packets of every stream as they are muxed
+ * @details Packets are hashed while the result is written, so the result is not read back to hash them.
+ */
+QString stream_hash_output(const QString &dst);
+QVector<StreamHash> parse_stream_hashes(const QByteArray &text);
+struct Manifest {
+    QString file;  // file name of the result
+    std::uintmax_t size;
+    std::optional<QString> sha256;  // of whole file. only if it is written in-process, not by a seeking muxer
+    QVector<StreamHash> streams;
+    QStringList copies;  // absolute paths of backups
+};
+QByteArray manifest_json(const Manifest &manifest);
+/**
+ * @brief "<result path>.manifest.json"
+ */
+QString manifest_path(const QString &result_path);
+}  // namespace concat
+#endif
@@ -0,0 +1,100 @@
+#include "metrics.hpp"
+
+#include <QSaveFile>
+#include <QTextStream>
+#include <algorithm>
+#include <ciso646>
+#include <cmath>
+
+namespace concat {
+namespace {
+QString escape_label_value(QString value) {
+    return value.replace('\\', "\\\\").replace('"', "\\\"").replace('\n', "\\n");
+}
+QString format_labels(const Metrics::Labels &labels) {
+    QStringList pairs;
+    for (const auto &[name, value] : labels) {
+        pairs << QStringLiteral(R"(%1="%2")").arg(name, escape_label_value(value));
+    }
+    return pairs.join(",");
+}
+QString format_value(double value) {
+    if (std::isinf(value)) {
+        return value > 0 ? "+Inf" : "-Inf";
+    }
+    return QString::number(value, 'g', 15);
+}
+// "name{labels}" or "name" if there are no labels
+QString format_sample_name(const QString &name, const QString &labels) {
+    return labels.isEmpty() ? name : QStringLiteral("%1{%2}").arg(name, labels);
+}
+}  // namespace
+void Metrics::describe(const QString &name, Type type, const QString &help, const QVector<double> &buckets) {
+    families_[name] = {type, help, buckets, {}};
+}
+void Metrics::increment(const QString &name, const Labels &labels, double value) {
+    auto family = families_.find(name);
+    if (family != families_.end() && family->type == Type::COUNTER) {
+        family->series[format_labels(labels)].value += value;
+    }
+}
+void Metrics::set(const QString &name, const Labels &labels, double value) {
+    auto family = families_.find(name);
+    if (family != families_.end() && family->type == Type::GAUGE) {
+        family->series[format_labels(labels)].value = value;
+    }
+}
+void Metrics::observe(const QString &name, const Labels &labels, double value) {
+    auto family = families_.find(name);
+    if (family == families_.end() || family->type != Type::HISTOGRAM) {
+        return;
+    }
+    auto &series = family->series[format_labels(labels)];
+    series.bucket_counts.resize(family->buckets.size());
+    auto bucket = std::lower_bound(family->buckets.begin(), family->buckets.end(), value) - family->buckets.begin();
+    if (bucket < series.bucket_counts.size()) {
+        series.bucket_counts[bucket]++;
+    }
+    series.sum += value;
+    series.count++;
+}
+QString Metrics::text() const {
+    QString result;
+    QTextStream stream(&result);
+    for (auto family = families_.begin(); family != families_.end(); family++) {
+        const auto &name = family.key();
+        if (family->series.isEmpty()) {
+            continue;
+        }
+        static const char *const TYPE_NAMES[] = {"counter", "gauge", "histogram"};
+        stream << "# HELP " << name << " " << family->help << "\n";
+        stream << "# TYPE " << name << " " << TYPE_NAMES[static_cast<int>(family->type)] << "\n";
+        for (auto series = family->series.begin(); series != family->series.end(); series++) {
+            const auto &labels = series.key();
+            if (family->type != Type::HISTOGRAM) {
+                stream << format_sample_name(name, labels) << " " << format_value(series->value) << "\n";
+                continue;
+            }
+            auto prefix = labels.isEmpty() ? QString() : labels + ",";
+            quint64 cumulative = 0;
+            for (auto i = 0; i < family->buckets.size(); i++) {
+                cumulative += series->bucket_counts.value(i);
+                auto bucket_labels = QStringLiteral(R"(%1le="%2")").arg(prefix, format_value(family->buckets[i]));
+                stream << format_sample_name(name + "_bucket", bucket_labels) << " " << cumulative << "\n";
+            }
+            stream << format_sample_name(name + "_bucket", prefix + R"(le="+Inf")") << " " << series->count << "\n";
+            stream << format_sample_name(name + "_sum", labels) << " " << format_value(series->sum) << "\n";
+            stream << format_sample_name(name + "_count", labels) << " " << series->count << "\n";
+        }
+    }
+    return result;
+}
+bool Metrics::write(const QString &path) const {
+    QSaveFile file(path);
+    if (not file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    auto data = text().toUtf8();
+    return file.write(data) == data.size() && file.commit();
+}
+}  // namespace concat
@@ -0,0 +1,52 @@
+#ifndef VIDEO_CONCATENATER_METRICS
+#define VIDEO_CONCATENATER_METRICS
+
+#include <QMap>
+#include <QPair>
+#include <QString>
+#include <QVector>
+
+namespace concat {
+/**
+ * @brief counters, gauges and histograms kept in memory and written in the Prometheus text exposition format
+ * @details The file is meant for the textfile collector of node_exporter, which reads every *.prom file of its
+ * directory. Updates only touch a map, so metrics can be recorded on every step without measurable cost.
+ */
+class Metrics {
+   public:
+    enum class Type { COUNTER, GAUGE, HISTOGRAM };
+    using Labels = QVector<QPair<QString, QString>>;
+    /**
+     * @brief declare a metric. series of undeclared metrics are ignored
+     * @param buckets upper bounds of histogram buckets, sorted. "+Inf" is added implicitly
+     */
+    void describe(const QString &name, Type type, const QString &help, const QVector<double> &buckets = {});
+    void increment(const QString &name, const Labels &labels = {}, double value = 1);
+    void set(const QString &name, const Labels &labels, double value);
+    void observe(const QString &name, const Labels &labels, double value);
+    /**
+     * @brief metrics in the text exposition format
+     */
+    QString text() const;
+    /**
+     * @brief replace path atomically with text(), so that the collector never reads a partial file
+     */
+    bool write(const QString &path) const;
+
+   private:
+    struct Series {
+        double value = 0;               // counter or gauge
+        QVector<quint64> bucket_counts;  // not cumulative
+        double sum = 0;
+        quint64 count = 0;
+    };
+    struct Family {
+        Type type;
+        QString help;
+        QVector<double> buckets;
+        QMap<QString, Series> series;  // by formatted labels
+    };
+    QMap<QString, Family> families_;
+};
+}  // namespace concat
+#endif
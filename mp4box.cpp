@@ -0,0 +1,635 @@
+#include "mp4box.hpp"
+
+#include <algorithm>
+#include <array>
+#include <ciso646>
+#include <cmath>
+#include <fstream>
+#include <map>
+#include <optional>
+#include <stdexcept>
+
+namespace concat {
+namespace fs = std::filesystem;
+namespace {
+using Bytes = std::vector<std::uint8_t>;
+constexpr std::size_t MAX_TITLE_SIZE = 255;  // length of title in chpl is 8 bits
+constexpr std::size_t CHPL_HEADER_SIZE = 17;
+constexpr std::size_t FREE_HEADER_SIZE = 8;
+// chpl with every chapter at its largest and the smallest free box after it
+constexpr std::size_t CHAPTER_SPACE = CHPL_HEADER_SIZE + MAX_MP4_CHAPTERS * (8 + 1 + MAX_TITLE_SIZE) + FREE_HEADER_SIZE;
+constexpr double CHPL_TIMESCALE = 10'000'000;  // 100ns
+
+std::uint32_t read32(const std::uint8_t *p) {
+    return (std::uint32_t(p[0]) << 24) | (std::uint32_t(p[1]) << 16) | (std::uint32_t(p[2]) << 8) | p[3];
+}
+std::uint64_t read64(const std::uint8_t *p) { return (std::uint64_t(read32(p)) << 32) | read32(p + 4); }
+void write32(std::uint8_t *p, std::uint32_t value) {
+    for (int i = 0; i < 4; i++) {
+        p[i] = (value >> (24 - 8 * i)) & 0xFF;
+    }
+}
+void write64(std::uint8_t *p, std::uint64_t value) {
+    write32(p, value >> 32);
+    write32(p + 4, value & 0xFFFFFFFF);
+}
+void append32(Bytes &bytes, std::uint32_t value) {
+    bytes.resize(bytes.size() + 4);
+    write32(&bytes[bytes.size() - 4], value);
+}
+void append64(Bytes &bytes, std::uint64_t value) {
+    bytes.resize(bytes.size() + 8);
+    write64(&bytes[bytes.size() - 8], value);
+}
+void append_type(Bytes &bytes, const char *type) { bytes.insert(bytes.end(), type, type + 4); }
+[[noreturn]] void throw_malformed(const fs::path &path, const std::string &what) {
+    throw std::runtime_error("malformed MP4 [" + path.string() + "]: " + what);
+}
+[[noreturn]] void throw_io_error(const char *what, const fs::path &path) {
+    throw fs::filesystem_error(what, path, std::make_error_code(std::errc::io_error));
+}
+
+struct Box {
+    std::uint64_t offset;  // from the start of the file or of the buffer
+    std::uint64_t size;    // including header
+    std::uint32_t header_size;
+    std::string type;
+
+    std::uint64_t payload() const { return offset + header_size; }
+    std::uint64_t end() const { return offset + size; }
+};
+/**
+ * @brief parse box header at bytes[offset, end)
+ * @retval std::nullopt the box is truncated
+ */
+std::optional<Box> parse_header(const std::uint8_t *header, std::uint64_t available_header_size, std::uint64_t offset,
+                                std::uint64_t end) {
+    if (available_header_size < 8 || offset + 8 > end) {
+        return std::nullopt;
+    }
+    Box result{offset, read32(header), 8, std::string(reinterpret_cast<const char *>(header + 4), 4)};
+    if (result.size == 1) {
+        if (available_header_size < 16 || offset + 16 > end) {
+            return std::nullopt;
+        }
+        result.size = read64(header + 8);
+        result.header_size = 16;
+    } else if (result.size == 0) {  // extends to the end
+        result.size = end - offset;
+    }
+    if (result.size < result.header_size || result.end() > end) {
+        return std::nullopt;
+    }
+    return result;
+}
+std::vector<Box> parse_boxes(const Bytes &bytes, std::uint64_t begin, std::uint64_t end) {
+    std::vector<Box> result;
+    for (auto offset = begin; offset < end;) {
+        auto box = parse_header(&bytes[offset], end - offset, offset, end);
+        if (not box.has_value()) {
+            break;
+        }
+        result.push_back(box.value());
+        offset = box->end();
+    }
+    return result;
+}
+std::vector<Box> children(const Bytes &bytes, const Box &box) { return parse_boxes(bytes, box.payload(), box.end()); }
+/**
+ * @brief the only box of bytes, which holds one whole box read by read_box()
+ */
+Box whole_box(const Bytes &bytes, const char *type, const fs::path &path) {
+    auto boxes = parse_boxes(bytes, 0, bytes.size());
+    if (boxes.empty() || boxes.front().type != type) {
+        throw_malformed(path, std::string(type) + " is truncated");
+    }
+    return boxes.front();
+}
+/**
+ * @brief size bytes at offset in the payload of box
+ * @throw std::runtime_error the range exceeds the box
+ */
+template <class B>
+auto field_of(B &bytes, const Box &box, std::uint64_t offset, std::uint64_t size, const fs::path &path)
+    -> decltype(&bytes[0]) {
+    // box.end() <= bytes.size() is guaranteed by parse_boxes()
+    if (offset > box.size - box.header_size || size > box.size - box.header_size - offset) {
+        throw_malformed(path, box.type + " is truncated");
+    }
+    return &bytes[box.payload() + offset];
+}
+std::optional<Box> find(const std::vector<Box> &boxes, const std::string &type) {
+    auto found = std::find_if(boxes.begin(), boxes.end(), [&](const Box &box) { return box.type == type; });
+    return found == boxes.end() ? std::nullopt : std::optional<Box>(*found);
+}
+/**
+ * @brief top-level boxes of a file. reading stops at a truncated box
+ */
+std::vector<Box> top_level_boxes(std::istream &stream, std::uint64_t file_size) {
+    std::vector<Box> result;
+    std::array<std::uint8_t, 16> header;
+    for (std::uint64_t offset = 0; offset < file_size;) {
+        auto header_size = std::min<std::uint64_t>(header.size(), file_size - offset);
+        stream.seekg(offset);
+        if (not stream.read(reinterpret_cast<char *>(header.data()), header_size)) {
+            break;
+        }
+        auto box = parse_header(header.data(), header_size, offset, file_size);
+        if (not box.has_value()) {
+            break;
+        }
+        result.push_back(box.value());
+        offset = box->end();
+    }
+    stream.clear();
+    return result;
+}
+Bytes read_box(std::istream &stream, const Box &box, const fs::path &path) {
+    Bytes result(box.size);
+    stream.seekg(box.offset);
+    if (not stream.read(reinterpret_cast<char *>(result.data()), result.size())) {
+        throw_io_error("read", path);
+    }
+    return result;
+}
+void copy_range(std::istream &src, std::uint64_t offset, std::uint64_t size, std::ostream &dst, const fs::path &path,
+                const std::function<void(const char *, std::size_t)> &on_data = nullptr) {
+    std::vector<char> buffer(1 << 20);
+    src.seekg(offset);
+    while (size > 0) {
+        auto chunk = std::min<std::uint64_t>(size, buffer.size());
+        if (not src.read(buffer.data(), chunk)) {
+            throw_io_error("read", path);
+        }
+        dst.write(buffer.data(), chunk);
+        if (on_data) {
+            on_data(buffer.data(), chunk);
+        }
+        size -= chunk;
+    }
+}
+
+struct Track {
+    std::uint32_t timescale = 0;
+    std::uint32_t default_sample_duration = 0;  // from trex
+    Bytes stsd;                                 // sample descriptions. decoders of appended fragments use these
+};
+/**
+ * @param moov bytes of whole moov box
+ */
+std::map<std::uint32_t, Track> parse_tracks(const Bytes &moov, const fs::path &path) {
+    std::map<std::uint32_t, Track> result;
+    auto moov_box = whole_box(moov, "moov", path);
+    auto require = [&](const std::optional<Box> &box, const char *type) {
+        if (not box.has_value()) {
+            throw_malformed(path, std::string(type) + " not found");
+        }
+        return box.value();
+    };
+    std::map<std::uint32_t, std::uint32_t> default_durations;
+    for (const auto &box : children(moov, moov_box)) {
+        if (box.type == "trak") {
+            auto trak = children(moov, box);
+            auto tkhd = require(find(trak, "tkhd"), "tkhd");
+            auto tkhd_version = *field_of(moov, tkhd, 0, 1, path);
+            auto track_id = read32(field_of(moov, tkhd, 4 + (tkhd_version == 1 ? 16 : 8), 4, path));
+            auto mdia = children(moov, require(find(trak, "mdia"), "mdia"));
+            auto mdhd = require(find(mdia, "mdhd"), "mdhd");
+            auto mdhd_version = *field_of(moov, mdhd, 0, 1, path);
+            auto &track = result[track_id];
+            track.timescale = read32(field_of(moov, mdhd, 4 + (mdhd_version == 1 ? 16 : 8), 4, path));
+            auto minf = children(moov, require(find(mdia, "minf"), "minf"));
+            auto stbl = children(moov, require(find(minf, "stbl"), "stbl"));
+            auto stsd = require(find(stbl, "stsd"), "stsd");
+            track.stsd.assign(moov.begin() + stsd.offset, moov.begin() + stsd.end());
+        } else if (box.type == "mvex") {
+            for (const auto &trex : children(moov, box)) {
+                if (trex.type == "trex") {
+                    auto p = field_of(moov, trex, 0, 16, path);
+                    default_durations[read32(p + 4)] = read32(p + 12);
+                }
+            }
+        }
+    }
+    for (auto [track_id, duration] : default_durations) {
+        if (result.count(track_id) != 0) {
+            result[track_id].default_sample_duration = duration;
+        }
+    }
+    return result;
+}
+bool has_mvex(const Bytes &moov) {
+    auto moov_box = parse_boxes(moov, 0, moov.size());
+    return not moov_box.empty() && find(children(moov, moov_box.front()), "mvex").has_value();
+}
+/**
+ * @brief sequence number of a fragment and decode time at the end of each track fragment
+ * @param moof bytes of whole moof box
+ */
+void read_fragment_times(const Bytes &moof, const std::map<std::uint32_t, Track> &tracks,
+                         std::uint32_t &sequence_number, std::map<std::uint32_t, std::uint64_t> &end_times,
+                         const fs::path &path) {
+    for (const auto &box : children(moof, whole_box(moof, "moof", path))) {
+        if (box.type == "mfhd") {
+            sequence_number = read32(field_of(moof, box, 4, 4, path));
+        }
+        if (box.type != "traf") {
+            continue;
+        }
+        std::optional<std::uint32_t> track_id;
+        std::uint32_t default_duration = 0;
+        std::uint64_t base_time = 0;
+        std::uint64_t total_duration = 0;
+        for (const auto &child : children(moof, box)) {
+            if (child.type != "tfhd" && child.type != "tfdt" && child.type != "trun") {
+                continue;
+            }
+            auto p = field_of(moof, child, 0, 4, path);
+            auto version = p[0];
+            auto flags = read32(p) & 0xFFFFFF;
+            if (child.type == "tfhd") {
+                track_id = read32(field_of(moof, child, 4, 4, path));
+                auto found = tracks.find(track_id.value());
+                default_duration = found == tracks.end() ? 0 : found->second.default_sample_duration;
+                // base_data_offset, sample_description_index
+                std::uint64_t offset = 8 + (flags & 0x1 ? 8 : 0) + (flags & 0x2 ? 4 : 0);
+                if (flags & 0x8) {
+                    default_duration = read32(field_of(moof, child, offset, 4, path));
+                }
+            } else if (child.type == "tfdt") {
+                base_time = version == 1 ? read64(field_of(moof, child, 4, 8, path))
+                                         : read32(field_of(moof, child, 4, 4, path));
+            } else {
+                auto sample_count = read32(field_of(moof, child, 4, 4, path));
+                // data_offset, first_sample_flags
+                std::uint64_t offset = 8 + (flags & 0x1 ? 4 : 0) + (flags & 0x4 ? 4 : 0);
+                if (not(flags & 0x100)) {
+                    total_duration += std::uint64_t(default_duration) * sample_count;
+                    continue;
+                }
+                std::uint64_t sample_size = 4 * ((flags & 0x100 ? 1 : 0) + (flags & 0x200 ? 1 : 0) +
+                                                 (flags & 0x400 ? 1 : 0) + (flags & 0x800 ? 1 : 0));
+                // every sample is checked at once, so a corrupt count fails before anything is read
+                auto samples = field_of(moof, child, offset, sample_size * sample_count, path);
+                for (std::uint32_t i = 0; i < sample_count; i++) {
+                    total_duration += read32(samples + i * sample_size);  // duration is the first field
+                }
+            }
+        }
+        if (track_id.has_value()) {
+            end_times[track_id.value()] = base_time + total_duration;
+        }
+    }
+}
+/**
+ * @brief shift sequence number, decode times and absolute data offsets of a fragment
+ * @param position_delta how far the fragment moves in the file
+ */
+void rebase_fragment(Bytes &moof, std::uint32_t sequence_offset,
+                     const std::map<std::uint32_t, std::uint64_t> &time_offsets, std::int64_t position_delta,
+                     const fs::path &path) {
+    for (const auto &box : children(moof, whole_box(moof, "moof", path))) {
+        if (box.type == "mfhd") {
+            auto p = field_of(moof, box, 4, 4, path);
+            write32(p, read32(p) + sequence_offset);
+        }
+        if (box.type != "traf") {
+            continue;
+        }
+        std::uint64_t time_offset = 0;
+        for (const auto &child : children(moof, box)) {
+            if (child.type != "tfhd" && child.type != "tfdt") {
+                continue;
+            }
+            auto p = field_of(moof, child, 0, 4, path);
+            auto version = p[0];
+            auto flags = read32(p) & 0xFFFFFF;
+            if (child.type == "tfhd") {
+                auto found = time_offsets.find(read32(field_of(moof, child, 4, 4, path)));
+                time_offset = found == time_offsets.end() ? 0 : found->second;
+                if (flags & 0x1) {  // base_data_offset is absolute
+                    auto offset = field_of(moof, child, 8, 8, path);
+                    write64(offset, read64(offset) + position_delta);
+                }
+            } else if (version == 1) {
+                auto time = field_of(moof, child, 4, 8, path);
+                write64(time, read64(time) + time_offset);
+            } else {
+                auto field = field_of(moof, child, 4, 4, path);
+                auto time = std::uint64_t(read32(field)) + time_offset;
+                if (time > 0xFFFFFFFF) {
+                    throw_malformed(path, "decode time does not fit in tfdt version 0");
+                }
+                write32(field, time);
+            }
+        }
+    }
+}
+std::string truncate_utf8(const std::string &text, std::size_t size) {
+    if (text.size() <= size) {
+        return text;
+    }
+    while (size > 0 && (static_cast<std::uint8_t>(text[size]) & 0xC0) == 0x80) {
+        size--;  // do not split a multibyte character
+    }
+    return text.substr(0, size);
+}
+Bytes make_chpl(const std::vector<Mp4Chapter> &chapters, const fs::path &path) {
+    if (chapters.size() > MAX_MP4_CHAPTERS) {
+        throw std::runtime_error("too many chapters for [" + path.string() + "]: " + std::to_string(chapters.size()) +
+                                 " (max " + std::to_string(MAX_MP4_CHAPTERS) + ")");
+    }
+    Bytes result;
+    append32(result, 0);
+    append_type(result, "chpl");
+    append32(result, 0x01000000);  // version 1
+    append32(result, 0);           // reserved
+    result.push_back(chapters.size());
+    for (const auto &chapter : chapters) {
+        append64(result, static_cast<std::uint64_t>(std::llround(std::max(chapter.start, 0.0) * CHPL_TIMESCALE)));
+        auto title = truncate_utf8(chapter.title, MAX_TITLE_SIZE);
+        result.push_back(title.size());
+        result.insert(result.end(), title.begin(), title.end());
+    }
+    write32(result.data(), result.size());
+    return result;
+}
+/**
+ * @brief chpl followed by free, CHAPTER_SPACE bytes in total
+ */
+Bytes chapter_space(const std::vector<Mp4Chapter> &chapters, const fs::path &path) {
+    auto result = make_chpl(chapters, path);
+    auto free_size = CHAPTER_SPACE - result.size();
+    append32(result, free_size);
+    append_type(result, "free");
+    result.resize(CHAPTER_SPACE, 0);
+    return result;
+}
+std::vector<Mp4Chapter> parse_chpl(const Bytes &bytes, const Box &chpl, const fs::path &path) {
+    std::vector<Mp4Chapter> result;
+    auto version = *field_of(bytes, chpl, 0, 1, path);
+    std::uint64_t header_size = 4 + (version == 1 ? 4 : 0);
+    auto p = field_of(bytes, chpl, header_size, 1, path);
+    auto end = &bytes[0] + chpl.end();
+    auto count = *p++;
+    for (int i = 0; i < count && p + 9 <= end; i++) {
+        Mp4Chapter chapter{read64(p) / CHPL_TIMESCALE, {}};
+        auto title_size = p[8];
+        p += 9;
+        if (p + title_size > end) {
+            break;
+        }
+        chapter.title.assign(reinterpret_cast<const char *>(p), title_size);
+        p += title_size;
+        result.push_back(chapter);
+    }
+    return result;
+}
+/**
+ * @brief moov whose udta has chapter space (chpl, optionally followed by free) instead of chpl and free
+ */
+Bytes with_chapter_space(const Bytes &moov, const Bytes &space, const fs::path &path) {
+    auto moov_children = children(moov, whole_box(moov, "moov", path));
+    Bytes udta;
+    append32(udta, 0);
+    append_type(udta, "udta");
+    if (auto old_udta = find(moov_children, "udta")) {
+        for (const auto &box : children(moov, old_udta.value())) {
+            if (box.type != "chpl" && box.type != "free") {
+                udta.insert(udta.end(), moov.begin() + box.offset, moov.begin() + box.end());
+            }
+        }
+    }
+    udta.insert(udta.end(), space.begin(), space.end());
+    write32(udta.data(), udta.size());
+    Bytes result;
+    append32(result, 0);
+    append_type(result, "moov");
+    for (const auto &box : moov_children) {
+        if (box.type != "udta") {
+            result.insert(result.end(), moov.begin() + box.offset, moov.begin() + box.end());
+        }
+    }
+    result.insert(result.end(), udta.begin(), udta.end());
+    write32(result.data(), result.size());
+    return result;
+}
+struct ParsedFile {
+    std::vector<Box> boxes;
+    Box moov;
+    Bytes moov_bytes;
+};
+ParsedFile parse_fragmented_file(std::istream &stream, const fs::path &path) {
+    ParsedFile result{top_level_boxes(stream, fs::file_size(path)), {}, {}};
+    auto moov = find(result.boxes, "moov");
+    if (not moov.has_value()) {
+        throw_malformed(path, "moov not found");
+    }
+    result.moov = moov.value();
+    result.moov_bytes = read_box(stream, result.moov, path);
+    if (not has_mvex(result.moov_bytes)) {
+        throw std::runtime_error("[" + path.string() + "] is not a fragmented MP4");
+    }
+    return result;
+}
+/**
+ * @brief chpl in the space reserved by write_appendable_mp4()
+ * @retval std::nullopt moov has no reserved space
+ */
+std::optional<Box> reserved_chpl(const Bytes &moov, const fs::path &path) {
+    auto udta = find(children(moov, whole_box(moov, "moov", path)), "udta");
+    if (not udta.has_value()) {
+        return std::nullopt;
+    }
+    auto udta_children = children(moov, udta.value());
+    for (std::size_t i = 0; i + 1 < udta_children.size(); i++) {
+        if (udta_children[i].type == "chpl" && udta_children[i + 1].type == "free" &&
+            udta_children[i].size + udta_children[i + 1].size == CHAPTER_SPACE) {
+            return udta_children[i];
+        }
+    }
+    return std::nullopt;
+}
+}  // namespace
+bool is_fragmented_mp4(const fs::path &path) {
+    try {
+        std::ifstream stream(path, std::ios::binary);
+        if (not stream) {
+            return false;
+        }
+        parse_fragmented_file(stream, path);
+        return true;
+    } catch (std::exception &) {
+        return false;
+    }
+}
+std::vector<Mp4Chapter> read_appendable_chapters(const fs::path &archive) {
+    std::ifstream stream(archive, std::ios::binary);
+    if (not stream) {
+        throw_io_error("open", archive);
+    }
+    auto parsed = parse_fragmented_file(stream, archive);
+    auto chpl = reserved_chpl(parsed.moov_bytes, archive);
+    if (not chpl.has_value()) {
+        throw std::runtime_error("[" + archive.string() + "] has no reserved space for chapters");
+    }
+    return parse_chpl(parsed.moov_bytes, chpl.value(), archive);
+}
+void write_appendable_mp4(const fs::path &src, const fs::path &dst, const std::vector<Mp4Chapter> &chapters,
+                          const std::function<void(const char *, std::size_t)> &on_data) {
+    std::ifstream src_stream(src, std::ios::binary);
+    if (not src_stream) {
+        throw_io_error("open", src);
+    }
+    auto parsed = parse_fragmented_file(src_stream, src);
+    auto moov = with_chapter_space(parsed.moov_bytes, chapter_space(chapters, dst), src);
+    std::ofstream dst_stream(dst, std::ios::binary | std::ios::trunc);
+    if (not dst_stream) {
+        throw_io_error("open", dst);
+    }
+    auto write = [&](const Bytes &bytes) {
+        dst_stream.write(reinterpret_cast<const char *>(bytes.data()), bytes.size());
+        if (on_data) {
+            on_data(reinterpret_cast<const char *>(bytes.data()), bytes.size());
+        }
+    };
+    for (const auto &box : parsed.boxes) {
+        std::int64_t position = dst_stream.tellp();
+        if (box.type == "moov") {
+            write(moov);
+        } else if (box.type == "moof") {
+            auto moof = read_box(src_stream, box, src);
+            rebase_fragment(moof, 0, {}, position - static_cast<std::int64_t>(box.offset), src);
+            write(moof);
+        } else if (box.type != "mfra") {  // offsets in mfra are no longer valid
+            copy_range(src_stream, box.offset, box.size, dst_stream, src, on_data);
+        }
+    }
+    if (not dst_stream.flush()) {
+        throw_io_error("write", dst);
+    }
+}
+void write_chapters_to_trailing_moov(const fs::path &path, const std::vector<Mp4Chapter> &chapters) {
+    std::fstream stream(path, std::ios::binary | std::ios::in | std::ios::out);
+    if (not stream) {
+        throw_io_error("open", path);
+    }
+    auto boxes = top_level_boxes(stream, fs::file_size(path));
+    if (boxes.empty() || boxes.back().type != "moov") {
+        throw std::runtime_error("moov is not at the end of [" + path.string() + "]");
+    }
+    auto moov = with_chapter_space(read_box(stream, boxes.back(), path), make_chpl(chapters, path), path);
+    stream.seekp(boxes.back().offset);
+    stream.write(reinterpret_cast<const char *>(moov.data()), moov.size());
+    if (not stream.flush()) {
+        throw_io_error("write", path);
+    }
+    stream.close();
+    if (moov.size() < boxes.back().size) {  // chpl written by the muxer was longer
+        fs::resize_file(path, boxes.back().offset + moov.size());
+    }
+}
+AppendResult append_fragments(const fs::path &archive, const fs::path &src, const std::vector<Mp4Chapter> &chapters) {
+    AppendResult result{0, 0, 0};
+    // read everything needed and check compatibility before touching the archive
+    std::ifstream archive_reader(archive, std::ios::binary);
+    if (not archive_reader) {
+        throw_io_error("open", archive);
+    }
+    auto archive_file = parse_fragmented_file(archive_reader, archive);
+    auto archive_tracks = parse_tracks(archive_file.moov_bytes, archive);
+    std::uint64_t valid_end = archive_file.boxes.back().end();
+    if (archive_file.boxes.back().type == "mfra") {
+        valid_end = archive_file.boxes.back().offset;
+    }
+    // chpl and free reserved by write_appendable_mp4()
+    auto chpl = reserved_chpl(archive_file.moov_bytes, archive);
+    if (not chpl.has_value()) {
+        throw std::runtime_error("[" + archive.string() + "] has no reserved space for chapters");
+    }
+    // decode time at the end of each track and the last sequence number
+    std::map<std::uint32_t, std::uint64_t> end_times;
+    std::uint32_t last_sequence_number = 0;
+    for (auto box = archive_file.boxes.rbegin(); box != archive_file.boxes.rend(); box++) {
+        if (box->type != "moof") {
+            continue;
+        }
+        std::map<std::uint32_t, std::uint64_t> fragment_end_times;
+        std::uint32_t sequence_number = 0;
+        read_fragment_times(read_box(archive_reader, *box, archive), archive_tracks, sequence_number,
+                            fragment_end_times, archive);
+        last_sequence_number = std::max(last_sequence_number, sequence_number);
+        for (auto [track_id, end_time] : fragment_end_times) {
+            end_times.emplace(track_id, end_time);  // keeps the later one
+        }
+        if (end_times.size() == archive_tracks.size()) {
+            break;
+        }
+    }
+    for (auto [track_id, end_time] : end_times) {
+        result.previous_duration =
+            std::max(result.previous_duration, static_cast<double>(end_time) / archive_tracks[track_id].timescale);
+    }
+    std::ifstream src_stream(src, std::ios::binary);
+    if (not src_stream) {
+        throw_io_error("open", src);
+    }
+    auto src_file = parse_fragmented_file(src_stream, src);
+    auto src_tracks = parse_tracks(src_file.moov_bytes, src);
+    if (src_tracks.size() != archive_tracks.size()) {
+        throw std::runtime_error("number of tracks differs from archive [" + archive.string() + "]");
+    }
+    std::map<std::uint32_t, std::uint64_t> time_offsets;
+    for (const auto &[track_id, track] : src_tracks) {
+        auto found = archive_tracks.find(track_id);
+        if (found == archive_tracks.end() || found->second.timescale != track.timescale ||
+            found->second.stsd != track.stsd) {
+            throw std::runtime_error("track " + std::to_string(track_id) +
+                                     " differs from archive in codec parameters or time scale [" + archive.string() +
+                                     "]");
+        }
+        // all tracks start at the same time so that they stay in sync. shorter tracks get a gap
+        time_offsets[track_id] =
+            static_cast<std::uint64_t>(std::ceil(result.previous_duration * track.timescale - 1e-6));
+    }
+    auto archive_chapters = parse_chpl(archive_file.moov_bytes, chpl.value(), archive);
+    for (const auto &chapter : chapters) {
+        archive_chapters.push_back({chapter.start + result.previous_duration, chapter.title});
+    }
+    auto space = chapter_space(archive_chapters, archive);
+    auto space_offset = archive_file.moov.offset + chpl->offset;
+    archive_reader.close();
+
+    // data is appended first so that the archive is never left with chapters pointing to nowhere
+    fs::resize_file(archive, valid_end);
+    std::fstream archive_writer(archive, std::ios::binary | std::ios::in | std::ios::out);
+    if (not archive_writer) {
+        throw_io_error("open", archive);
+    }
+    archive_writer.seekp(valid_end);
+    for (const auto &box : src_file.boxes) {
+        std::int64_t position = archive_writer.tellp();
+        if (box.type == "moof") {
+            auto moof = read_box(src_stream, box, src);
+            rebase_fragment(moof, last_sequence_number, time_offsets, position - static_cast<std::int64_t>(box.offset),
+                            src);
+            archive_writer.write(reinterpret_cast<const char *>(moof.data()), moof.size());
+            result.fragment_count++;
+        } else if (box.type == "mdat") {
+            copy_range(src_stream, box.offset, box.size, archive_writer, src);
+        } else {
+            continue;  // ftyp, moov, mfra, ... of src are not needed
+        }
+        result.appended_size += box.size;
+    }
+    if (not archive_writer.flush()) {
+        throw_io_error("write", archive);
+    }
+    archive_writer.seekp(space_offset);
+    archive_writer.write(reinterpret_cast<const char *>(space.data()), space.size());
+    if (not archive_writer.flush()) {
+        throw_io_error("write", archive);
+    }
+    return result;
+}
+}  // namespace concat
@@ -0,0 +1,66 @@
+#ifndef VIDEO_CONCATENATER_MP4BOX
+#define VIDEO_CONCATENATER_MP4BOX
+
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace concat {
+constexpr std::size_t MAX_MP4_CHAPTERS = 255;  // count of chpl is 8 bits
+struct Mp4Chapter {
+    double start;       // seconds
+    std::string title;  // UTF-8. truncated to 255 bytes when written
+};
+/**
+ * @brief whether the file is a fragmented MP4 (moov has mvex) which can be appended to
+ */
+bool is_fragmented_mp4(const std::filesystem::path &path);
+/**
+ * @brief chapters of an archive written by write_appendable_mp4()
+ * @throw std::filesystem::filesystem_error
+ * @throw std::runtime_error archive is malformed or has no reserved space for chapters
+ */
+std::vector<Mp4Chapter> read_appendable_chapters(const std::filesystem::path &archive);
+/**
+ * @brief copy fragmented MP4 src to dst, writing chapters as a Nero chapter list (udta/chpl) in moov
+ * @details Space for 255 chapters is reserved after chpl with a free box, so that append_fragments() can update
+ * chapters in place. mfra is dropped because its offsets are invalidated by the larger moov. Fragments must not use
+ * absolute offsets (-movflags default_base_moof).
+ * @param on_data receives every byte written to dst in order, so that dst can be hashed or copied without reading it
+ * back
+ * @throw std::filesystem::filesystem_error
+ * @throw std::runtime_error src is not a fragmented MP4 or there are too many chapters
+ */
+void write_appendable_mp4(const std::filesystem::path &src, const std::filesystem::path &dst,
+                          const std::vector<Mp4Chapter> &chapters,
+                          const std::function<void(const char *, std::size_t)> &on_data = nullptr);
+/**
+ * @brief write chapters as a Nero chapter list (udta/chpl) into moov at the end of a regular (not fragmented) MP4
+ * @details Only moov is rewritten, so this costs nothing compared to remuxing the file. Sample offsets (stco/co64)
+ * point into mdat before moov and are not affected.
+ * @throw std::filesystem::filesystem_error
+ * @throw std::runtime_error moov is not the last box (e.g. faststart) or there are too many chapters
+ */
+void write_chapters_to_trailing_moov(const std::filesystem::path &path, const std::vector<Mp4Chapter> &chapters);
+struct AppendResult {
+    double previous_duration;  // seconds. end of video track of the archive before appending
+    int fragment_count;        // fragments appended
+    std::uintmax_t appended_size;
+};
+/**
+ * @brief append fragments of src to the end of archive and add chapters
+ * @details Existing fragments of the archive are not rewritten. Sequence numbers (mfhd) and decode times (tfdt) of
+ * the new fragments are rebased onto the archive. An incomplete box left by an interrupted append and mfra at the
+ * end are truncated first. Chapters are written in the space reserved by write_appendable_mp4() after all fragments
+ * are written, so that the archive stays playable if this is interrupted.
+ * @param chapters chapters of src. they are shifted by the duration of the archive.
+ * @throw std::filesystem::filesystem_error
+ * @throw std::runtime_error tracks of src differ from the archive (codec parameters or time scales) or the archive
+ * has no reserved space for chapters
+ */
+AppendResult append_fragments(const std::filesystem::path &archive, const std::filesystem::path &src,
+                              const std::vector<Mp4Chapter> &chapters);
+}  // namespace concat
+#endif
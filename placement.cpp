@@ -0,0 +1,150 @@
+#include "placement.hpp"
+
+#include <ciso646>
+#include <memory>
+#include <system_error>
+
+#ifdef __linux__
+#    include <fcntl.h>
+#    include <linux/fs.h>
+#    include <sys/ioctl.h>
+#    include <unistd.h>
+
+#    include <cerrno>
+
+#    include "fileio.hpp"
+#else
+#    include <fstream>
+#endif
+
+namespace concat {
+namespace fs = std::filesystem;
+namespace {
+#ifdef __linux__
+PlacementMethod clone_or_copy(const fs::path &src, const fs::path &staging) {
+    FileDescriptor src_fd(::open(src.c_str(), O_RDONLY | O_CLOEXEC));
+    if (src_fd.get() < 0) {
+        throw_errno("open", src);
+    }
+    FileDescriptor dst_fd(::open(staging.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644));
+    if (dst_fd.get() < 0) {
+        throw_errno("open", staging);
+    }
+    auto method = PlacementMethod::REFLINK;
+    if (::ioctl(dst_fd.get(), FICLONE, src_fd.get()) != 0) {  // btrfs, XFS, ...
+        method = PlacementMethod::COPY;
+        append_contents(src_fd.get(), dst_fd.get(), src);
+    }
+    if (::fsync(dst_fd.get()) != 0) {
+        throw_errno("fsync", staging);
+    }
+    return method;
+}
+std::uintmax_t write_to_all_partials(const std::vector<fs::path> &stagings,
+                                    const std::function<void(const DataSink &)> &produce) {
+    std::vector<std::unique_ptr<FileDescriptor>> dst_fds;
+    for (const auto &staging : stagings) {
+        dst_fds.push_back(
+            std::make_unique<FileDescriptor>(::open(staging.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644)));
+        if (dst_fds.back()->get() < 0) {
+            throw_errno("open", staging);
+        }
+    }
+    std::uintmax_t size = 0;
+    produce([&](const char *data, std::size_t chunk_size) {
+        for (auto i = 0u; i < dst_fds.size(); i++) {
+            write_all(dst_fds[i]->get(), data, chunk_size, stagings[i]);
+        }
+        size += chunk_size;
+    });
+    for (auto i = 0u; i < dst_fds.size(); i++) {
+        if (::fsync(dst_fds[i]->get()) != 0) {
+            throw_errno("fsync", stagings[i]);
+        }
+    }
+    return size;
+}
+#else
+PlacementMethod clone_or_copy(const fs::path &src, const fs::path &staging) {
+    fs::copy_file(src, staging, fs::copy_options::overwrite_existing);
+    return PlacementMethod::COPY;
+}
+std::uintmax_t write_to_all_partials(const std::vector<fs::path> &stagings,
+                                    const std::function<void(const DataSink &)> &produce) {
+    std::vector<std::unique_ptr<std::ofstream>> dst_streams;
+    for (const auto &staging : stagings) {
+        dst_streams.push_back(std::make_unique<std::ofstream>(staging, std::ios::binary | std::ios::trunc));
+        if (not *dst_streams.back()) {
+            throw fs::filesystem_error("open", staging, std::make_error_code(std::errc::io_error));
+        }
+    }
+    std::uintmax_t size = 0;
+    produce([&](const char *data, std::size_t chunk_size) {
+        for (auto i = 0u; i < dst_streams.size(); i++) {
+            if (not dst_streams[i]->write(data, chunk_size)) {
+                throw fs::filesystem_error("write", stagings[i], std::make_error_code(std::errc::io_error));
+            }
+        }
+        size += chunk_size;
+    });
+    for (auto i = 0u; i < dst_streams.size(); i++) {
+        if (not dst_streams[i]->flush()) {
+            throw fs::filesystem_error("write", stagings[i], std::make_error_code(std::errc::io_error));
+        }
+    }
+    return size;
+}
+#endif
+}  // namespace
+fs::path partial_path_of(const fs::path &dst) {
+    auto partial_name = fs::path(".");
+    partial_name += dst.filename();
+    partial_name += ".part";
+    return dst.parent_path() / partial_name;
+}
+PlacementMethod place_file(const fs::path &src, const fs::path &dst) {
+    std::error_code error;
+    fs::rename(src, dst, error);
+    if (not error) {
+        return PlacementMethod::RENAME;
+    }
+    if (error != std::errc::cross_device_link) {
+        throw fs::filesystem_error("rename", src, dst, error);
+    }
+    auto staging = partial_path_of(dst);
+    try {
+        auto method = clone_or_copy(src, staging);
+        fs::rename(staging, dst);
+        fs::remove(src);
+        return method;
+    } catch (...) {
+        fs::remove(staging, error);
+        throw;
+    }
+}
+void commit_partials(const std::vector<fs::path> &dsts) {
+    for (const auto &dst : dsts) {
+        fs::rename(partial_path_of(dst), dst);
+    }
+}
+void remove_partials(const std::vector<fs::path> &dsts) {
+    std::error_code error;
+    for (const auto &dst : dsts) {
+        fs::remove(partial_path_of(dst), error);
+    }
+}
+std::uintmax_t write_to_all(const std::vector<fs::path> &dsts, const std::function<void(const DataSink &)> &produce) {
+    std::vector<fs::path> stagings;
+    for (const auto &dst : dsts) {
+        stagings.push_back(partial_path_of(dst));
+    }
+    try {
+        auto size = write_to_all_partials(stagings, produce);
+        commit_partials(dsts);
+        return size;
+    } catch (...) {
+        remove_partials(dsts);
+        throw;
+    }
+}
+}  // namespace concat
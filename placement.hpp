@@ -0,0 +1,45 @@
+#ifndef VIDEO_CONCATENATER_PLACEMENT
+#define VIDEO_CONCATENATER_PLACEMENT
+
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <vector>
+
+namespace concat {
+enum class PlacementMethod { RENAME, REFLINK, COPY };
+/**
+ * @brief move src to dst without exposing half-written dst.
+ * @details rename() is used if src and dst are on the same filesystem. Otherwise, src is reflinked (FICLONE, Linux
+ * only) or copied to a temporary file next to dst, which is then renamed to dst. src is removed on success.
+ * @throw std::filesystem::filesystem_error
+ */
+PlacementMethod place_file(const std::filesystem::path &src, const std::filesystem::path &dst);
+/**
+ * @brief hidden ".part" file next to dst, where dst is written before it is renamed
+ */
+std::filesystem::path partial_path_of(const std::filesystem::path &dst);
+/**
+ * @brief rename the partial file of every destination to the destination
+ * @details This is called once every copy is complete, e.g. after ffmpeg wrote them, so that a destination never
+ * holds a half-written file.
+ * @throw std::filesystem::filesystem_error
+ */
+void commit_partials(const std::vector<std::filesystem::path> &dsts);
+/**
+ * @brief remove partial files left by a failed write. missing files are ignored
+ */
+void remove_partials(const std::vector<std::filesystem::path> &dsts);
+using DataSink = std::function<void(const char *, std::size_t)>;
+/**
+ * @brief write bytes to every destination as they are produced
+ * @details produce() is given a sink, which writes each chunk to the partial file of every destination. Partial files
+ * are committed when produce() returns, or removed if it throws. Copies are made while the bytes are produced, so the
+ * file they come from is never read back.
+ * @return bytes given to the sink
+ * @throw std::filesystem::filesystem_error
+ */
+std::uintmax_t write_to_all(const std::vector<std::filesystem::path> &dsts,
+                            const std::function<void(const DataSink &)> &produce);
+}  // namespace concat
+#endif
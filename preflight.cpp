@@ -0,0 +1,148 @@
+#include "preflight.hpp"
+
+#include <QMap>
+#include <QMultiMap>
+#include <QRegularExpression>
+#include <algorithm>
+#include <ciso646>
+
+namespace concat {
+namespace {
+std::optional<std::uint64_t> parse_bitrate(const QString &text) {
+    QRegularExpression bitrate_pattern(R"(^(?<value>\d+(\.\d+)?)(?<unit>[kKmMgG]?)$)");
+    auto match = bitrate_pattern.match(text);
+    if (not match.hasMatch()) {
+        return std::nullopt;
+    }
+    double value = match.captured("value").toDouble();
+    auto unit = match.captured("unit").toLower();
+    if (unit == "k") {
+        value *= 1e3;
+    } else if (unit == "m") {
+        value *= 1e6;
+    } else if (unit == "g") {
+        value *= 1e9;
+    }
+    return static_cast<std::uint64_t>(value);
+}
+std::optional<std::uint64_t> find_bitrate(const QVector<QString> &args, const QStringList &keys) {
+    for (auto i = 0; i + 1 < args.size(); i++) {
+        if (keys.contains(args[i])) {
+            return parse_bitrate(args[i + 1]);
+        }
+    }
+    return std::nullopt;
+}
+constexpr std::uint64_t DEFAULT_AUDIO_BITRATE = 128'000;
+}  // namespace
+std::optional<std::uint64_t> target_bitrate(const VideoInfo &output_info) {
+    return target_bitrate(output_info.encoding_args);
+}
+std::optional<std::uint64_t> target_bitrate(const QVector<QString> &encoding_args) {
+    auto video_bitrate = find_bitrate(encoding_args, {"-b:v", "-vb"});
+    if (not video_bitrate.has_value()) {
+        return std::nullopt;
+    }
+    auto audio_bitrate = find_bitrate(encoding_args, {"-b:a", "-ab"}).value_or(DEFAULT_AUDIO_BITRATE);
+    return video_bitrate.value() + audio_bitrate;
+}
+PreflightResult run_preflight(const QString &tmpdir, const QVector<PreflightInput> &inputs,
+                              std::optional<std::uint64_t> bitrate, const QVector<PreflightRendition> &renditions) {
+    namespace fs = std::filesystem;
+    PreflightResult result;
+    auto on_error = [&result](std::exception &e) { result.errors << QString::fromLocal8Bit(e.what()); };
+    try {
+        result.tmpdir = fs::canonical(tmpdir.toStdU16String());
+        auto tmpdir_size = fs::space(result.tmpdir).available;
+        if (tmpdir_size != static_cast<std::uintmax_t>(-1)) {
+            result.tmpdir_available_size = tmpdir_size;
+        }
+    } catch (std::exception &e) {
+        on_error(e);
+    }
+    // unknown sizes are read from one enumeration of each directory. network filesystems return attributes with
+    // the listing (READDIRPLUS on NFS, QUERY_DIRECTORY on SMB, FindNextFile on Windows) instead of a round trip per file
+    QMap<QString, QMultiMap<QString, int>> unknown_sizes_by_dir;  // directory -> (file name -> index of input)
+    QVector<std::uintmax_t> sizes(inputs.size(), PreflightResult::INVALID_SIZE);
+    for (auto i = 0; i < inputs.size(); i++) {
+        if (inputs[i].size.has_value()) {
+            sizes[i] = inputs[i].size.value();
+        } else {
+            auto path = fs::path(inputs[i].path.toStdU16String());
+            unknown_sizes_by_dir[QString::fromStdU16String(path.parent_path().u16string())].insert(
+                QString::fromStdU16String(path.filename().u16string()), i);
+        }
+    }
+    for (auto dir_iter = unknown_sizes_by_dir.begin(); dir_iter != unknown_sizes_by_dir.end(); dir_iter++) {
+        auto &unknown_sizes = dir_iter.value();
+        try {
+            for (const auto &entry : fs::directory_iterator(dir_iter.key().toStdU16String())) {
+                auto name = QString::fromStdU16String(entry.path().filename().u16string());
+                if (not unknown_sizes.contains(name)) {
+                    continue;
+                }
+                auto size = entry.file_size();
+                for (auto i : unknown_sizes.values(name)) {
+                    sizes[i] = size;
+                }
+                unknown_sizes.remove(name);
+                if (unknown_sizes.isEmpty()) {
+                    break;
+                }
+            }
+        } catch (std::exception &e) {
+            on_error(e);
+            continue;
+        }
+        for (auto i : unknown_sizes) {
+            result.errors << QStringLiteral("%1: not found").arg(inputs[i].path);
+        }
+    }
+    if (not inputs.isEmpty()) {
+        try {
+            result.dstdir = fs::canonical(fs::path(inputs.front().path.toStdU16String()).parent_path());
+            auto dstdir_size = fs::space(result.dstdir).available;
+            if (dstdir_size != static_cast<std::uintmax_t>(-1)) {
+                result.dstdir_available_size = dstdir_size;
+            }
+        } catch (std::exception &e) {
+            on_error(e);
+        }
+    }
+    for (auto size : sizes) {
+        if (size == PreflightResult::INVALID_SIZE) {
+            continue;
+        }
+        if (result.sum_of_input_sizes == PreflightResult::INVALID_SIZE) {
+            result.sum_of_input_sizes = size;
+        } else {
+            result.sum_of_input_sizes += size;
+        }
+    }
+    result.estimated_result_size = result.sum_of_input_sizes;
+    bool all_durations_are_known = std::all_of(inputs.begin(), inputs.end(),
+                                               [](const PreflightInput &input) { return input.duration.has_value(); });
+    double total_duration = 0;
+    for (const auto &input : inputs) {
+        total_duration += input.duration.value_or(0);
+    }
+    if (bitrate.has_value() && all_durations_are_known) {
+        result.estimated_result_size = static_cast<std::uintmax_t>(total_duration * bitrate.value() / 8);
+        result.is_estimated_from_bitrate = true;
+    }
+    for (const auto &rendition : renditions) {
+        auto size = result.estimated_result_size;
+        if (rendition.copies_video) {
+            size = result.sum_of_input_sizes;
+        } else if (rendition.bitrate.has_value() && all_durations_are_known) {
+            size = static_cast<std::uintmax_t>(total_duration * rendition.bitrate.value() / 8);
+        }
+        if (size == PreflightResult::INVALID_SIZE || result.estimated_rendition_size == PreflightResult::INVALID_SIZE) {
+            result.estimated_rendition_size = PreflightResult::INVALID_SIZE;
+        } else {
+            result.estimated_rendition_size += size;
+        }
+    }
+    return result;
+}
+}  // namespace concat
@@ -0,0 +1,54 @@
+#ifndef VIDEO_CONCATENATER_PREFLIGHT
+#define VIDEO_CONCATENATER_PREFLIGHT
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+
+#include "videoinfo.hpp"
+
+namespace concat {
+struct PreflightInput {
+    QString path;
+    std::optional<std::uintmax_t> size;  // already known size (e.g. probed in background)
+    std::optional<double> duration;      // seconds
+};
+struct PreflightRendition {
+    bool copies_video;
+    std::optional<std::uint64_t> bitrate;  // bits per second, from "-b:v"/"-b:a" of the rendition
+};
+struct PreflightResult {
+    static constexpr auto INVALID_SIZE = static_cast<std::uintmax_t>(-1);
+    std::filesystem::path tmpdir;
+    std::uintmax_t tmpdir_available_size = INVALID_SIZE;
+    std::filesystem::path dstdir;
+    std::uintmax_t dstdir_available_size = INVALID_SIZE;
+    std::uintmax_t sum_of_input_sizes = INVALID_SIZE;
+    std::uintmax_t estimated_result_size = INVALID_SIZE;
+    std::uintmax_t estimated_rendition_size = 0;  // sum of all renditions
+    bool is_estimated_from_bitrate = false;
+    QStringList errors;
+};
+/**
+ * @brief bitrate of output in bits per second, retrieved from "-b:v"/"-b:a" in encoding arguments
+ * @retval std::nullopt video bitrate is not specified
+ */
+std::optional<std::uint64_t> target_bitrate(const VideoInfo &output_info);
+std::optional<std::uint64_t> target_bitrate(const QVector<QString> &encoding_args);
+/**
+ * @brief check sizes and available spaces. This function may block for a long time on network mounts, so call this
+ * in a worker thread.
+ * @note sizes which are unknown are read by listing their directories, once per directory.
+ *
+ * @param bitrate if this has value, result size is estimated from durations and bitrate. Otherwise the sum of input
+ * sizes is used, as for stream copy
+ * @param renditions written next to the result. a rendition whose bitrate is unknown is estimated as large as the
+ * result
+ */
+PreflightResult run_preflight(const QString &tmpdir, const QVector<PreflightInput> &inputs,
+                              std::optional<std::uint64_t> bitrate, const QVector<PreflightRendition> &renditions);
+}  // namespace concat
+#endif
@@ -0,0 +1,51 @@
+#include "previewtimeline.hpp"
+
+#include <QFileInfo>
+#include <QJsonObject>
+#include <algorithm>
+#include <ciso646>
+
+namespace concat {
+double PreviewTimeline::duration() const { return segments.isEmpty() ? 0.0 : segments.back().timeline_end(); }
+int PreviewTimeline::segment_at(double time) const {
+    if (segments.isEmpty()) {
+        return -1;
+    }
+    auto found = std::upper_bound(segments.begin(), segments.end(), time, [](double value, const auto &segment) {
+        return value < segment.timeline_end();
+    });
+    return found == segments.end() ? static_cast<int>(segments.size()) - 1
+                                   : static_cast<int>(std::distance(segments.begin(), found));
+}
+PreviewTimeline build_preview_timeline(const QVector<PreviewInput> &inputs) {
+    PreviewTimeline result;
+    double offset = 0;
+    for (const auto &input : inputs) {
+        auto start = std::clamp(input.in_point.value_or(0), 0.0, input.duration);
+        auto end = std::clamp(input.out_point.value_or(input.duration), start, input.duration);
+        if (end <= start) {
+            continue;
+        }
+        result.segments.push_back({input.path, start, end, offset});
+        QVector<PreviewChapter> chapters;
+        for (const auto &value : input.chapters) {
+            auto chapter = value.toObject();
+            auto chapter_start = chapter["start_time"].toString().toDouble() - input.start_time;
+            auto chapter_end = chapter["end_time"].toString().toDouble() - input.start_time;
+            if (chapter_end <= start || chapter_start >= end) {
+                continue;  // trimmed away
+            }
+            chapters.push_back(
+                {chapter["tags"].toObject()["title"].toString(), offset + std::max(chapter_start, start) - start});
+        }
+        if (chapters.isEmpty()) {
+            chapters.push_back({QFileInfo(input.path).fileName(), offset});
+        }
+        result.chapters += chapters;
+        offset += end - start;
+    }
+    std::stable_sort(result.chapters.begin(), result.chapters.end(),
+                     [](const auto &a, const auto &b) { return a.time < b.time; });
+    return result;
+}
+}  // namespace concat
@@ -0,0 +1,54 @@
+#ifndef VIDEO_CONCATENATER_PREVIEWTIMELINE
+#define VIDEO_CONCATENATER_PREVIEWTIMELINE
+
+#include <QJsonArray>
+#include <QString>
+#include <QVector>
+#include <optional>
+
+namespace concat {
+struct PreviewInput {
+    QString path;
+    double duration;                  // seconds
+    double start_time = 0;            // first timestamp in seconds. ffprobe reports chapters from this
+    std::optional<double> in_point;   // seconds from start of file
+    std::optional<double> out_point;  // seconds from start of file
+    QJsonArray chapters;              // "chapters" of ffprobe
+};
+/**
+ * @brief range of an input played on the concatenated timeline
+ */
+struct PreviewSegment {
+    QString path;
+    double source_start;    // seconds from start of file
+    double source_end;      // seconds from start of file
+    double timeline_start;  // seconds on the concatenated timeline
+
+    double length() const { return source_end - source_start; }
+    double timeline_end() const { return timeline_start + length(); }
+};
+struct PreviewChapter {
+    QString title;
+    double time;  // seconds on the concatenated timeline
+};
+/**
+ * @brief concatenated result which is not rendered. each segment is played from its source
+ */
+struct PreviewTimeline {
+    QVector<PreviewSegment> segments;
+    QVector<PreviewChapter> chapters;  // sorted by time
+
+    double duration() const;
+    /**
+     * @brief index of the segment played at time. the last one if time is at or beyond the end
+     * @retval -1 there is no segment
+     */
+    int segment_at(double time) const;
+};
+/**
+ * @details Offsets are the same as those of the result, as far as durations of inputs are accurate. Inputs without
+ * chapters get one chapter titled with the file name, like the result.
+ */
+PreviewTimeline build_preview_timeline(const QVector<PreviewInput> &inputs);
+}  // namespace concat
+#endif
@@ -0,0 +1,199 @@
+#include "previewwidget.hpp"
+
+#include <QComboBox>
+#include <QHBoxLayout>
+#include <QLabel>
+#include <QPushButton>
+#include <QSlider>
+#include <QStackedWidget>
+#include <QUrl>
+#include <QVBoxLayout>
+#include <QVideoWidget>
+#include <algorithm>
+#include <ciso646>
+
+#include "trim.hpp"
+
+PreviewWidget::PreviewWidget(const concat::PreviewTimeline &timeline, QWidget *parent, Qt::WindowFlags flags)
+    : QWidget(parent, flags), timeline_(timeline) {
+    setWindowTitle(tr("preview"));
+    videos_ = new QStackedWidget(this);
+    for (auto i = 0; i < static_cast<int>(decks_.size()); i++) {
+        auto &deck = decks_[i];
+        deck.player = new QMediaPlayer(this);
+        deck.audio = new QAudioOutput(this);
+        deck.video = new QVideoWidget(videos_);
+        deck.player->setAudioOutput(deck.audio);
+        deck.player->setVideoOutput(deck.video);
+        videos_->addWidget(deck.video);
+        connect(deck.player, &QMediaPlayer::mediaStatusChanged, this,
+                [this, i](QMediaPlayer::MediaStatus status) { this->on_media_status_(i, status); });
+        connect(deck.player, &QMediaPlayer::positionChanged, this,
+                [this, i](qint64 position) { this->on_position_(i, position); });
+    }
+    slider_ = new QSlider(Qt::Horizontal, this);
+    slider_->setRange(0, static_cast<int>(timeline_.duration() * 1000));
+    connect(slider_, &QSlider::sliderPressed, this, [this] { this->slider_is_held_ = true; });
+    connect(slider_, &QSlider::sliderReleased, this, [this] {
+        this->slider_is_held_ = false;
+        this->seek(this->slider_->value() / 1000.0);
+    });
+    connect(slider_, &QSlider::actionTriggered, this, [this](int action) {
+        if (action != QAbstractSlider::SliderMove) {  // clicks on the groove and keys
+            this->seek(this->slider_->sliderPosition() / 1000.0);
+        }
+    });
+    time_label_ = new QLabel(this);
+    play_button_ = new QPushButton(tr("play"), this);
+    connect(play_button_, &QPushButton::clicked, this, &PreviewWidget::toggle_playing_);
+    auto previous_join = new QPushButton(tr("previous join"), this);
+    connect(previous_join, &QPushButton::clicked, this, [this] { this->seek_join_(-1); });
+    auto next_join = new QPushButton(tr("next join"), this);
+    connect(next_join, &QPushButton::clicked, this, [this] { this->seek_join_(1); });
+    chapters_ = new QComboBox(this);
+    for (const auto &chapter : timeline_.chapters) {
+        chapters_->addItem(QStringLiteral("%1 %2").arg(concat::format_time(chapter.time), chapter.title));
+    }
+    connect(chapters_, qOverload<int>(&QComboBox::activated), this,
+            [this](int index) { this->seek(this->timeline_.chapters[index].time); });
+
+    auto controls = new QHBoxLayout;
+    controls->addWidget(play_button_);
+    controls->addWidget(previous_join);
+    controls->addWidget(next_join);
+    controls->addWidget(chapters_, 1);
+    controls->addWidget(time_label_);
+    auto layout = new QVBoxLayout(this);
+    layout->addWidget(videos_, 1);
+    layout->addWidget(slider_);
+    layout->addLayout(controls);
+    resize(960, 600);
+    seek(0);
+}
+
+void PreviewWidget::seek(double time) {
+    auto index = timeline_.segment_at(time);
+    if (index < 0) {
+        return;
+    }
+    const auto &segment = timeline_.segments[index];
+    auto source_time = segment.source_start + std::clamp(time - segment.timeline_start, 0.0, segment.length());
+    if (decks_[active_].segment != index && decks_[1 - active_].segment == index) {
+        // the other player already has the source open
+        decks_[active_].player->pause();
+        active_ = 1 - active_;
+        videos_->setCurrentWidget(decks_[active_].video);
+    }
+    auto &active = decks_[active_];
+    load_(active, index, source_time);
+    if (is_playing_) {
+        active.player->play();
+    }
+    if (index + 1 < timeline_.segments.size()) {
+        load_(decks_[1 - active_], index + 1, timeline_.segments[index + 1].source_start);
+    }
+    update_time_(time);
+}
+
+void PreviewWidget::load_(Deck &deck, int segment, double source_time) {
+    auto position = static_cast<qint64>(source_time * 1000);
+    auto url = QUrl::fromLocalFile(timeline_.segments[segment].path);
+    deck.segment = segment;
+    // an input may follow itself with different in/out points. its source is not opened again
+    if (deck.player->source() == url && deck.player->mediaStatus() != QMediaPlayer::LoadingMedia) {
+        deck.pending_position.reset();
+        deck.player->setPosition(position);
+        return;
+    }
+    if (deck.player->source() != url) {
+        deck.player->setSource(url);
+    }
+    deck.pending_position = position;  // positions set while loading are dropped
+}
+
+void PreviewWidget::on_media_status_(int deck_index, QMediaPlayer::MediaStatus status) {
+    auto &deck = decks_[deck_index];
+    if ((status == QMediaPlayer::LoadedMedia || status == QMediaPlayer::BufferedMedia) &&
+        deck.pending_position.has_value()) {
+        deck.player->setPosition(deck.pending_position.value());
+        deck.pending_position.reset();
+    } else if (status == QMediaPlayer::EndOfMedia && deck_index == active_) {
+        advance_();  // out point is the end of the file
+    } else if (status == QMediaPlayer::InvalidMedia) {
+        time_label_->setText(tr("cannot play %1").arg(deck.player->source().toLocalFile()));
+    }
+}
+
+void PreviewWidget::on_position_(int deck_index, qint64 position) {
+    const auto &deck = decks_[deck_index];
+    if (deck_index != active_ || deck.segment < 0 || deck.pending_position.has_value()) {
+        return;
+    }
+    const auto &segment = timeline_.segments[deck.segment];
+    auto source_time = position / 1000.0;
+    if (is_playing_ && source_time >= segment.source_end) {
+        advance_();
+        return;
+    }
+    update_time_(segment.timeline_start + std::clamp(source_time - segment.source_start, 0.0, segment.length()));
+}
+
+void PreviewWidget::advance_() {
+    auto &current = decks_[active_];
+    auto &next = decks_[1 - active_];
+    auto index = current.segment + 1;
+    if (index >= timeline_.segments.size()) {
+        is_playing_ = false;
+        current.player->pause();
+        play_button_->setText(tr("play"));
+        return;
+    }
+    if (next.segment != index) {  // e.g. the end came before preloading finished
+        load_(next, index, timeline_.segments[index].source_start);
+    }
+    current.player->pause();
+    active_ = 1 - active_;
+    videos_->setCurrentWidget(next.video);
+    next.player->play();
+    if (index + 1 < timeline_.segments.size()) {
+        load_(current, index + 1, timeline_.segments[index + 1].source_start);
+    }
+}
+
+void PreviewWidget::toggle_playing_() {
+    is_playing_ = not is_playing_;
+    if (is_playing_) {
+        decks_[active_].player->play();
+    } else {
+        decks_[active_].player->pause();
+    }
+    play_button_->setText(is_playing_ ? tr("pause") : tr("play"));
+}
+
+void PreviewWidget::seek_join_(int direction) {
+    auto now = slider_->value() / 1000.0;
+    // a small margin keeps repeated clicks from finding the join just sought to
+    constexpr double MARGIN = 0.5;
+    std::optional<double> target;
+    for (auto i = 1; i < timeline_.segments.size(); i++) {
+        auto time = std::max(timeline_.segments[i].timeline_start - JOIN_LEAD_IN, 0.0);
+        if (direction > 0 && time > now + MARGIN) {
+            target = time;
+            break;
+        }
+        if (direction < 0 && time < now - MARGIN) {
+            target = time;
+        }
+    }
+    if (target.has_value()) {
+        seek(target.value());
+    }
+}
+
+void PreviewWidget::update_time_(double time) {
+    if (not slider_is_held_) {
+        slider_->setValue(static_cast<int>(time * 1000));
+    }
+    time_label_->setText(
+        QStringLiteral("%1 / %2").arg(concat::format_time(time), concat::format_time(timeline_.duration())));
+}
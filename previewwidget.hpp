@@ -0,0 +1,65 @@
+#ifndef PREVIEWWIDGET_HPP
+#define PREVIEWWIDGET_HPP
+
+#include <QAudioOutput>
+#include <QMediaPlayer>
+#include <QWidget>
+#include <array>
+#include <optional>
+
+#include "previewtimeline.hpp"
+
+class QComboBox;
+class QLabel;
+class QPushButton;
+class QSlider;
+class QStackedWidget;
+class QVideoWidget;
+
+/**
+ * @brief plays the concatenated timeline from the sources, without rendering anything
+ * @details Two players take turns. While one plays a segment, the other one has the next segment loaded and paused
+ * at its start, so that playback switches to it without waiting for the source to be opened.
+ */
+class PreviewWidget : public QWidget {
+    Q_OBJECT
+
+   public:
+    explicit PreviewWidget(const concat::PreviewTimeline &timeline, QWidget *parent = nullptr,
+                           Qt::WindowFlags flags = Qt::WindowFlags());
+    /**
+     * @param time seconds on the timeline
+     */
+    void seek(double time);
+
+   private:
+    struct Deck {
+        QMediaPlayer *player;
+        QAudioOutput *audio;
+        QVideoWidget *video;
+        int segment = -1;
+        std::optional<qint64> pending_position;  // applied when the source is loaded. milliseconds in the source
+    };
+    concat::PreviewTimeline timeline_;
+    std::array<Deck, 2> decks_;
+    int active_ = 0;
+    bool is_playing_ = false;
+    bool slider_is_held_ = false;
+    QStackedWidget *videos_;
+    QSlider *slider_;
+    QLabel *time_label_;
+    QPushButton *play_button_;
+    QComboBox *chapters_;
+    // a join is previewed from this many seconds before it
+    static constexpr double JOIN_LEAD_IN = 3;
+
+    void load_(Deck &deck, int segment, double source_time);
+    void on_media_status_(int deck_index, QMediaPlayer::MediaStatus status);
+    void on_position_(int deck_index, qint64 position);
+    void advance_();  // switches to the preloaded player at the end of a segment
+    void toggle_playing_();
+    void seek_join_(int direction);
+    void update_time_(double time);
+};
+
+#endif  // PREVIEWWIDGET_HPP
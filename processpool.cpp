@@ -0,0 +1,86 @@
+#include "processpool.hpp"
+
+#include <algorithm>
+#include <ciso646>
+
+ProcessPool::ProcessPool(int max_concurrency, QObject *parent)
+    : QObject(parent), max_concurrency_(qMax(1, max_concurrency)) {}
+
+ProcessPool::~ProcessPool() { kill_all(); }
+
+ProcessPool::JobId ProcessPool::enqueue(const QString &program, const QStringList &arguments, Callback on_finished,
+                                       OutputCallback on_stdout) {
+    auto id = ++last_id_;
+    queue_.push_back({id, program, arguments, on_finished, on_stdout});
+    start_next_();
+    return id;
+}
+
+void ProcessPool::kill(JobId id) {
+    auto queued = std::find_if(queue_.begin(), queue_.end(), [id](const Job &job) { return job.id == id; });
+    if (queued != queue_.end()) {
+        queue_.erase(queued);
+        return;
+    }
+    auto process = running_.key(id);
+    if (process == nullptr) {
+        return;
+    }
+    running_.remove(process);
+    process->disconnect(this);
+    process->kill();
+    process->waitForFinished();
+    delete process;
+    start_next_();
+}
+
+void ProcessPool::kill_all() {
+    queue_.clear();
+    auto running = running_;
+    running_.clear();
+    for (auto process : running.keys()) {
+        process->disconnect(this);
+        process->kill();
+        process->waitForFinished();
+        delete process;
+    }
+}
+
+int ProcessPool::pending_count() const { return static_cast<int>(queue_.size()); }
+int ProcessPool::running_count() const { return running_.size(); }
+
+void ProcessPool::start_next_() {
+    while (running_.size() < max_concurrency_ && not queue_.empty()) {
+        auto job = queue_.front();
+        queue_.pop_front();
+        auto process = new QProcess;
+        auto started_at = std::chrono::steady_clock::now();
+        running_.insert(process, job.id);
+        auto on_finished = [this, process, job, started_at](int exit_code, QProcess::ExitStatus exit_status) {
+            running_.remove(process);
+            if (job.on_stdout) {
+                job.on_stdout(process->readAllStandardOutput());
+            }
+            Result result{exit_status == QProcess::NormalExit && exit_code == 0, exit_code,
+                          process->readAllStandardOutput(), process->readAllStandardError(),
+                          std::chrono::steady_clock::now() - started_at};
+            process->deleteLater();
+            job.on_finished(result);
+            start_next_();
+            if (running_.isEmpty() && queue_.empty()) {
+                emit all_finished();
+            }
+        };
+        if (job.on_stdout) {
+            connect(process, &QProcess::readyReadStandardOutput, this,
+                    [process, job] { job.on_stdout(process->readAllStandardOutput()); });
+        }
+        connect(process, &QProcess::finished, this, on_finished);
+        connect(process, &QProcess::errorOccurred, this, [on_finished](QProcess::ProcessError error) {
+            if (error == QProcess::FailedToStart) {
+                on_finished(-1, QProcess::CrashExit);  // finished() is not emitted in this case
+            }
+        });
+        process->start(job.program, job.arguments);
+    }
+}
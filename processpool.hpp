@@ -0,0 +1,73 @@
+#ifndef PROCESSPOOL_HPP
+#define PROCESSPOOL_HPP
+
+#include <QByteArray>
+#include <QHash>
+#include <QObject>
+#include <QProcess>
+#include <QString>
+#include <QStringList>
+#include <QThread>
+#include <chrono>
+#include <deque>
+#include <functional>
+
+/**
+ * @brief runs external programs concurrently, at most max_concurrency at a time.
+ * @note unlike ProcessWidget, output is not shown anywhere. It is passed to the callback when the program finishes.
+ */
+class ProcessPool : public QObject {
+    Q_OBJECT
+
+   public:
+    struct Result {
+        bool is_success;  // true if program exited normally with exit code 0
+        int exit_code;
+        QByteArray stdout_data;
+        QByteArray stderr_data;
+        std::chrono::duration<double> elapsed;
+    };
+    using Callback = std::function<void(const Result &)>;
+    using OutputCallback = std::function<void(const QByteArray &)>;
+    using JobId = quint64;
+
+    explicit ProcessPool(int max_concurrency = QThread::idealThreadCount(), QObject *parent = nullptr);
+    ~ProcessPool();
+    /**
+     * @param on_stdout if set, stdout is passed to it as it arrives instead of being kept in Result::stdout_data.
+     * it is called for the last time before on_finished
+     * @return id which kill() takes
+     */
+    JobId enqueue(const QString &program, const QStringList &arguments, Callback on_finished,
+                  OutputCallback on_stdout = nullptr);
+    /**
+     * @brief discard a queued program or kill a running one. Its callback is not called. ignored if it has finished
+     */
+    void kill(JobId id);
+    /**
+     * @brief discard queued programs and kill running ones. Callbacks of them are not called.
+     */
+    void kill_all();
+    int pending_count() const;
+    int running_count() const;
+
+   signals:
+    void all_finished();
+
+   private:
+    struct Job {
+        JobId id;
+        QString program;
+        QStringList arguments;
+        Callback on_finished;
+        OutputCallback on_stdout;
+    };
+    std::deque<Job> queue_;
+    QHash<QProcess *, JobId> running_;
+    int max_concurrency_;
+    JobId last_id_ = 0;
+
+    void start_next_();
+};
+
+#endif  // PROCESSPOOL_HPP
@@ -1,16 +1,23 @@
 #include "processwidget.hpp"
 
+#include <QLocale>
 #include <QMessageBox>
 #include <QProcess>
 #include <QTextEdit>
 #include <QTextStream>
 #include <QTime>
+#include <algorithm>
+#include <memory>
+#include <thread>
 
 #include "ui_processwidget.h"
 
 ProcessWidget::ProcessWidget(QWidget *parent, Qt::WindowFlags flags)
-    : QWidget(parent, flags), ui_(new Ui::ProcessWidget) {
+    : QWidget(parent, flags), ui_(new Ui::ProcessWidget), sampler_(new QTimer(this)) {
     ui_->setupUi(this);
+    sampler_->setInterval(SAMPLE_INTERVAL);
+    connect(sampler_, &QTimer::timeout, this, &ProcessWidget::sample_usage_);
+    clear_resource_panel_();
     ui_->label_status->setText(tr("Executing nothing."));
     enable_closing_();
     connect(ui_->pushButton_close, &QPushButton::clicked, this, &ProcessWidget::do_close_);
@@ -100,6 +107,12 @@ void ProcessWidget::start(const QString &command, const QStringList &arguments,
     }
 
     ui_->label_status->setText(tr("Starting %1").arg(command));
+    started_at_ = std::chrono::steady_clock::now();
+    process_id_ = 0;
+    usage_ = std::nullopt;
+    exit_usage_ = {};
+    monitored_ = {};
+    clear_resource_panel_();
 
     emit start_process(command, arguments, QIODeviceBase::ReadWrite);
 }
@@ -117,10 +130,29 @@ void ProcessWidget::clear_stderr(int index) {
 }
 void ProcessWidget::update_label_on_start_() {
     ui_->label_status->setText(tr("Executing %1 (pid=%2)").arg(process_->program()).arg(process_->processId()));
+    process_id_ = process_->processId();
+    // QProcess reaps the process before finished is emitted, and /proc has nothing of it after that
+    auto exit_usage = std::make_shared<std::promise<std::optional<concat::ProcessStat>>>();
+    exit_usage_ = exit_usage->get_future();
+    std::thread([exit_usage, pid = process_id_] { exit_usage->set_value(concat::wait_for_exit_stat(pid)); }).detach();
+    sample_usage_();
+    sampler_->start();
 }
 void ProcessWidget::update_label_on_finish_(int exit_code, QProcess::ExitStatus exit_status) {
+    sampler_->stop();
+    take_exit_usage_();
+    clear_resource_panel_();
+    record_command_(exit_status == QProcess::NormalExit && exit_code == 0);
     switch (exit_status) {
         case QProcess::NormalExit:
+            if (exit_code != 0) {
+                // following steps are not run, so the window has to be closable
+                ui_->label_status->setText(
+                    tr("Execution of %1 has failed with exit code %2.").arg(process_->program()).arg(exit_code));
+                enable_closing_();
+                emit finished(false);
+                break;
+            }
             ui_->label_status->setText(
                 tr("Execution of %1 has finished with exit code %2.").arg(process_->program()).arg(exit_code));
             emit finished(true);
@@ -150,8 +182,21 @@ bool ProcessWidget::wait_for_finished_with_check(int timeout_msec) {
 
     return true;
 }
+void ProcessWidget::add_report(const QString &title, const QString &text) {
+    auto report_content = new QWidget;
+    auto report_layout = new QGridLayout(report_content);
+    auto report_textedit = new QTextEdit(report_content);
+    report_textedit->setReadOnly(true);
+    report_textedit->setLineWrapMode(QTextEdit::NoWrap);
+    report_textedit->setPlainText(text);
+    report_layout->addWidget(report_textedit);
+    ui_->tab_reports_items->setCurrentIndex(ui_->tab_reports_items->addTab(report_content, title));
+}
+void ProcessWidget::show_status(const QString &text) { ui_->label_status->setText(text); }
+void ProcessWidget::finish() { enable_closing_(); }
 QString ProcessWidget::program() { return process_->program(); }
 QStringList ProcessWidget::arguments() { return process_->arguments(); };
+qint64 ProcessWidget::process_id() { return process_ == nullptr ? 0 : process_->processId(); }
 void ProcessWidget::update_stdout_() {
     process_->setReadChannel(QProcess::StandardOutput);
     auto textedit = stdout_textedit_of_(current_stdout_tab_idx_);
@@ -193,6 +238,93 @@ void ProcessWidget::show_error_(QProcess::ProcessError err) {
     }
     QMessageBox::critical(this, tr("error"), tr("error: %1").arg(process_->errorString()));
 }
+void ProcessWidget::sample_usage_() {
+    auto usage = concat::read_process_stat(process_id_);
+    if (not usage.has_value()) {
+        return;
+    }
+    usage_ = usage;
+    auto now = std::chrono::steady_clock::now();
+    if (not monitored_.usage.has_value()) {
+        monitored_ = {now, usage};
+    } else if (now - monitored_.time >= MONITOR_INTERVAL) {
+        update_resource_panel_(now, usage.value());
+        monitored_ = {now, usage};
+    }
+}
+void ProcessWidget::take_exit_usage_() {
+    if (not exit_usage_.valid() || exit_usage_.wait_for(EXIT_USAGE_TIMEOUT) != std::future_status::ready) {
+        return;
+    }
+    auto usage = exit_usage_.get();
+    if (not usage.has_value()) {
+        return;
+    }
+    // counters only grow, so the last sample covers those which were lost if the process was reaped while reading
+    if (usage_.has_value()) {
+        usage->cpu_seconds = std::max(usage->cpu_seconds, usage_->cpu_seconds);
+        usage->rss_bytes = usage_->rss_bytes;  // not reported after exiting
+        usage->read_chars = std::max(usage->read_chars, usage_->read_chars);
+        usage->write_chars = std::max(usage->write_chars, usage_->write_chars);
+        usage->read_bytes = std::max(usage->read_bytes, usage_->read_bytes);
+        usage->write_bytes = std::max(usage->write_bytes, usage_->write_bytes);
+    }
+    usage_ = usage;
+}
+void ProcessWidget::update_resource_panel_(std::chrono::steady_clock::time_point now,
+                                           const concat::ProcessStat &usage) {
+    std::chrono::duration<double> interval = now - monitored_.time;
+    auto rates = concat::process_rates(monitored_.usage.value(), usage, interval.count());
+    auto cpu_count = std::thread::hardware_concurrency();
+    QLocale locale;
+    auto format_rate = [&locale](double bytes_per_second) {
+        return tr("%1/s").arg(locale.formattedDataSize(static_cast<qint64>(bytes_per_second)));
+    };
+    ui_->label_cpu->setText(tr("CPU: %1% of %2%").arg(rates.cpu_cores * 100, 0, 'f', 0).arg(cpu_count * 100));
+    ui_->label_rss->setText(tr("RSS: %1").arg(locale.formattedDataSize(static_cast<qint64>(usage.rss_bytes))));
+    ui_->label_read->setText(tr("read: %1 (storage: %2)")
+                                 .arg(format_rate(rates.read_bytes_per_second))
+                                 .arg(format_rate(rates.storage_read_bytes_per_second)));
+    ui_->label_write->setText(tr("write: %1").arg(format_rate(rates.write_bytes_per_second)));
+    QString hint;
+    switch (concat::guess_bottleneck(usage, rates, cpu_count)) {
+        case concat::Bottleneck::NONE:
+            hint = tr("waiting (little CPU or I/O)");
+            break;
+        case concat::Bottleneck::STOPPED:
+            hint = tr("stopped");
+            break;
+        case concat::Bottleneck::CPU:
+            hint = tr("CPU-bound");
+            break;
+        case concat::Bottleneck::SINGLE_THREAD:
+            hint = tr("CPU-bound on one thread");
+            break;
+        case concat::Bottleneck::IO_WAIT:
+            hint = tr("uninterruptible I/O wait");
+            break;
+        case concat::Bottleneck::STORAGE:
+            hint = tr("disk-bound");
+            break;
+        case concat::Bottleneck::OTHER_IO:
+            hint = tr("network- or pipe-bound");
+            break;
+        default:
+            Q_UNREACHABLE();
+    }
+    ui_->label_bottleneck->setText(tr("likely %1").arg(hint));
+}
+void ProcessWidget::clear_resource_panel_() {
+    ui_->label_cpu->setText(tr("CPU: -"));
+    ui_->label_rss->setText(tr("RSS: -"));
+    ui_->label_read->setText(tr("read: -"));
+    ui_->label_write->setText(tr("write: -"));
+    ui_->label_bottleneck->setText(QStringLiteral("-"));
+}
+void ProcessWidget::record_command_(bool is_success) {
+    emit command_finished({process_->program(), process_->arguments(), process_id_, started_at_,
+                           std::chrono::steady_clock::now(), is_success, usage_});
+}
 void ProcessWidget::do_close_() {
     thread_.quit();
     if (thread_.isRunning()) {
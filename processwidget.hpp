@@ -5,13 +5,17 @@
 #include <QString>
 #include <QStringLiteral>
 #include <QThread>
+#include <QTimer>
 #include <QWidget>
 #include <chrono>
 #include <functional>
+#include <future>
 #include <list>
 #include <numeric>
 #include <optional>
 
+#include "procstat.hpp"
+
 namespace Ui {
 class ProcessWidget;
 }
@@ -24,6 +28,21 @@ class ProcessWidget : public QWidget {
    public:
     explicit ProcessWidget(QWidget *parent = nullptr, Qt::WindowFlags flags = Qt::WindowFlags());
     ~ProcessWidget();
+    /**
+     * @brief a command which has finished. usage is read when it exits. if that fails, usage is as of the last sample,
+     * taken every SAMPLE_INTERVAL while it runs
+     */
+    struct CommandRecord {
+        QString program;
+        QStringList arguments;
+        qint64 process_id;
+        std::chrono::steady_clock::time_point started;
+        std::chrono::steady_clock::time_point finished;
+        bool is_success;
+        std::optional<concat::ProcessStat> usage;  // std::nullopt if the command could not be read at all
+    };
+    static constexpr std::chrono::milliseconds SAMPLE_INTERVAL{250};
+    static constexpr std::chrono::milliseconds MONITOR_INTERVAL{1000};  // of rates shown in the resource panel
     class ProgressParams {
        public:
         using Clock = std::chrono::high_resolution_clock;
@@ -131,9 +150,38 @@ class ProcessWidget : public QWidget {
     void clear_stderr(int index = -1);
     QString program();
     QStringList arguments();
+    /**
+     * @brief process id of the latest command
+     * @retval 0 no process is running
+     */
+    qint64 process_id();
+    /**
+     * @brief show text which is not output of process (e.g. result of analysis) in reports tab
+     *
+     * @param title title of tab
+     * @param text plain text
+     */
+    void add_report(const QString &title, const QString &text);
+    /**
+     * @brief show progress of work which is not done by a process (e.g. jobs on a ProcessPool)
+     *
+     * @param text plain text
+     */
+    void show_status(const QString &text);
+    /**
+     * @brief enable close button. used when the last step is not a process started with is_final
+     */
+    void finish();
 
    signals:
+    /**
+     * @param is_success true if the program exited normally with exit code 0
+     */
     void finished(bool is_success);
+    /**
+     * @brief emitted just before finished()
+     */
+    void command_finished(const ProcessWidget::CommandRecord &record);
 
    private:
     Ui::ProcessWidget *ui_;
@@ -142,6 +190,16 @@ class ProcessWidget : public QWidget {
     int current_stdout_tab_idx_ = -1;
     int current_stderr_tab_idx_ = -1;
     ProgressParams current_progress_params_;
+    std::chrono::steady_clock::time_point started_at_;
+    qint64 process_id_ = 0;  // kept after the process is reaped
+    std::optional<concat::ProcessStat> usage_;
+    std::future<std::optional<concat::ProcessStat>> exit_usage_;  // read when the process exits, before it is reaped
+    static constexpr std::chrono::milliseconds EXIT_USAGE_TIMEOUT{100};
+    QTimer *sampler_;
+    struct {
+        std::chrono::steady_clock::time_point time;
+        std::optional<concat::ProcessStat> usage;  // at time
+    } monitored_;  // the sample which rates in the resource panel are computed from
    signals:
     void start_process(const QString &command, const QStringList &arguments, QIODeviceBase::OpenMode);
     void sigkill();
@@ -154,11 +212,16 @@ class ProcessWidget : public QWidget {
     void enable_closing_();
     void do_close_();
     void show_error_(QProcess::ProcessError error);
+    void sample_usage_();
 
    private:
     QTextEdit *stdout_textedit_of_(int idx);
     QTextEdit *stderr_textedit_of_(int idx);
     void update_progress_(QStringView stdout_text, QStringView stderr_text);
+    void take_exit_usage_();  // into usage_
+    void record_command_(bool is_success);
+    void update_resource_panel_(std::chrono::steady_clock::time_point now, const concat::ProcessStat &usage);
+    void clear_resource_panel_();
 };
 
 #endif  // PROCESSWIDGET_HPP
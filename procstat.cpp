@@ -0,0 +1,126 @@
+#include "procstat.hpp"
+
+#include <algorithm>
+#include <ciso646>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#ifdef __linux__
+#    include <sys/wait.h>
+#    include <unistd.h>
+#endif
+
+namespace concat {
+namespace {
+// fraction of a resource regarded as fully used
+constexpr double BUSY = 0.85;
+// bytes per second below which a process is not regarded as doing I/O
+constexpr double ACTIVE_IO = 1024 * 1024;
+double rate(std::uint64_t previous, std::uint64_t current, double seconds) {
+    return current > previous ? static_cast<double>(current - previous) / seconds : 0.0;
+}
+}  // namespace
+ProcessRates process_rates(const ProcessStat &previous, const ProcessStat &current, double seconds) {
+    if (seconds <= 0) {
+        return {};
+    }
+    ProcessRates result;
+    result.cpu_cores = std::max(current.cpu_seconds - previous.cpu_seconds, 0.0) / seconds;
+    result.read_bytes_per_second = rate(previous.read_chars, current.read_chars, seconds);
+    result.write_bytes_per_second = rate(previous.write_chars, current.write_chars, seconds);
+    result.storage_read_bytes_per_second = rate(previous.read_bytes, current.read_bytes, seconds);
+    return result;
+}
+Bottleneck guess_bottleneck(const ProcessStat &current, const ProcessRates &rates, unsigned cpu_count) {
+    cpu_count = std::max(cpu_count, 1u);
+    if (current.state == 'T' || current.state == 't') {
+        return Bottleneck::STOPPED;
+    }
+    if (rates.cpu_cores >= BUSY * cpu_count) {
+        return Bottleneck::CPU;
+    }
+    // D is also entered for network filesystems and page faults, so it does not tell the kind of I/O
+    if (current.state == 'D') {
+        return Bottleneck::IO_WAIT;
+    }
+    if (cpu_count > 1 && rates.cpu_cores >= BUSY && rates.cpu_cores < 1 + (1 - BUSY)) {
+        return Bottleneck::SINGLE_THREAD;
+    }
+    if (rates.read_bytes_per_second + rates.write_bytes_per_second < ACTIVE_IO) {
+        return Bottleneck::NONE;
+    }
+    // writes are counted when pages are dirtied on any filesystem, so only reads tell where data comes from
+    if (rates.read_bytes_per_second >= ACTIVE_IO &&
+        rates.storage_read_bytes_per_second < rates.read_bytes_per_second * (1 - BUSY)) {
+        return Bottleneck::OTHER_IO;
+    }
+    return Bottleneck::STORAGE;
+}
+#ifdef __linux__
+namespace {
+std::string proc_path(std::int64_t pid, const char *name) { return "/proc/" + std::to_string(pid) + "/" + name; }
+}  // namespace
+std::optional<ProcessStat> read_process_stat(std::int64_t pid) {
+    ProcessStat result;
+    std::ifstream stat(proc_path(pid, "stat"));
+    std::string line;
+    if (not std::getline(stat, line)) {
+        return std::nullopt;
+    }
+    // comm in parentheses may contain spaces, so fields are counted from the last ')'
+    auto comm_end = line.rfind(')');
+    if (comm_end == std::string::npos) {
+        return std::nullopt;
+    }
+    std::istringstream fields(line.substr(comm_end + 1));
+    fields >> result.state;
+    std::string field;
+    std::uint64_t utime = 0;
+    std::uint64_t stime = 0;
+    // utime and stime are fields 14 and 15. the state is field 3
+    for (auto number = 4; number <= 15 && fields >> field; number++) {
+        if (number == 14) {
+            utime = std::stoull(field);
+        } else if (number == 15) {
+            stime = std::stoull(field);
+        }
+    }
+    result.cpu_seconds = static_cast<double>(utime + stime) / ::sysconf(_SC_CLK_TCK);
+    std::ifstream status(proc_path(pid, "status"));
+    while (std::getline(status, line)) {
+        if (line.rfind("VmRSS:", 0) == 0) {
+            result.rss_bytes = std::stoull(line.substr(6)) * 1024;  // in kB
+            break;
+        }
+    }
+    // not readable unless the process is ours. usage is reported without I/O then
+    std::ifstream io(proc_path(pid, "io"));
+    std::string key;
+    std::uint64_t value;
+    while (io >> key >> value) {
+        if (key == "rchar:") {
+            result.read_chars = value;
+        } else if (key == "wchar:") {
+            result.write_chars = value;
+        } else if (key == "read_bytes:") {
+            result.read_bytes = value;
+        } else if (key == "write_bytes:") {
+            result.write_bytes = value;
+        }
+    }
+    return result;
+}
+std::optional<ProcessStat> wait_for_exit_stat(std::int64_t pid) {
+    siginfo_t info{};
+    // WNOWAIT leaves the child to be reaped by its owner. __WALL also finds children started by clone()
+    if (::waitid(P_PID, static_cast<id_t>(pid), &info, WEXITED | WNOWAIT | __WALL) != 0) {
+        return std::nullopt;
+    }
+    return read_process_stat(pid);
+}
+#else
+std::optional<ProcessStat> read_process_stat(std::int64_t) { return std::nullopt; }
+std::optional<ProcessStat> wait_for_exit_stat(std::int64_t) { return std::nullopt; }
+#endif
+}  // namespace concat
@@ -0,0 +1,61 @@
+#ifndef VIDEO_CONCATENATER_PROCSTAT
+#define VIDEO_CONCATENATER_PROCSTAT
+
+#include <cstdint>
+#include <optional>
+
+namespace concat {
+/**
+ * @brief resource usage of a process read from /proc. counters are totals since the process started
+ */
+struct ProcessStat {
+    char state = '?';        // R, S, D (uninterruptible wait, usually for I/O), T (stopped), ...
+    double cpu_seconds = 0;  // user + system
+    std::uint64_t rss_bytes = 0;
+    std::uint64_t read_chars = 0;  // all reads, including pipes and network filesystems
+    std::uint64_t write_chars = 0;
+    std::uint64_t read_bytes = 0;  // reads which reached a block device
+    std::uint64_t write_bytes = 0;
+};
+/**
+ * @note Linux only. std::nullopt is always returned on other platforms.
+ * @retval std::nullopt the process does not exist (e.g. already reaped), or it is not readable
+ */
+std::optional<ProcessStat> read_process_stat(std::int64_t pid);
+/**
+ * @brief wait until a child process exits, then read its final usage without reaping it
+ * @details The exited child keeps its CPU time and I/O counters until its parent reaps it, so a command which exits
+ * between two samples is still measured. Whoever started it (e.g. QProcess) reaps it as usual; if that happens first,
+ * counters are missing or 0. rss_bytes is always 0.
+ * @note Linux only. This blocks until the child exits, so it is called on a thread of its own.
+ * @retval std::nullopt the process is not a child of this process or has already been reaped, or on other platforms
+ */
+std::optional<ProcessStat> wait_for_exit_stat(std::int64_t pid);
+/**
+ * @brief usage per second between two samples of the same process
+ */
+struct ProcessRates {
+    double cpu_cores = 0;  // CPU time per wall time. 1 is one core fully busy
+    double read_bytes_per_second = 0;
+    double write_bytes_per_second = 0;
+    double storage_read_bytes_per_second = 0;  // part of reads which reached a block device
+};
+ProcessRates process_rates(const ProcessStat &previous, const ProcessStat &current, double seconds);
+enum class Bottleneck {
+    NONE,           // little CPU or I/O. e.g. waiting for input from a pipe
+    STOPPED,        // e.g. paused until the next staged input is ready
+    CPU,            // all cores are busy
+    SINGLE_THREAD,  // about one core is busy while others are idle
+    IO_WAIT,        // in uninterruptible sleep (D). usually I/O of a block device or a network filesystem
+    STORAGE,        // doing I/O which reaches a block device
+    OTHER_IO,       // I/O served by network filesystems, pipes or the page cache
+};
+/**
+ * @brief guess what limits the speed of a process from one interval
+ * @details This is a hint from a single sample of the state and usage over the interval, not a measurement of
+ * waiting time.
+ * @param cpu_count cores available to the process
+ */
+Bottleneck guess_bottleneck(const ProcessStat &current, const ProcessRates &rates, unsigned cpu_count);
+}  // namespace concat
+#endif
@@ -0,0 +1,76 @@
+#include "rendition.hpp"
+
+#include <QFileInfo>
+#include <QRegularExpression>
+#include <ciso646>
+
+namespace concat {
+namespace {
+constexpr auto SAME_AS_MAIN = "-";
+}  // namespace
+std::optional<Rendition> parse_rendition(const QString &text) {
+    auto fields = text.split(QRegularExpression(R"(\s+)"), Qt::SkipEmptyParts);
+    if (fields.size() < 4) {
+        return std::nullopt;
+    }
+    Rendition result;
+    result.name = fields[0];
+    if (result.name == SAME_AS_MAIN || result.name.contains(QRegularExpression(R"([/\\:*?"<>|])"))) {
+        return std::nullopt;
+    }
+    if (fields[1] != SAME_AS_MAIN) {
+        auto match = QRegularExpression(R"(^(\d+)x(\d+)$)").match(fields[1]);
+        if (not match.hasMatch()) {
+            return std::nullopt;
+        }
+        result.resolution = QSize(match.captured(1).toInt(), match.captured(2).toInt());
+        if (not result.resolution.isValid() || result.resolution.isEmpty()) {
+            return std::nullopt;
+        }
+    }
+    if (fields[2] != SAME_AS_MAIN) {
+        result.video_codec = fields[2];
+    }
+    if (fields[3] != SAME_AS_MAIN) {
+        result.audio_codec = fields[3];
+    }
+    if (result.resolution.isValid() && result.video_codec.isEmpty()) {
+        return std::nullopt;  // copied stream cannot be scaled
+    }
+    for (auto i = 4; i < fields.size(); i++) {
+        result.encoding_args << fields[i];
+    }
+    return result;
+}
+QString format_rendition(const Rendition &rendition) {
+    QStringList fields;
+    fields << rendition.name;
+    fields << (rendition.resolution.isValid()
+                   ? QStringLiteral("%1x%2").arg(rendition.resolution.width()).arg(rendition.resolution.height())
+                   : SAME_AS_MAIN);
+    fields << (rendition.video_codec.isEmpty() ? SAME_AS_MAIN : rendition.video_codec);
+    fields << (rendition.audio_codec.isEmpty() ? SAME_AS_MAIN : rendition.audio_codec);
+    for (const auto &arg : rendition.encoding_args) {
+        fields << arg;
+    }
+    return fields.join(" ");
+}
+QStringList rendition_arguments(const Rendition &rendition) {
+    QStringList result;
+    // clang-format off
+    result << "-map" << "0:v:0"
+           << "-map" << "0:a:0?"
+           << "-c:v" << (rendition.video_codec.isEmpty() ? QStringLiteral("copy") : rendition.video_codec)
+           << "-c:a" << (rendition.audio_codec.isEmpty() ? QStringLiteral("copy") : rendition.audio_codec);
+    // clang-format on
+    if (rendition.resolution.isValid()) {
+        result << "-s" << QStringLiteral("%1x%2").arg(rendition.resolution.width()).arg(rendition.resolution.height());
+    }
+    result += rendition.encoding_args;
+    return result;
+}
+QString rendition_path(const QString &result_path, const QString &name) {
+    QFileInfo info(result_path);
+    return info.dir().filePath(QStringLiteral("%1_%2.%3").arg(info.completeBaseName(), name, info.suffix()));
+}
+}  // namespace concat
@@ -0,0 +1,28 @@
+#ifndef VIDEO_CONCATENATER_RENDITION
+#define VIDEO_CONCATENATER_RENDITION
+
+#include <QString>
+#include <QStringList>
+#include <optional>
+
+#include "videoinfo.hpp"
+
+namespace concat {
+/**
+ * @brief "name WIDTHxHEIGHT video_codec audio_codec [encoding arguments...]". "-" keeps the value of the main output
+ * @retval std::nullopt text is not a rendition
+ */
+std::optional<Rendition> parse_rendition(const QString &text);
+QString format_rendition(const Rendition &rendition);
+/**
+ * @brief options of ffmpeg placed before the output file of the rendition
+ * @details ffmpeg decodes each input stream once and feeds the frames to encoders of every output, so renditions
+ * added to the concatenating run share demuxing and decoding with the main output.
+ */
+QStringList rendition_arguments(const Rendition &rendition);
+/**
+ * @brief "<dir>/<base name>_<name>.<suffix>"
+ */
+QString rendition_path(const QString &result_path, const QString &name);
+}  // namespace concat
+#endif
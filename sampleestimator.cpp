@@ -0,0 +1,96 @@
+#include "sampleestimator.hpp"
+
+#include <QFile>
+#include <QFileInfo>
+#include <ciso646>
+#include <cmath>
+
+SampleEstimator::SampleEstimator(const QString &work_dir, QObject *parent)
+    : QObject(parent), work_dir_(work_dir), pool_(new ProcessPool(QThread::idealThreadCount(), this)) {
+    connect(pool_, &ProcessPool::all_finished, this, &SampleEstimator::finish_);
+}
+
+void SampleEstimator::start(const QVector<Input> &inputs, const QStringList &input_arguments,
+                            const QStringList &output_arguments) {
+    cancel();
+    samples_.clear();
+    errors_.clear();
+    total_input_duration_ = 0;
+    for (const auto &input : inputs) {
+        total_input_duration_ += input.duration;
+    }
+    if (not work_dir_.mkpath(".")) {
+        errors_ << tr("failed to create directory [%1]").arg(work_dir_.path());
+    }
+    if (inputs.isEmpty() || not errors_.isEmpty()) {
+        is_running_ = true;
+        finish_();
+        return;
+    }
+    // with many inputs, samples are taken from evenly spaced inputs and extrapolated by duration
+    auto sample_count = qMin(static_cast<int>(inputs.size()), MAX_SAMPLES);
+    samples_.resize(sample_count);
+    is_running_ = true;
+    started_at_ = std::chrono::steady_clock::now();
+    for (auto i = 0; i < sample_count; i++) {
+        const auto &input = inputs[static_cast<int>(static_cast<double>(i) * inputs.size() / sample_count)];
+        auto sample_duration = qMin(SAMPLE_DURATION, input.duration);
+        auto sample_start = qMax(0.0, input.duration / 2 - sample_duration / 2);
+        samples_[i] = {input.duration, sample_duration, std::nullopt, {}};
+        auto output_path = work_dir_.filePath(QStringLiteral("sample%1.mkv").arg(i));
+        QStringList arguments;
+        // clang-format off
+        arguments << "-hide_banner" << "-y"
+                  << "-ss" << QString::number(sample_start, 'f', 3)
+                  << "-t" << QString::number(sample_duration, 'f', 3)
+                  << input_arguments
+                  << "-i" << input.path
+                  << output_arguments
+                  << output_path;
+        // clang-format on
+        auto name = QFileInfo(input.path).fileName();
+        pool_->enqueue("ffmpeg", arguments, [this, i, name, output_path](const ProcessPool::Result &result) {
+            samples_[i].elapsed = result.elapsed;
+            if (result.is_success) {
+                samples_[i].size = QFileInfo(output_path).size();
+            } else {
+                errors_ << tr("failed to encode sample of %1 (exit code %2)").arg(name).arg(result.exit_code);
+            }
+            QFile::remove(output_path);
+        });
+    }
+}
+
+void SampleEstimator::cancel() {
+    pool_->kill_all();
+    is_running_ = false;
+}
+
+bool SampleEstimator::is_running() const { return is_running_; }
+
+void SampleEstimator::finish_() {
+    if (not is_running_) {
+        return;
+    }
+    is_running_ = false;
+    std::chrono::duration<double> batch_wall_time = std::chrono::steady_clock::now() - started_at_;
+    double sampled_input_duration = 0, sampled_duration = 0, sampled_size = 0;
+    int succeeded_count = 0;
+    for (const auto &sample : samples_) {
+        if (sample.size.has_value()) {
+            sampled_input_duration += sample.input_duration;
+            sampled_duration += sample.sample_duration;
+            sampled_size += sample.size.value() / sample.sample_duration * sample.input_duration;
+            succeeded_count++;
+        }
+    }
+    Estimate estimate{static_cast<std::uintmax_t>(-1), std::chrono::duration<double>(NAN), succeeded_count, errors_};
+    if (succeeded_count > 0 && sampled_duration > 0) {
+        // samples not taken (MAX_SAMPLES exceeded) are extrapolated by duration
+        estimate.size = static_cast<std::uintmax_t>(sampled_size / sampled_input_duration * total_input_duration_);
+        // samples ran in parallel, so aggregated throughput (media seconds per wall second) is used
+        auto throughput = sampled_duration / batch_wall_time.count();
+        estimate.wall_time = std::chrono::duration<double>(total_input_duration_ / throughput);
+    }
+    emit finished(estimate);
+}
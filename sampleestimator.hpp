@@ -0,0 +1,66 @@
+#ifndef SAMPLEESTIMATOR_HPP
+#define SAMPLEESTIMATOR_HPP
+
+#include <QDir>
+#include <QObject>
+#include <QStringList>
+#include <QVector>
+#include <chrono>
+#include <cstdint>
+#include <optional>
+
+#include "processpool.hpp"
+
+/**
+ * @brief estimates size and wall time of re-encoding by encoding short samples of inputs in parallel
+ */
+class SampleEstimator : public QObject {
+    Q_OBJECT
+
+   public:
+    struct Input {
+        QString path;
+        double duration;  // seconds
+    };
+    struct Estimate {
+        std::uintmax_t size;
+        std::chrono::duration<double> wall_time;
+        int sample_count;
+        QStringList errors;
+    };
+
+    SampleEstimator(const QString &work_dir, QObject *parent = nullptr);
+    /**
+     * @brief encode samples with the options of the actual encode
+     *
+     * @param input_arguments options applied to each input, before "-i"
+     * @param output_arguments codecs and encoding options, as passed to the actual encode
+     */
+    void start(const QVector<Input> &inputs, const QStringList &input_arguments, const QStringList &output_arguments);
+    void cancel();
+    bool is_running() const;
+
+   signals:
+    void finished(const SampleEstimator::Estimate &estimate);
+
+   private:
+    QDir work_dir_;
+    ProcessPool *pool_;  // deleted when this(SampleEstimator) is deleted
+    struct Sample {
+        double input_duration;
+        double sample_duration;
+        std::optional<std::uintmax_t> size;
+        std::chrono::duration<double> elapsed;
+    };
+    QVector<Sample> samples_;
+    QStringList errors_;
+    double total_input_duration_ = 0;
+    std::chrono::steady_clock::time_point started_at_;
+    bool is_running_ = false;
+    static constexpr double SAMPLE_DURATION = 8.0;  // seconds
+    static constexpr int MAX_SAMPLES = 16;
+
+    void finish_();
+};
+
+#endif  // SAMPLEESTIMATOR_HPP
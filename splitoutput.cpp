@@ -0,0 +1,107 @@
+#include "splitoutput.hpp"
+
+#include <QFileInfo>
+#include <algorithm>
+#include <ciso646>
+#include <stdexcept>
+
+namespace concat {
+namespace {
+// container overhead (moov, mdat header, ...) is estimated as this fraction of the part
+constexpr double CONTAINER_OVERHEAD = 0.01;
+// limits which make parts shorter than this are rejected
+constexpr double MIN_PART_DURATION = 1;
+constexpr double EPSILON = 1e-6;
+}  // namespace
+QVector<double> split_points(const QVector<RatedSpan> &spans, qint64 max_part_size, double max_part_duration,
+                             double keyframe_margin) {
+    QVector<double> result;
+    double time = 0;
+    double part_start = 0;
+    double part_size = 0;
+    for (const auto &span : spans) {
+        auto span_end = time + span.duration;
+        while (time < span_end - EPSILON) {
+            auto part_end = span_end;
+            if (max_part_duration > 0) {
+                part_end = std::min(part_end, part_start + max_part_duration - keyframe_margin);
+            }
+            if (max_part_size > 0 && span.bytes_per_second > 0) {
+                auto budget = max_part_size * (1 - CONTAINER_OVERHEAD) - part_size -
+                              keyframe_margin * span.bytes_per_second;
+                part_end = std::min(part_end, time + std::max(budget, 0.0) / span.bytes_per_second);
+            }
+            if (part_end - part_start < MIN_PART_DURATION && part_end < span_end - EPSILON) {
+                // stretching the part would break the limits, and splitting here would never end
+                throw std::invalid_argument(
+                    "limits of a part are too small. each part must be able to hold at least 1 second, plus the "
+                    "margin for the next keyframe when video is copied");
+            }
+            if (part_end >= span_end - EPSILON) {
+                part_size += (span_end - time) * span.bytes_per_second;
+                time = span_end;
+            } else {
+                result << part_end;
+                time = part_start = part_end;
+                part_size = 0;
+            }
+        }
+        time = span_end;
+    }
+    return result;
+}
+QStringList segment_arguments(const QVector<double> &points, const QString &format, const QString &list_path) {
+    QStringList times;
+    for (auto point : points) {
+        times << QString::number(point, 'f', 6);
+    }
+    QStringList result;
+    // clang-format off
+    result << "-f" << "segment"
+           << "-segment_format" << format
+           << "-reset_timestamps" << "1"
+           << "-segment_list" << list_path
+           << "-segment_list_type" << "csv";
+    // clang-format on
+    if (not times.isEmpty()) {
+        result << "-segment_times" << times.join(",");
+    } else {
+        result << "-segment_time" << "1e9";  // a single part
+    }
+    return result;
+}
+QVector<SegmentListEntry> parse_segment_list(const QByteArray &csv) {
+    QVector<SegmentListEntry> result;
+    for (const auto &line : csv.split('\n')) {
+        auto fields = QString::fromUtf8(line.trimmed()).split(',');
+        if (fields.size() < 3) {
+            continue;
+        }
+        // filename may contain commas. start and end are always the last two fields
+        auto end = fields.takeLast().toDouble();
+        auto start = fields.takeLast().toDouble();
+        auto filename = fields.join(',');
+        if (filename.startsWith('"') && filename.endsWith('"')) {
+            filename = filename.mid(1, filename.size() - 2).replace("\"\"", "\"");
+        }
+        result.push_back({filename, start, end});
+    }
+    return result;
+}
+std::vector<Mp4Chapter> chapters_of_part(const std::vector<Mp4Chapter> &chapters, double start, double end) {
+    std::vector<Mp4Chapter> result;
+    for (std::size_t i = 0; i < chapters.size(); i++) {
+        auto chapter_end = i + 1 < chapters.size() ? chapters[i + 1].start : end;
+        if (chapters[i].start >= end - EPSILON || chapter_end <= start + EPSILON) {
+            continue;
+        }
+        result.push_back({std::max(chapters[i].start - start, 0.0), chapters[i].title});
+    }
+    return result;
+}
+QString part_path(const QString &result_path, int index) {
+    QFileInfo info(result_path);
+    return info.dir().filePath(
+        QStringLiteral("%1_%2.%3").arg(info.completeBaseName()).arg(index, 3, 10, QLatin1Char('0')).arg(info.suffix()));
+}
+}  // namespace concat
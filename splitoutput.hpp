@@ -0,0 +1,53 @@
+#ifndef VIDEO_CONCATENATER_SPLITOUTPUT
+#define VIDEO_CONCATENATER_SPLITOUTPUT
+
+#include <QByteArray>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <vector>
+
+#include "mp4box.hpp"
+
+namespace concat {
+/**
+ * @brief a range of output timeline with constant data rate
+ */
+struct RatedSpan {
+    double duration;          // seconds
+    double bytes_per_second;  // 0 if unknown
+};
+/**
+ * @brief times (seconds, on output timeline) where a new part should start
+ * @details Each part is kept shorter than the limits by keyframe_margin seconds, because the segment muxer starts a
+ * new part at the first keyframe at or after each time.
+ * @param max_part_size bytes. no limit if not positive
+ * @param max_part_duration seconds. no limit if not positive
+ * @throw std::invalid_argument the limits leave less than 1 second for a part, after keyframe_margin is subtracted
+ */
+QVector<double> split_points(const QVector<RatedSpan> &spans, qint64 max_part_size, double max_part_duration,
+                             double keyframe_margin);
+/**
+ * @brief options of ffmpeg's segment muxer which write parts at split points and a csv list of actual part ranges
+ */
+QStringList segment_arguments(const QVector<double> &points, const QString &format, const QString &list_path);
+struct SegmentListEntry {
+    QString filename;
+    double start;  // seconds on output timeline
+    double end;
+};
+/**
+ * @brief parse the list written by segment muxer with -segment_list_type csv
+ */
+QVector<SegmentListEntry> parse_segment_list(const QByteArray &csv);
+/**
+ * @brief chapters in [start, end), rebased to start. a chapter running at start begins at 0 in the part
+ * @param chapters sorted by start
+ */
+std::vector<Mp4Chapter> chapters_of_part(const std::vector<Mp4Chapter> &chapters, double start, double end);
+/**
+ * @brief "<dir>/<base name>_<index>.<suffix>". index is 1-based and zero-padded to 3 digits
+ */
+QString part_path(const QString &result_path, int index);
+}  // namespace concat
+#endif
@@ -0,0 +1,235 @@
+#include "staging.hpp"
+
+#include <algorithm>
+#include <ciso646>
+#include <fstream>
+#include <system_error>
+
+#ifdef __linux__
+#    include <fcntl.h>
+#    include <signal.h>
+#    include <unistd.h>
+
+#    include <cerrno>
+
+#    include "fileio.hpp"
+#endif
+
+namespace concat {
+namespace fs = std::filesystem;
+namespace {
+// large reads keep many bytes in flight per request. chunks start at multiples of this
+constexpr std::uintmax_t CHUNK_SIZE = 8 << 20;
+}  // namespace
+struct Stager::File {
+    fs::path src;
+    fs::path dst;
+    fs::path partial;
+    std::uintmax_t size = 0;
+    std::uintmax_t chunk_count = 0;
+    std::uintmax_t next_chunk = 0;
+    std::uintmax_t done_chunks = 0;
+    bool is_started = false;
+    bool is_staged = false;
+    bool is_evicted = false;
+#ifdef __linux__
+    std::unique_ptr<FileDescriptor> src_fd;
+    std::unique_ptr<FileDescriptor> dst_fd;
+#endif
+};
+#ifdef __linux__
+bool Stager::is_supported() { return true; }
+Stager::Stager(const std::vector<fs::path> &srcs, const fs::path &directory, int reader_count,
+               std::uintmax_t max_staged_bytes)
+    : max_staged_bytes_(max_staged_bytes) {
+    for (std::size_t i = 0; i < srcs.size(); i++) {
+        auto file = std::make_unique<File>();
+        file->src = srcs[i];
+        // index keeps names unique even if inputs in different directories share a name
+        auto name = std::to_string(i) + "_" + srcs[i].filename().string();
+        file->dst = directory / name;
+        file->partial = directory / ("." + name + ".part");
+        files_.push_back(std::move(file));
+    }
+    for (auto i = 0; i < std::max(reader_count, 1); i++) {
+        readers_.emplace_back([this] { this->read_chunks_(); });
+    }
+}
+Stager::~Stager() {
+    {
+        std::lock_guard lock(mutex_);
+        is_stopped_ = true;
+    }
+    condition_.notify_all();
+    for (auto &reader : readers_) {
+        reader.join();
+    }
+}
+void Stager::read_chunks_() {
+    std::vector<char> buffer(CHUNK_SIZE);
+    std::unique_lock lock(mutex_);
+    while (true) {
+        condition_.wait(lock, [this] {
+            if (is_stopped_ || next_file_ == files_.size()) {
+                return true;
+            }
+            // a file being staged is always continued. a new file waits for room unless it is the next one to read
+            const auto &file = *files_[next_file_];
+            return file.is_started || next_file_ <= reading_ + 1 || reserved_bytes_ < max_staged_bytes_;
+        });
+        if (is_stopped_ || next_file_ == files_.size()) {
+            return;
+        }
+        auto &file = *files_[next_file_];
+        try {
+            if (not file.is_started) {
+                file.src_fd = std::make_unique<FileDescriptor>(::open(file.src.c_str(), O_RDONLY | O_CLOEXEC));
+                if (file.src_fd->get() < 0) {
+                    throw_errno("open", file.src);
+                }
+                ::posix_fadvise(file.src_fd->get(), 0, 0, POSIX_FADV_SEQUENTIAL);
+                file.size = fs::file_size(file.src);
+                file.chunk_count = (file.size + CHUNK_SIZE - 1) / CHUNK_SIZE;
+                file.dst_fd = std::make_unique<FileDescriptor>(
+                    ::open(file.partial.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644));
+                if (file.dst_fd->get() < 0) {
+                    throw_errno("open", file.partial);
+                }
+                // chunks finish out of order, so the size is fixed first
+                if (::ftruncate(file.dst_fd->get(), static_cast<off_t>(file.size)) != 0) {
+                    throw_errno("ftruncate", file.partial);
+                }
+                file.is_started = true;
+                reserved_bytes_ += file.size;
+            }
+            if (file.next_chunk == file.chunk_count) {  // empty file
+                next_file_++;
+                file.src_fd.reset();
+                file.dst_fd.reset();
+                fs::rename(file.partial, file.dst);
+                file.is_staged = true;
+                condition_.notify_all();
+                continue;
+            }
+            auto chunk = file.next_chunk++;
+            if (file.next_chunk == file.chunk_count) {
+                next_file_++;
+            }
+            auto src_fd = file.src_fd->get();
+            auto dst_fd = file.dst_fd->get();
+            lock.unlock();
+            auto offset = static_cast<off_t>(chunk * CHUNK_SIZE);
+            auto length = static_cast<std::size_t>(std::min(CHUNK_SIZE, file.size - chunk * CHUNK_SIZE));
+            for (std::size_t done = 0; done < length;) {
+                auto result = ::pread(src_fd, buffer.data() + done, length - done, offset + done);
+                if (result < 0 && errno == EINTR) {
+                    continue;
+                }
+                if (result < 0) {
+                    throw_errno("pread", file.src);
+                }
+                if (result == 0) {
+                    throw fs::filesystem_error("pread", file.src, std::make_error_code(std::errc::io_error));
+                }
+                done += result;
+            }
+            // pages of the source are never read again
+            ::posix_fadvise(src_fd, offset, length, POSIX_FADV_DONTNEED);
+            for (std::size_t done = 0; done < length;) {
+                auto result = ::pwrite(dst_fd, buffer.data() + done, length - done, offset + done);
+                if (result < 0 && errno == EINTR) {
+                    continue;
+                }
+                if (result < 0) {
+                    throw_errno("pwrite", file.partial);
+                }
+                done += result;
+            }
+            lock.lock();
+            if (++file.done_chunks == file.chunk_count) {
+                file.src_fd.reset();
+                file.dst_fd.reset();
+                fs::rename(file.partial, file.dst);
+                file.is_staged = true;
+            }
+        } catch (std::exception &e) {
+            if (not lock.owns_lock()) {
+                lock.lock();
+            }
+            if (not error_.has_value()) {
+                error_ = e.what();
+            }
+            is_stopped_ = true;
+            condition_.notify_all();
+            return;
+        }
+    }
+}
+std::optional<std::uintmax_t> open_file_position(std::int64_t pid, const fs::path &path) {
+    std::error_code error;
+    auto fd_dir = fs::path("/proc") / std::to_string(pid) / "fd";
+    for (const auto &entry : fs::directory_iterator(fd_dir, error)) {
+        auto target = fs::read_symlink(entry.path(), error);
+        if (error || target != path) {
+            continue;
+        }
+        std::ifstream fdinfo(fs::path("/proc") / std::to_string(pid) / "fdinfo" / entry.path().filename());
+        std::string key;
+        std::uintmax_t value;
+        while (fdinfo >> key >> value) {
+            if (key == "pos:") {
+                return value;
+            }
+        }
+    }
+    return std::nullopt;
+}
+void pause_process(std::int64_t pid, bool is_paused) { ::kill(static_cast<pid_t>(pid), is_paused ? SIGSTOP : SIGCONT); }
+#else
+bool Stager::is_supported() { return false; }
+Stager::Stager(const std::vector<fs::path> &, const fs::path &, int, std::uintmax_t max_staged_bytes)
+    : max_staged_bytes_(max_staged_bytes) {}
+Stager::~Stager() {}
+void Stager::read_chunks_() {}
+std::optional<std::uintmax_t> open_file_position(std::int64_t, const fs::path &) { return std::nullopt; }
+void pause_process(std::int64_t, bool) {}
+#endif
+std::size_t Stager::size() const { return files_.size(); }
+fs::path Stager::path_of(std::size_t index) const { return files_[index]->dst; }
+std::uintmax_t Stager::size_of(std::size_t index) const {
+    std::lock_guard lock(mutex_);
+    return files_[index]->size;
+}
+bool Stager::is_staged(std::size_t index) const {
+    std::lock_guard lock(mutex_);
+    return files_[index]->is_staged;
+}
+void Stager::evict(std::size_t index) {
+    {
+        std::lock_guard lock(mutex_);
+        auto &file = *files_[index];
+        if (not file.is_staged || file.is_evicted) {
+            return;
+        }
+        std::error_code error;
+        fs::remove(file.dst, error);
+        file.is_evicted = true;
+        reserved_bytes_ -= file.size;
+    }
+    condition_.notify_all();
+}
+void Stager::set_reading(std::size_t index) {
+    {
+        std::lock_guard lock(mutex_);
+        if (index <= reading_) {
+            return;
+        }
+        reading_ = index;
+    }
+    condition_.notify_all();
+}
+std::optional<std::string> Stager::error() const {
+    std::lock_guard lock(mutex_);
+    return error_;
+}
+}  // namespace concat
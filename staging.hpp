@@ -0,0 +1,77 @@
+#ifndef VIDEO_CONCATENATER_STAGING
+#define VIDEO_CONCATENATER_STAGING
+
+#include <condition_variable>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace concat {
+/**
+ * @brief copies inputs on slow mounts to a local directory ahead of the process which reads them
+ * @details Files are split into aligned chunks, which reader threads copy with pread()/pwrite(). Network filesystems
+ * then have several requests in flight instead of one sequential stream. Files are staged in the given order, and a
+ * staged file appears at path_of() only when it is complete.
+ * @note Linux only. is_supported() returns false on other platforms.
+ */
+class Stager {
+   public:
+    static bool is_supported();
+    /**
+     * @param max_staged_bytes a file is not started while staged files which are not evicted exceed this, unless it
+     * is the file right after the one being read. one file ahead is always staged, so the reader never waits for an
+     * eviction which needs the next file
+     */
+    Stager(const std::vector<std::filesystem::path> &srcs, const std::filesystem::path &directory, int reader_count,
+           std::uintmax_t max_staged_bytes);
+    Stager(const Stager &) = delete;
+    Stager &operator=(const Stager &) = delete;
+    ~Stager();
+    std::size_t size() const;
+    std::filesystem::path path_of(std::size_t index) const;
+    std::uintmax_t size_of(std::size_t index) const;
+    bool is_staged(std::size_t index) const;
+    /**
+     * @brief remove the staged file so that later files can be staged
+     */
+    void evict(std::size_t index);
+    /**
+     * @brief tell which file the consumer reads. files up to the next one are staged regardless of max_staged_bytes
+     */
+    void set_reading(std::size_t index);
+    /**
+     * @retval std::nullopt no error occurred
+     */
+    std::optional<std::string> error() const;
+
+   private:
+    struct File;
+    std::vector<std::unique_ptr<File>> files_;
+    std::vector<std::thread> readers_;
+    mutable std::mutex mutex_;
+    std::condition_variable condition_;
+    std::size_t next_file_ = 0;
+    std::size_t reading_ = 0;  // file which the consumer reads
+    std::uintmax_t reserved_bytes_ = 0;
+    std::uintmax_t max_staged_bytes_;
+    bool is_stopped_ = false;
+    std::optional<std::string> error_;
+
+    void read_chunks_();
+};
+/**
+ * @brief offset of the file descriptor through which process pid has path open
+ * @retval std::nullopt path is not open, or /proc is not available
+ */
+std::optional<std::uintmax_t> open_file_position(std::int64_t pid, const std::filesystem::path &path);
+/**
+ * @brief stop process pid with SIGSTOP, or continue it with SIGCONT
+ */
+void pause_process(std::int64_t pid, bool is_paused);
+}  // namespace concat
+#endif
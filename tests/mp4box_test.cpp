@@ -0,0 +1,185 @@
+// appends synthetic fragmented MP4 files and feeds truncated boxes to the parser
+#include <ciso646>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <iterator>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "mp4box.hpp"
+
+namespace {
+namespace fs = std::filesystem;
+using Bytes = std::vector<std::uint8_t>;
+int failure_count = 0;
+
+void check(bool condition, const std::string &what) {
+    if (not condition) {
+        std::cerr << "FAILED: " << what << "\n";
+        failure_count++;
+    }
+}
+void check_throws(const std::function<void()> &function, const std::string &what) {
+    try {
+        function();
+    } catch (std::runtime_error &) {
+        return;
+    }
+    check(false, what + " throws std::runtime_error");
+}
+
+Bytes be32(std::uint32_t value) {
+    return {std::uint8_t(value >> 24), std::uint8_t(value >> 16), std::uint8_t(value >> 8), std::uint8_t(value)};
+}
+Bytes be64(std::uint64_t value) {
+    auto result = be32(value >> 32);
+    auto low = be32(value & 0xFFFFFFFF);
+    result.insert(result.end(), low.begin(), low.end());
+    return result;
+}
+Bytes concat(std::initializer_list<Bytes> parts) {
+    Bytes result;
+    for (const auto &part : parts) {
+        result.insert(result.end(), part.begin(), part.end());
+    }
+    return result;
+}
+Bytes box(const char *type, const Bytes &payload) {
+    return concat({be32(8 + payload.size()), Bytes(type, type + 4), payload});
+}
+Bytes zeros(std::size_t size) { return Bytes(size, 0); }
+
+struct Fragment {
+    std::uint64_t decode_time;
+    std::uint32_t sample_count;  // written in trun
+    std::vector<std::uint32_t> durations;
+};
+struct Options {
+    std::uint32_t timescale = 1000;
+    std::size_t tkhd_size = 84;  // 84 is the full size of version 0
+    std::vector<Fragment> fragments{{0, 3, {1000, 1000, 1000}}};
+};
+Bytes make_file(const Options &options) {
+    auto tkhd = box("tkhd", concat({be32(0), be32(0), be32(0), be32(1), zeros(68)}));
+    tkhd.resize(8 + options.tkhd_size);
+    tkhd[3] = static_cast<std::uint8_t>(tkhd.size());
+    auto mdhd = box("mdhd", concat({be32(0), be32(0), be32(0), be32(options.timescale), be32(0), be32(0)}));
+    auto stsd = box("stsd", concat({be32(0), be32(0)}));
+    auto trak = box("trak", concat({tkhd, box("mdia", concat({mdhd, box("minf", box("stbl", stsd))}))}));
+    auto trex = box("trex", concat({be32(0), be32(1), be32(1), be32(1000), be32(0), be32(0)}));
+    auto result = concat({box("ftyp", concat({Bytes{'i', 's', 'o', 'm'}, be32(0)})),
+                          box("moov", concat({trak, box("mvex", trex)}))});
+    std::uint32_t sequence_number = 1;
+    for (const auto &fragment : options.fragments) {
+        Bytes durations;
+        for (auto duration : fragment.durations) {
+            durations = concat({durations, be32(duration)});
+        }
+        auto tfhd = box("tfhd", concat({be32(0x020000), be32(1)}));  // default-base-is-moof
+        auto tfdt = box("tfdt", concat({be32(0x01000000), be64(fragment.decode_time)}));
+        auto trun = box("trun", concat({be32(0x000101), be32(fragment.sample_count), be32(0), durations}));
+        auto moof = box("moof", concat({box("mfhd", concat({be32(0), be32(sequence_number++)})),
+                                        box("traf", concat({tfhd, tfdt, trun}))}));
+        result = concat({result, moof, box("mdat", zeros(fragment.durations.size() * 16))});
+    }
+    return result;
+}
+void write_file(const fs::path &path, const Bytes &bytes) {
+    std::ofstream stream(path, std::ios::binary | std::ios::trunc);
+    stream.write(reinterpret_cast<const char *>(bytes.data()), bytes.size());
+}
+
+void test_append(const fs::path &directory) {
+    auto src = directory / "src.mp4";
+    auto archive = directory / "archive.mp4";
+    write_file(src, make_file({}));
+    concat::write_appendable_mp4(src, archive, {{0, "first"}});
+    check(concat::is_fragmented_mp4(archive), "archive is a fragmented MP4");
+    auto result = concat::append_fragments(archive, src, {{1, "second"}});
+    check(result.previous_duration == 3, "duration of the archive is the end of its last fragment");
+    check(result.fragment_count == 1, "one fragment is appended");
+    auto chapters = concat::read_appendable_chapters(archive);
+    check(chapters.size() == 2, "chapters of both files are in the archive");
+    check(chapters.size() == 2 && chapters[1].start == 4 && chapters[1].title == "second",
+          "appended chapters are shifted by the duration of the archive");
+    // the appended fragment continues at the end of the first one
+    auto appended = concat::append_fragments(archive, src, {});
+    check(appended.previous_duration == 6, "decode times of appended fragments are rebased");
+}
+void test_written_bytes(const fs::path &directory) {
+    auto src = directory / "src.mp4";
+    auto archive = directory / "written_archive.mp4";
+    write_file(src, make_file({}));
+    std::string written;
+    concat::write_appendable_mp4(src, archive, {{0, "first"}},
+                                 [&written](const char *data, std::size_t size) { written.append(data, size); });
+    std::ifstream stream(archive, std::ios::binary);
+    std::string contents((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+    check(written == contents, "bytes given to on_data are the archive");
+}
+void test_truncated_trun(const fs::path &directory) {
+    auto src = directory / "truncated_trun.mp4";
+    auto archive = directory / "truncated_trun_archive.mp4";
+    Options options;
+    options.fragments = {{0, 1'000'000, {1000, 1000, 1000}}};  // count far beyond the durations in the box
+    write_file(src, make_file(options));
+    concat::write_appendable_mp4(src, archive, {});
+    check_throws([&] { concat::append_fragments(archive, src, {}); }, "trun with more samples than the box holds");
+}
+void test_truncated_tkhd(const fs::path &directory) {
+    auto src = directory / "truncated_tkhd.mp4";
+    auto archive = directory / "truncated_tkhd_archive.mp4";
+    write_file(src, make_file({}));
+    concat::write_appendable_mp4(src, archive, {});
+    Options options;
+    options.tkhd_size = 8;  // ends before track_ID
+    write_file(src, make_file(options));
+    check_throws([&] { concat::append_fragments(archive, src, {}); }, "tkhd without track_ID");
+}
+void test_truncated_file(const fs::path &directory) {
+    auto src = directory / "src.mp4";
+    auto archive = directory / "cut_archive.mp4";
+    write_file(src, make_file({}));
+    concat::write_appendable_mp4(src, archive, {});
+    // an interrupted append leaves an incomplete box, which is dropped before appending
+    auto size = fs::file_size(archive);
+    auto bytes = make_file({});
+    std::ofstream(archive, std::ios::binary | std::ios::app).write(reinterpret_cast<const char *>(bytes.data()), 20);
+    auto result = concat::append_fragments(archive, src, {});
+    check(result.previous_duration == 3, "incomplete box at the end is ignored");
+    check(fs::file_size(archive) > size, "fragments are appended after the incomplete box is truncated");
+}
+void test_too_many_chapters(const fs::path &directory) {
+    auto src = directory / "src.mp4";
+    write_file(src, make_file({}));
+    std::vector<concat::Mp4Chapter> chapters(concat::MAX_MP4_CHAPTERS + 1, {0, "chapter"});
+    check_throws([&] { concat::write_appendable_mp4(src, directory / "chapters.mp4", chapters); },
+                 "more chapters than chpl can hold");
+}
+}  // namespace
+
+int main() {
+    auto directory = fs::temp_directory_path() / ("mp4box_test-" + std::to_string(std::random_device()()));
+    fs::create_directories(directory);
+    try {
+        test_append(directory);
+        test_written_bytes(directory);
+        test_truncated_trun(directory);
+        test_truncated_tkhd(directory);
+        test_truncated_file(directory);
+        test_too_many_chapters(directory);
+    } catch (std::exception &e) {
+        check(false, std::string("unexpected exception: ") + e.what());
+    }
+    fs::remove_all(directory);
+    if (failure_count > 0) {
+        std::cerr << failure_count << " checks failed\n";
+        return 1;
+    }
+    return 0;
+}
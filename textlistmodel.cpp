@@ -0,0 +1,155 @@
+#include "textlistmodel.hpp"
+
+#include <algorithm>
+#include <ciso646>
+#include <numeric>
+
+TextListModel::TextListModel(const QStringList &texts, QObject *parent)
+    : QAbstractListModel(parent), texts_(texts) {}
+
+int TextListModel::rowCount(const QModelIndex &parent) const { return parent.isValid() ? 0 : fetched_count_; }
+
+QVariant TextListModel::data(const QModelIndex &index, int role) const {
+    if (not index.isValid() || index.row() >= fetched_count_) {
+        return QVariant();
+    }
+    if (role == Qt::DisplayRole || role == Qt::EditRole) {
+        return texts_[index.row()];
+    }
+    if (role == Qt::DecorationRole && decorations_.contains(index.row())) {
+        return decorations_[index.row()];
+    }
+    return QVariant();
+}
+
+bool TextListModel::setData(const QModelIndex &index, const QVariant &value, int role) {
+    if (not index.isValid() || index.row() >= fetched_count_ || role != Qt::EditRole) {
+        return false;
+    }
+    texts_[index.row()] = value.toString();
+    emit dataChanged(index, index, {Qt::DisplayRole, Qt::EditRole});
+    return true;
+}
+
+Qt::ItemFlags TextListModel::flags(const QModelIndex &index) const {
+    if (not index.isValid()) {
+        return Qt::NoItemFlags;
+    }
+    return Qt::ItemIsEditable | Qt::ItemIsEnabled | Qt::ItemIsSelectable | Qt::ItemNeverHasChildren;
+}
+
+bool TextListModel::canFetchMore(const QModelIndex &parent) const {
+    return not parent.isValid() && fetched_count_ < texts_.size();
+}
+
+void TextListModel::fetchMore(const QModelIndex &parent) {
+    if (parent.isValid()) {
+        return;
+    }
+    int count = qMin(FETCH_BATCH_SIZE, static_cast<int>(texts_.size()) - fetched_count_);
+    if (count <= 0) {
+        return;
+    }
+    beginInsertRows(QModelIndex(), fetched_count_, fetched_count_ + count - 1);
+    fetched_count_ += count;
+    endInsertRows();
+}
+
+QStringList TextListModel::texts() const { return texts_; }
+
+int TextListModel::replace(const QRegularExpression &pattern, const QString &after, const QModelIndexList &rows) {
+    QVector<int> changed;
+    for (auto row : target_rows_(rows)) {
+        auto replaced = QString(texts_[row]).replace(pattern, after);
+        if (replaced != texts_[row]) {
+            texts_[row] = replaced;
+            changed << row;
+        }
+    }
+    notify_changed_(changed);
+    return changed.size();
+}
+
+void TextListModel::rename(const QString &pattern, const QModelIndexList &rows) {
+    auto targets = target_rows_(rows);
+    for (auto row : targets) {
+        auto renamed = pattern;
+        renamed.replace("{n}", QString::number(row + 1)).replace("{text}", texts_[row]);
+        texts_[row] = renamed;
+    }
+    notify_changed_(targets);
+}
+
+void TextListModel::set_decoration(int row, const QIcon &icon) {
+    if (row < 0 || row >= texts_.size()) {
+        return;
+    }
+    decorations_[row] = icon;
+    if (row < fetched_count_) {
+        emit dataChanged(index(row), index(row), {Qt::DecorationRole});
+    }
+}
+
+int TextListModel::append(const QString &text) {
+    while (canFetchMore(QModelIndex())) {
+        fetchMore(QModelIndex());
+    }
+    beginInsertRows(QModelIndex(), fetched_count_, fetched_count_);
+    texts_ << text;
+    fetched_count_++;
+    endInsertRows();
+    return fetched_count_ - 1;
+}
+
+void TextListModel::remove(const QModelIndexList &rows) {
+    if (rows.isEmpty()) {  // not all rows, unlike bulk operations
+        return;
+    }
+    auto targets = target_rows_(rows);
+    // from the last row, so that rows not removed yet keep their indices
+    for (auto i = static_cast<int>(targets.size()) - 1; i >= 0; i--) {
+        auto row = targets[i];
+        bool is_fetched = row < fetched_count_;
+        if (is_fetched) {
+            beginRemoveRows(QModelIndex(), row, row);
+        }
+        texts_.removeAt(row);
+        QHash<int, QIcon> decorations;
+        for (auto it = decorations_.cbegin(); it != decorations_.cend(); ++it) {
+            if (it.key() != row) {
+                decorations.insert(it.key() > row ? it.key() - 1 : it.key(), it.value());
+            }
+        }
+        decorations_ = decorations;
+        if (is_fetched) {
+            fetched_count_--;
+            endRemoveRows();
+        }
+    }
+}
+
+QVector<int> TextListModel::target_rows_(const QModelIndexList &rows) const {
+    QVector<int> result;
+    if (rows.isEmpty()) {
+        result.resize(texts_.size());
+        std::iota(result.begin(), result.end(), 0);
+        return result;
+    }
+    for (const auto &index : rows) {
+        if (index.isValid()) {
+            result << index.row();
+        }
+    }
+    std::sort(result.begin(), result.end());
+    result.erase(std::unique(result.begin(), result.end()), result.end());
+    return result;
+}
+
+void TextListModel::notify_changed_(const QVector<int> &rows) {
+    // only rows already exposed to views need to be notified. rows are sorted.
+    auto last_fetched = std::lower_bound(rows.begin(), rows.end(), fetched_count_);
+    if (rows.begin() == last_fetched) {
+        return;
+    }
+    emit dataChanged(index(rows.front()), index(*(last_fetched - 1)), {Qt::DisplayRole, Qt::EditRole});
+}
@@ -0,0 +1,67 @@
+#ifndef TEXTLISTMODEL_HPP
+#define TEXTLISTMODEL_HPP
+
+#include <QAbstractListModel>
+#include <QHash>
+#include <QIcon>
+#include <QModelIndexList>
+#include <QRegularExpression>
+#include <QStringList>
+
+/**
+ * @brief editable list of texts which exposes rows to views lazily (see canFetchMore()/fetchMore()).
+ * @note bulk operations work on all texts, including rows which are not fetched yet.
+ */
+class TextListModel : public QAbstractListModel {
+    Q_OBJECT
+
+   public:
+    explicit TextListModel(const QStringList &texts, QObject *parent = nullptr);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    bool setData(const QModelIndex &index, const QVariant &value, int role = Qt::EditRole) override;
+    Qt::ItemFlags flags(const QModelIndex &index) const override;
+    bool canFetchMore(const QModelIndex &parent) const override;
+    void fetchMore(const QModelIndex &parent) override;
+
+    QStringList texts() const;
+    /**
+     * @brief replace every match of pattern
+     *
+     * @param rows target rows. empty means all rows
+     * @return int number of changed texts
+     */
+    int replace(const QRegularExpression &pattern, const QString &after, const QModelIndexList &rows = {});
+    /**
+     * @brief rename texts with pattern. "{n}" is replaced with 1-based index in the whole list and "{text}" with
+     * current text.
+     *
+     * @param rows target rows. empty means all rows
+     */
+    void rename(const QString &pattern, const QModelIndexList &rows = {});
+    /**
+     * @brief icon shown beside the text of row. rows which are not fetched yet show it once fetched
+     */
+    void set_decoration(int row, const QIcon &icon);
+    /**
+     * @brief append a row. every row is fetched first, so that views show the new row at once
+     * @return row of the text
+     */
+    int append(const QString &text);
+    /**
+     * @brief remove rows. icons of following rows move with their texts
+     */
+    void remove(const QModelIndexList &rows);
+
+   private:
+    QStringList texts_;
+    QHash<int, QIcon> decorations_;
+    int fetched_count_ = 0;
+    static constexpr int FETCH_BATCH_SIZE = 256;
+
+    QVector<int> target_rows_(const QModelIndexList &rows) const;
+    void notify_changed_(const QVector<int> &rows);
+};
+
+#endif  // TEXTLISTMODEL_HPP
@@ -0,0 +1,122 @@
+#include "thumbnailprovider.hpp"
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <ciso646>
+#include <cmath>
+#include <filesystem>
+#include <system_error>
+
+ThumbnailProvider::ThumbnailProvider(const QString &directory, QObject *parent)
+    : QObject(parent), directory_(directory), pool_(new ProcessPool(QThread::idealThreadCount(), this)) {
+    QDir().mkpath(directory_);
+    evict_();
+}
+
+QString ThumbnailProvider::request(const QString &path, double time, const QObject *requester) {
+    auto cache_path = cache_path_(path, time);
+    if (QFileInfo::exists(cache_path)) {
+        std::error_code error;
+        std::filesystem::last_write_time(std::filesystem::path(cache_path.toStdU16String()),
+                                         std::filesystem::file_time_type::clock::now(), error);
+        return cache_path;
+    }
+    if (pending_.contains(cache_path)) {
+        pending_[cache_path].requesters << requester;
+        return QString();
+    }
+    if (failed_.contains(cache_path)) {
+        return QString();
+    }
+    // written beside the final name and renamed, so that a killed process never leaves a broken thumbnail
+    auto partial_path = cache_path + ".part";
+    auto job = pool_->enqueue("ffmpeg", arguments_(path, time, partial_path), [=](const ProcessPool::Result &result) {
+        this->pending_.remove(cache_path);
+        if (not result.is_success || not QFile::rename(partial_path, cache_path)) {
+            QFile::remove(partial_path);
+            this->failed_ << cache_path;
+            return;
+        }
+        this->cache_size_ += QFileInfo(cache_path).size();
+        if (this->cache_size_ > MAX_CACHE_SIZE) {
+            this->evict_();
+        }
+        emit this->ready(path, time, cache_path);
+    });
+    pending_.insert(cache_path, {job, {requester}});
+    return QString();
+}
+
+void ThumbnailProvider::cancel_pending(const QObject *requester) {
+    for (auto iter = pending_.begin(); iter != pending_.end();) {
+        iter->requesters.remove(requester);
+        if (not iter->requesters.isEmpty()) {
+            ++iter;
+            continue;
+        }
+        // callbacks of killed processes are not called. their partial files are overwritten if requested again
+        pool_->kill(iter->job);
+        iter = pending_.erase(iter);
+    }
+}
+
+void ThumbnailProvider::evict_() {
+    QDir dir(directory_);
+    for (const auto &entry : dir.entryInfoList({QStringLiteral("*.jpg.part")}, QDir::Files)) {
+        if (not pending_.contains(entry.filePath().chopped(5))) {
+            QFile::remove(entry.filePath());
+        }
+    }
+    auto entries = dir.entryInfoList({QStringLiteral("*.jpg")}, QDir::Files, QDir::Time | QDir::Reversed);
+    cache_size_ = 0;
+    for (const auto &entry : entries) {
+        cache_size_ += entry.size();
+    }
+    if (cache_size_ <= MAX_CACHE_SIZE) {
+        return;
+    }
+    // down to 3/4 of the limit, so that the directory is not listed again for each new thumbnail
+    for (const auto &entry : entries) {  // oldest first
+        if (cache_size_ <= MAX_CACHE_SIZE / 4 * 3) {
+            break;
+        }
+        if (QFile::remove(entry.filePath())) {
+            cache_size_ -= entry.size();
+        }
+    }
+}
+
+QString ThumbnailProvider::cache_path_(const QString &path, double time) const {
+    QFileInfo info(path);
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(info.absoluteFilePath().toUtf8());
+    hash.addData(QByteArray::number(info.size()));
+    hash.addData(QByteArray::number(info.lastModified().toMSecsSinceEpoch()));
+    // milliseconds are enough to tell apart chapters, and keep keys stable against rounding
+    auto milliseconds = static_cast<qint64>(std::llround(time * 1000));
+    return QDir(directory_).filePath(
+        QStringLiteral("%1_%2.jpg").arg(QString::fromLatin1(hash.result().toHex().left(24))).arg(milliseconds));
+}
+
+QStringList ThumbnailProvider::arguments_(const QString &path, double time, const QString &dst) {
+    QStringList result;
+    // -noaccurate_seek outputs the keyframe found by seeking, so no frame other than it is decoded
+    // clang-format off
+    result << "-hide_banner" << "-nostdin" << "-y"
+           << "-noaccurate_seek"
+           << "-skip_frame" << "nokey"
+           << "-ss" << QString::number(time, 'f', 3)
+           << "-i" << path
+           << "-map" << "0:v:0"
+           << "-frames:v" << "1"
+           << "-vf" << QStringLiteral("scale=%1:-2").arg(ThumbnailProvider::WIDTH)
+           << "-q:v" << "5"
+           << "-f" << "image2"
+           << "-update" << "1"
+           << dst;
+    // clang-format on
+    return result;
+}
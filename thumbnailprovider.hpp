@@ -0,0 +1,60 @@
+#ifndef THUMBNAILPROVIDER_HPP
+#define THUMBNAILPROVIDER_HPP
+
+#include <QHash>
+#include <QObject>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+
+#include "processpool.hpp"
+
+/**
+ * @brief thumbnails of keyframes, generated on a ProcessPool and kept in a persistent cache
+ * @details A thumbnail is the keyframe at or before a time, which ffmpeg decodes without decoding any other frame.
+ * Files in the cache are named after the identity of the source (path, size and modification time) and the time, so
+ * they are reused across runs until the source changes. Time of last use is kept as the modification time, and least
+ * recently used thumbnails are removed when the total size exceeds MAX_CACHE_SIZE.
+ */
+class ThumbnailProvider : public QObject {
+    Q_OBJECT
+
+   public:
+    static constexpr int WIDTH = 160;
+    static constexpr qint64 MAX_CACHE_SIZE = 64 * 1024 * 1024;  // bytes. thumbnails are about 10 KB each
+
+    explicit ThumbnailProvider(const QString &directory, QObject *parent = nullptr);
+    /**
+     * @brief path of the cached thumbnail. it is generated if it does not exist yet
+     *
+     * @param time seconds from the start of the file
+     * @param requester what cancel_pending() takes
+     * @retval "" not cached yet. ready() is emitted when it is generated
+     */
+    QString request(const QString &path, double time, const QObject *requester);
+    /**
+     * @brief drop requests of requester which are not finished, e.g. when the view which requested them is closed
+     * @details Thumbnails also requested by others are still generated.
+     */
+    void cancel_pending(const QObject *requester);
+
+   signals:
+    void ready(const QString &path, double time, const QString &thumbnail_path);
+
+   private:
+    QString directory_;
+    ProcessPool *pool_;        // deleted when this(ThumbnailProvider) is deleted
+    struct Pending {
+        ProcessPool::JobId job;
+        QSet<const QObject *> requesters;
+    };
+    QHash<QString, Pending> pending_;  // by cache paths being generated
+    QSet<QString> failed_;             // not retried until restart. e.g. time is beyond the end
+    qint64 cache_size_ = 0;            // as of the last evict_() and thumbnails generated since then
+
+    QString cache_path_(const QString &path, double time) const;
+    void evict_();  // removes least recently used thumbnails, and partial files which are not being written
+    static QStringList arguments_(const QString &path, double time, const QString &dst);
+};
+
+#endif  // THUMBNAILPROVIDER_HPP
@@ -0,0 +1,70 @@
+#include "tracer.hpp"
+
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QDir>
+#include <QJsonDocument>
+#include <QSaveFile>
+#include <algorithm>
+#include <ciso646>
+
+namespace concat {
+namespace {
+QJsonObject track_name(int track, const QString &name) {
+    return {{"name", "thread_name"}, {"ph", "M"}, {"pid", 1}, {"tid", track}, {"args", QJsonObject{{"name", name}}}};
+}
+}  // namespace
+Tracer::Tracer(const QString &name)
+    : name_(name),
+      origin_(Clock::now()),
+      started_at_(QDateTime::currentDateTime().toString("yyyyMMdd-hhmmss")) {
+    events_ << QJsonObject{{"name", "process_name"},
+                           {"ph", "M"},
+                           {"pid", 1},
+                           {"args", QJsonObject{{"name", QCoreApplication::applicationName()}}}};
+    events_ << track_name(STEPS, "steps") << track_name(COMMANDS, "commands");
+}
+void Tracer::step(const QString &name, const QJsonObject &args) {
+    auto now = Clock::now();
+    end_step_(now);
+    current_step_ = {name, args};
+    current_step_start_ = now;
+}
+void Tracer::span(const QString &name, const QString &category, Clock::time_point start, Clock::time_point end,
+                  int track, const QJsonObject &args) {
+    auto begin = microseconds_since_origin_(start);
+    // clang-format off
+    events_ << QJsonObject{{"name", name},
+                           {"cat", category},
+                           {"ph", "X"},
+                           {"ts", begin},
+                           {"dur", std::max(microseconds_since_origin_(end) - begin, qint64(0))},
+                           {"pid", 1},
+                           {"tid", track},
+                           {"args", args}};
+    // clang-format on
+}
+QString Tracer::write(const QString &directory) {
+    end_step_(Clock::now());
+    current_step_ = std::nullopt;
+    if (not QDir().mkpath(directory)) {
+        return QString();
+    }
+    auto path = QDir(directory).filePath(QStringLiteral("%1-%2.trace.json").arg(name_, started_at_));
+    QSaveFile file(path);
+    if (not file.open(QIODevice::WriteOnly)) {
+        return QString();
+    }
+    QJsonObject trace{{"traceEvents", events_}, {"displayTimeUnit", "ms"}};
+    file.write(QJsonDocument(trace).toJson(QJsonDocument::Compact));
+    return file.commit() ? path : QString();
+}
+qint64 Tracer::microseconds_since_origin_(Clock::time_point time) const {
+    return std::chrono::duration_cast<std::chrono::microseconds>(time - origin_).count();
+}
+void Tracer::end_step_(Clock::time_point now) {
+    if (current_step_.has_value()) {
+        span(current_step_->first, "step", current_step_start_, now, STEPS, current_step_->second);
+    }
+}
+}  // namespace concat
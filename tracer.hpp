@@ -0,0 +1,49 @@
+#ifndef VIDEO_CONCATENATER_TRACER
+#define VIDEO_CONCATENATER_TRACER
+
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QString>
+#include <chrono>
+#include <optional>
+
+namespace concat {
+/**
+ * @brief records spans of a run and writes them as Chrome trace-event JSON, which Perfetto and chrome://tracing load
+ * @details Each track is a "thread" of the trace. Steps are contiguous on one track: a step ends when the next one
+ * begins, so time spent in dialogs is attributed to the step which opened them.
+ */
+class Tracer {
+   public:
+    using Clock = std::chrono::steady_clock;
+    enum Track { STEPS = 1, COMMANDS = 2 };
+
+    explicit Tracer(const QString &name);
+    /**
+     * @brief end the current step and begin the next one
+     */
+    void step(const QString &name, const QJsonObject &args = {});
+    /**
+     * @brief add a span which has already ended
+     */
+    void span(const QString &name, const QString &category, Clock::time_point start, Clock::time_point end,
+              int track, const QJsonObject &args = {});
+    /**
+     * @brief end the current step and write all spans to "<name>-<time of construction>.trace.json" in directory
+     * @return path of the written file. empty if it could not be written
+     */
+    QString write(const QString &directory);
+
+   private:
+    QString name_;
+    Clock::time_point origin_;
+    QString started_at_;  // wall clock time of construction, used in the file name
+    QJsonArray events_;
+    std::optional<std::pair<QString, QJsonObject>> current_step_;
+    Clock::time_point current_step_start_;
+
+    qint64 microseconds_since_origin_(Clock::time_point time) const;
+    void end_step_(Clock::time_point now);
+};
+}  // namespace concat
+#endif
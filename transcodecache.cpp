@@ -0,0 +1,116 @@
+#include "transcodecache.hpp"
+
+#include <QCryptographicHash>
+#include <QFile>
+#include <QFileInfo>
+#include <algorithm>
+#include <ciso646>
+#include <filesystem>
+#include <stdexcept>
+#include <system_error>
+
+namespace concat {
+namespace {
+// long enough to cover headers and several GOPs, which differ between re-encodes of the same clip
+constexpr qint64 IDENTITY_SAMPLE_SIZE = 1 << 20;
+}  // namespace
+QStringList normalize_arguments(const QString &src, double duration, const VideoInfo &output_info,
+                                const QString &dst) {
+    QStringList result;
+    result << "-hide_banner" << "-y";
+    result += output_info.input_file_args;
+    // clang-format off
+    result << "-i" << src
+           << "-t" << QString::number(duration, 'f', 6)
+           << "-map" << "0:v:0" << "-map" << "0:a:0?"
+           << "-c:v" << std::get<QString>(output_info.video_codec)
+           << "-c:a" << std::get<QString>(output_info.audio_codec);
+    // clang-format on
+    if (std::holds_alternative<QSize>(output_info.resolution)) {
+        auto resolution = std::get<QSize>(output_info.resolution);
+        result << "-s" << QStringLiteral("%1x%2").arg(resolution.width()).arg(resolution.height());
+    }
+    result += output_info.encoding_args;
+    result << "-f" << "matroska" << dst;
+    return result;
+}
+QByteArray content_identity(const QString &path) {
+    QFile file(path);
+    if (not file.open(QIODevice::ReadOnly)) {
+        throw std::runtime_error(QStringLiteral("failed to open [%1]").arg(path).toStdString());
+    }
+    QCryptographicHash hash(QCryptographicHash::Sha256);
+    auto size = file.size();
+    hash.addData(QByteArray::number(size));
+    hash.addData(file.read(IDENTITY_SAMPLE_SIZE));
+    if (size > IDENTITY_SAMPLE_SIZE) {
+        file.seek(std::max(size - IDENTITY_SAMPLE_SIZE, IDENTITY_SAMPLE_SIZE));
+        hash.addData(file.read(IDENTITY_SAMPLE_SIZE));
+    }
+    if (file.error() != QFileDevice::NoError) {
+        throw std::runtime_error(QStringLiteral("failed to read [%1]").arg(path).toStdString());
+    }
+    return hash.result();
+}
+QString cache_key(const QByteArray &identity, const QStringList &arguments) {
+    QCryptographicHash hash(QCryptographicHash::Sha256);
+    hash.addData(identity);
+    for (const auto &argument : arguments) {
+        hash.addData(QByteArray(1, '\0'));
+        hash.addData(argument.toUtf8());
+    }
+    return QString::fromLatin1(hash.result().toHex());
+}
+TranscodeCache::TranscodeCache(const QString &directory, qint64 max_size) : dir_(directory), max_size_(max_size) {
+    dir_.mkpath(".");
+}
+bool TranscodeCache::is_valid() const { return dir_.exists(); }
+QString TranscodeCache::path_of(const QString &key) const { return dir_.filePath(key + SUFFIX); }
+QString TranscodeCache::partial_path_of(const QString &key) const { return dir_.filePath(key + PARTIAL_SUFFIX); }
+bool TranscodeCache::lookup(const QString &key) {
+    auto path = path_of(key);
+    if (not QFileInfo::exists(path)) {
+        return false;
+    }
+    std::error_code error;
+    auto std_path = std::filesystem::path(path.toStdU16String());
+    std::filesystem::last_write_time(std_path, std::filesystem::file_time_type::clock::now(), error);
+    return true;
+}
+bool TranscodeCache::commit(const QString &key) {
+    QFile::remove(path_of(key));
+    return QFile::rename(partial_path_of(key), path_of(key));
+}
+int TranscodeCache::evict(const QSet<QString> &keys_in_use) {
+    int removed = 0;
+    // partials are left by interrupted encodes, and are never committed afterwards
+    for (const auto &entry : dir_.entryInfoList({QStringLiteral("*") + PARTIAL_SUFFIX}, QDir::Files)) {
+        auto key = entry.fileName().chopped(static_cast<int>(qstrlen(PARTIAL_SUFFIX)));
+        if (not keys_in_use.contains(key) && QFile::remove(entry.filePath())) {
+            removed++;
+        }
+    }
+    auto entries = dir_.entryInfoList({QStringLiteral("*") + SUFFIX}, QDir::Files, QDir::Time | QDir::Reversed);
+    entries.erase(std::remove_if(entries.begin(), entries.end(),
+                                 [](const auto &entry) { return entry.fileName().endsWith(PARTIAL_SUFFIX); }),
+                  entries.end());
+    qint64 total_size = 0;
+    for (const auto &entry : entries) {
+        total_size += entry.size();
+    }
+    for (const auto &entry : entries) {  // oldest first
+        if (total_size <= max_size_) {
+            break;
+        }
+        auto key = entry.fileName().chopped(static_cast<int>(qstrlen(SUFFIX)));
+        if (keys_in_use.contains(key)) {
+            continue;
+        }
+        if (QFile::remove(entry.filePath())) {
+            total_size -= entry.size();
+            removed++;
+        }
+    }
+    return removed;
+}
+}  // namespace concat
@@ -0,0 +1,69 @@
+#ifndef VIDEO_CONCATENATER_TRANSCODECACHE
+#define VIDEO_CONCATENATER_TRANSCODECACHE
+
+#include <QByteArray>
+#include <QDir>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+
+#include "videoinfo.hpp"
+
+namespace concat {
+/**
+ * @brief arguments of ffmpeg which encode [start of file, duration) of src into an intermediate matching output_info
+ * @details Intermediates of the same output_info can be joined by stream copy.
+ */
+QStringList normalize_arguments(const QString &src, double duration, const VideoInfo &output_info,
+                                const QString &dst);
+/**
+ * @brief identity of the content of a file: its size and a hash of its head and tail
+ * @details Hashing whole inputs would take as long as decoding them. The path is not included, so moved or renamed
+ * inputs are still found.
+ * @throw std::runtime_error if the file cannot be read
+ */
+QByteArray content_identity(const QString &path);
+/**
+ * @param arguments normalize_arguments() without paths
+ */
+QString cache_key(const QByteArray &identity, const QStringList &arguments);
+/**
+ * @brief directory of transcoded intermediates named by cache_key()
+ * @details Time of last use is kept as the modification time, and least recently used intermediates are removed
+ * when the total size exceeds the limit.
+ */
+class TranscodeCache {
+   public:
+    /**
+     * @param max_size bytes
+     */
+    TranscodeCache(const QString &directory, qint64 max_size);
+    bool is_valid() const;
+    QString path_of(const QString &key) const;
+    /**
+     * @brief where ffmpeg writes an intermediate. commit() makes it visible
+     */
+    QString partial_path_of(const QString &key) const;
+    /**
+     * @brief true if the intermediate of key exists. the time of use is updated then
+     */
+    bool lookup(const QString &key);
+    bool commit(const QString &key);
+    /**
+     * @brief remove least recently used intermediates until the total size fits the limit
+     *
+     * Partial files left by interrupted encodes are removed regardless of the limit.
+     *
+     * @param keys_in_use intermediates which are not removed even if the limit is exceeded
+     * @return number of removed intermediates
+     */
+    int evict(const QSet<QString> &keys_in_use);
+
+   private:
+    QDir dir_;
+    qint64 max_size_;
+    static constexpr auto SUFFIX = ".mkv";
+    static constexpr auto PARTIAL_SUFFIX = ".partial.mkv";
+};
+}  // namespace concat
+#endif
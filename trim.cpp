@@ -0,0 +1,165 @@
+#include "trim.hpp"
+
+#include <QHash>
+#include <QRegularExpression>
+#include <algorithm>
+#include <ciso646>
+
+namespace concat {
+namespace {
+// keyframes this close to a cut point are treated as the cut point itself
+constexpr double TOLERANCE = 0.001;
+// range searched for keyframes around cut points. longer GOPs are re-encoded completely
+constexpr double KEYFRAME_SEARCH_WINDOW = 60;
+QString format_seconds(double seconds) { return QString::number(seconds, 'f', 6); }
+/**
+ * @brief options which make the encoder write the profile and level of the source
+ * @details ffprobe reports profiles by display name ("Constrained Baseline", "High 10", ...), while encoders take
+ * their own names. levels are reported as level_idc, which is 10 or 30 times the level.
+ */
+QStringList profile_arguments(const StreamParams &video) {
+    auto profile = video.profile.toLower();
+    QStringList result;
+    if (video.codec_name == "h264") {
+        static const QHash<QString, QString> PROFILES{{"constrained baseline", "baseline"},
+                                                      {"baseline", "baseline"},
+                                                      {"main", "main"},
+                                                      {"high", "high"},
+                                                      {"high 10", "high10"},
+                                                      {"high 4:2:2", "high422"},
+                                                      {"high 4:4:4 predictive", "high444"}};
+        if (PROFILES.contains(profile)) {
+            result << "-profile:v" << PROFILES[profile];
+        }
+        if (video.level > 0) {
+            result << "-level:v" << QString::number(video.level / 10.0, 'f', 1);
+        }
+    } else if (video.codec_name == "hevc") {
+        static const QHash<QString, QString> PROFILES{{"main", "main"}, {"main 10", "main10"}, {"rext", "main444-8"}};
+        if (PROFILES.contains(profile)) {
+            result << "-profile:v" << PROFILES[profile];
+        }
+        if (video.level > 0) {
+            result << "-x265-params" << QStringLiteral("level-idc=%1").arg(video.level / 30.0, 0, 'f', 1);
+        }
+    }
+    return result;
+}
+}  // namespace
+std::optional<double> parse_time(const QString &text) {
+    QRegularExpression pattern(R"(^\s*(?:(?:(\d+):)?(\d+):)?(\d+(?:\.\d*)?)\s*$)");
+    auto match = pattern.match(text);
+    if (not match.hasMatch()) {
+        return std::nullopt;
+    }
+    auto hours = match.captured(1).toDouble();
+    auto minutes = match.captured(2).toDouble();
+    auto seconds = match.captured(3).toDouble();
+    return hours * 3600 + minutes * 60 + seconds;
+}
+QString format_time(double seconds) {
+    auto milliseconds = static_cast<qint64>(seconds * 1000 + 0.5);
+    return QStringLiteral("%1:%2:%3.%4")
+        .arg(milliseconds / 3'600'000, 2, 10, QLatin1Char('0'))
+        .arg(milliseconds / 60'000 % 60, 2, 10, QLatin1Char('0'))
+        .arg(milliseconds / 1000 % 60, 2, 10, QLatin1Char('0'))
+        .arg(milliseconds % 1000, 3, 10, QLatin1Char('0'));
+}
+QStringList keyframe_probe_arguments(const QString &path, double in_point, double out_point) {
+    // reading starts at the keyframe before each interval, so only two short ranges are demuxed
+    auto intervals = QStringLiteral("%1%+%2,%3%%4")
+                         .arg(format_seconds(in_point), format_seconds(KEYFRAME_SEARCH_WINDOW),
+                              format_seconds(std::max(in_point, out_point - KEYFRAME_SEARCH_WINDOW)),
+                              format_seconds(out_point));
+    QStringList result;
+    // clang-format off
+    result << "-v" << "error"
+           << "-select_streams" << "v:0"
+           << "-show_entries" << "packet=pts_time,flags"
+           << "-of" << "csv=p=0"
+           << "-read_intervals" << intervals
+           << path;
+    // clang-format on
+    return result;
+}
+QVector<double> parse_keyframes(const QByteArray &csv) {
+    QVector<double> result;
+    for (const auto &line : csv.split('\n')) {
+        auto fields = line.trimmed().split(',');
+        if (fields.size() < 2 || not fields[1].contains('K')) {
+            continue;
+        }
+        bool ok;
+        auto pts_time = fields[0].toDouble(&ok);
+        if (ok) {
+            result << pts_time;
+        }
+    }
+    std::sort(result.begin(), result.end());
+    result.erase(std::unique(result.begin(), result.end()), result.end());
+    return result;
+}
+bool TrimCut::has_head() const { return in_keyframe - in_point > TOLERANCE; }
+bool TrimCut::has_middle() const { return out_keyframe - in_keyframe > TOLERANCE; }
+bool TrimCut::has_tail() const { return out_point - out_keyframe > TOLERANCE; }
+TrimCut find_cut(const QVector<double> &keyframes, std::optional<double> in_point, std::optional<double> out_point,
+                 double start, double end) {
+    TrimCut result{in_point.value_or(start), out_point.value_or(end), start, end};
+    if (in_point.has_value()) {
+        auto first = std::lower_bound(keyframes.begin(), keyframes.end(), result.in_point - TOLERANCE);
+        if (first == keyframes.end() || *first >= result.out_point - TOLERANCE) {
+            // no keyframe in range: whole range is re-encoded
+            result.in_keyframe = result.out_keyframe = result.out_point;
+            return result;
+        }
+        result.in_keyframe = std::max(*first, result.in_point);
+    }
+    if (out_point.has_value()) {
+        auto last = std::upper_bound(keyframes.begin(), keyframes.end(), result.out_point + TOLERANCE);
+        // there is at least one keyframe in range if in_keyframe is found. otherwise file start is a keyframe
+        result.out_keyframe = last == keyframes.begin() ? result.in_keyframe : std::min(*(last - 1), result.out_point);
+        result.out_keyframe = std::max(result.out_keyframe, result.in_keyframe);
+    }
+    return result;
+}
+QStringList render_arguments(const QString &src, double from, double to, const StreamParams &video,
+                             const StreamParams &audio, const QString &dst) {
+    QStringList result;
+    // -ss before -i is frame accurate when decoding. from and to are timestamps of the file, which include its
+    // start_time (e.g. MPEG-TS), so -seek_timestamp keeps them from being offset by it again
+    // clang-format off
+    result << "-y"
+           << "-seek_timestamp" << "1"
+           << "-ss" << format_seconds(from)
+           << "-i" << src
+           << "-t" << format_seconds(to - from)
+           << "-map" << "0:v:0" << "-map" << "0:a:0"
+           << "-c:v" << video.codec_name;
+    // clang-format on
+    if (not video.pix_fmt.isEmpty()) {
+        result << "-pix_fmt" << video.pix_fmt;
+    }
+    // the parts are joined with the copied middle, so they are encoded as close to the source as possible
+    result << profile_arguments(video);
+    if (video.bit_rate > 0) {
+        auto bit_rate = QString::number(video.bit_rate);
+        result << "-b:v" << bit_rate << "-maxrate" << bit_rate << "-bufsize" << QString::number(video.bit_rate * 2);
+    }
+    result << "-c:a" << audio.codec_name;
+    if (audio.bit_rate > 0) {
+        result << "-b:a" << QString::number(audio.bit_rate);
+    }
+    if (audio.sample_rate > 0) {
+        result << "-ar" << QString::number(audio.sample_rate);
+    }
+    if (audio.channels > 0) {
+        result << "-ac" << QString::number(audio.channels);
+    }
+    auto annexb_filter = annexb_filter_of(video.codec_name);
+    if (not annexb_filter.isEmpty()) {
+        result << "-bsf:v" << annexb_filter;
+    }
+    result << "-f" << "mpegts" << dst;
+    return result;
+}
+}  // namespace concat
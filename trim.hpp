@@ -0,0 +1,57 @@
+#ifndef VIDEO_CONCATENATER_TRIM
+#define VIDEO_CONCATENATER_TRIM
+
+#include <QByteArray>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <optional>
+
+#include "copysafety.hpp"
+
+namespace concat {
+/**
+ * @brief parse "hh:mm:ss.zzz", "mm:ss.zzz" or seconds
+ * @retval std::nullopt text is not a time
+ */
+std::optional<double> parse_time(const QString &text);
+QString format_time(double seconds);
+/**
+ * @brief arguments of ffprobe which list video packets around in point and out point
+ */
+QStringList keyframe_probe_arguments(const QString &path, double in_point, double out_point);
+/**
+ * @brief timestamps (seconds) of keyframes in csv output of keyframe_probe_arguments()
+ */
+QVector<double> parse_keyframes(const QByteArray &csv);
+/**
+ * @brief where an input is split into a re-encoded head, a stream-copied middle and a re-encoded tail
+ *
+ * [in_point, in_keyframe) and [out_keyframe, out_point) are re-encoded. [in_keyframe, out_keyframe) is copied.
+ * if no keyframe is found between in point and out point, whole range is the head.
+ * all values are timestamps of the file in seconds.
+ */
+struct TrimCut {
+    double in_point;
+    double out_point;
+    double in_keyframe;
+    double out_keyframe;
+
+    bool has_head() const;
+    bool has_middle() const;
+    bool has_tail() const;
+};
+/**
+ * @param in_point std::nullopt if the input is not trimmed at the start. start is used then
+ * @param out_point std::nullopt if the input is not trimmed at the end. end is used then
+ */
+TrimCut find_cut(const QVector<double> &keyframes, std::optional<double> in_point, std::optional<double> out_point,
+                 double start, double end);
+/**
+ * @brief arguments of ffmpeg which re-encode [from, to) of src with the same codec parameters as the source
+ * @details profile, level and bitrate of the source are kept where the encoder accepts them
+ */
+QStringList render_arguments(const QString &src, double from, double to, const StreamParams &video,
+                             const StreamParams &audio, const QString &dst);
+}  // namespace concat
+#endif
@@ -0,0 +1,139 @@
+#include "tsjoin.hpp"
+
+#include <algorithm>
+#include <array>
+#include <ciso646>
+#include <fstream>
+#include <map>
+#include <stdexcept>
+
+#ifdef __linux__
+#    include <fcntl.h>
+#    include <linux/fs.h>
+#    include <sys/ioctl.h>
+#    include <unistd.h>
+
+#    include "fileio.hpp"
+#endif
+
+namespace concat {
+namespace fs = std::filesystem;
+namespace {
+constexpr std::size_t PACKET_SIZE = 188;
+constexpr std::uint8_t SYNC_BYTE = 0x47;
+constexpr int NULL_PID = 0x1FFF;
+// every PID of a recording appears in its first second, which is far less than this
+constexpr std::size_t SCAN_SIZE = PACKET_SIZE * 8192;
+using Packet = std::array<std::uint8_t, PACKET_SIZE>;
+
+/**
+ * @brief continuity counter of the first packet carrying payload, for each PID
+ */
+std::map<int, int> first_continuity_counters(const fs::path &path) {
+    std::ifstream stream(path, std::ios::binary);
+    if (not stream) {
+        throw fs::filesystem_error("open", path, std::make_error_code(std::errc::no_such_file_or_directory));
+    }
+    std::map<int, int> result;
+    Packet packet;
+    for (std::size_t offset = 0; offset < SCAN_SIZE; offset += PACKET_SIZE) {
+        if (not stream.read(reinterpret_cast<char *>(packet.data()), packet.size())) {
+            break;
+        }
+        if (packet[0] != SYNC_BYTE) {
+            throw std::runtime_error("lost sync of transport stream in " + path.string());
+        }
+        int pid = ((packet[1] & 0x1F) << 8) | packet[2];
+        bool has_payload = packet[3] & 0x10;
+        if (pid != NULL_PID && has_payload) {
+            result.emplace(pid, packet[3] & 0x0F);
+        }
+    }
+    return result;
+}
+/**
+ * @brief adaptation-field-only packet which allows a jump of continuity counter and PCR
+ * @details Continuity counter does not increase on packets without payload, so it is set just before the next one.
+ */
+Packet discontinuity_packet(int pid, int next_continuity_counter) {
+    Packet result;
+    result.fill(0xFF);  // stuffing bytes
+    result[0] = SYNC_BYTE;
+    result[1] = (pid >> 8) & 0x1F;
+    result[2] = pid & 0xFF;
+    result[3] = 0x20 | ((next_continuity_counter + 15) & 0x0F);  // adaptation field only
+    result[4] = PACKET_SIZE - 5;                                 // adaptation_field_length
+    result[5] = 0x80;                                            // discontinuity_indicator
+    return result;
+}
+}  // namespace
+bool is_byte_joinable_transport_stream(const fs::path &path) {
+    std::error_code error;
+    auto size = fs::file_size(path, error);
+    if (error || size == 0 || size % PACKET_SIZE != 0) {
+        return false;
+    }
+    std::ifstream stream(path, std::ios::binary);
+    Packet packet;
+    for (int i = 0; i < 16 && stream.read(reinterpret_cast<char *>(packet.data()), packet.size()); i++) {
+        if (packet[0] != SYNC_BYTE) {
+            return false;
+        }
+    }
+    return static_cast<bool>(stream) || stream.eof();
+}
+TsJoinResult join_transport_streams(const std::vector<fs::path> &srcs, const fs::path &dst) {
+    TsJoinResult result{0, false, 0};
+#ifdef __linux__
+    FileDescriptor dst_fd(::open(dst.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644));
+    if (dst_fd.get() < 0) {
+        throw_errno("open", dst);
+    }
+    for (std::size_t i = 0; i < srcs.size(); i++) {
+        const auto &src = srcs[i];
+        if (i != 0) {
+            for (auto [pid, continuity_counter] : first_continuity_counters(src)) {
+                auto packet = discontinuity_packet(pid, continuity_counter);
+                write_all(dst_fd.get(), packet.data(), packet.size(), dst);
+                result.discontinuity_packets++;
+            }
+        }
+        FileDescriptor src_fd(::open(src.c_str(), O_RDONLY | O_CLOEXEC));
+        if (src_fd.get() < 0) {
+            throw_errno("open", src);
+        }
+        // the first input is shared with dst on btrfs, XFS, ... later ones are not block-aligned in dst
+        if (i == 0 && ::ioctl(dst_fd.get(), FICLONE, src_fd.get()) == 0) {
+            result.is_first_file_reflinked = true;
+            if (::lseek(dst_fd.get(), 0, SEEK_END) < 0) {
+                throw_errno("lseek", dst);
+            }
+        } else {
+            append_contents(src_fd.get(), dst_fd.get(), src);
+        }
+    }
+    if (::fsync(dst_fd.get()) != 0) {
+        throw_errno("fsync", dst);
+    }
+#else
+    std::ofstream dst_stream(dst, std::ios::binary | std::ios::trunc);
+    for (std::size_t i = 0; i < srcs.size(); i++) {
+        const auto &src = srcs[i];
+        if (i != 0) {
+            for (auto [pid, continuity_counter] : first_continuity_counters(src)) {
+                auto packet = discontinuity_packet(pid, continuity_counter);
+                dst_stream.write(reinterpret_cast<const char *>(packet.data()), packet.size());
+                result.discontinuity_packets++;
+            }
+        }
+        std::ifstream src_stream(src, std::ios::binary);
+        dst_stream << src_stream.rdbuf();
+    }
+    if (not dst_stream.flush()) {
+        throw fs::filesystem_error("write", dst, std::make_error_code(std::errc::io_error));
+    }
+#endif
+    result.size = fs::file_size(dst);
+    return result;
+}
+}  // namespace concat
@@ -0,0 +1,29 @@
+#ifndef VIDEO_CONCATENATER_TSJOIN
+#define VIDEO_CONCATENATER_TSJOIN
+
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+
+namespace concat {
+struct TsJoinResult {
+    std::uintmax_t size;           // bytes written
+    bool is_first_file_reflinked;  // first input was shared with FICLONE instead of copied
+    int discontinuity_packets;     // adaptation-field-only packets inserted at joins
+};
+/**
+ * @brief whether the file consists of 188-byte transport stream packets from the start to the end
+ * @details only the beginning of the file is checked for sync bytes.
+ */
+bool is_byte_joinable_transport_stream(const std::filesystem::path &path);
+/**
+ * @brief join MPEG-TS files at the byte level
+ * @details Inputs must share PIDs and codec parameters. Packets of the inputs are copied unchanged (copy_file_range()
+ * or FICLONE on Linux). Before every input except the first, one adaptation-field-only packet with
+ * discontinuity_indicator is inserted per PID so that continuity counters and PCR may restart legally.
+ * @throw std::filesystem::filesystem_error
+ * @throw std::runtime_error an input is not a transport stream
+ */
+TsJoinResult join_transport_streams(const std::vector<std::filesystem::path> &srcs, const std::filesystem::path &dst);
+}  // namespace concat
+#endif
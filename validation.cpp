@@ -0,0 +1,133 @@
+#include "validation.hpp"
+
+#include <QJsonArray>
+#include <algorithm>
+#include <ciso646>
+#include <cmath>
+
+namespace concat {
+namespace {
+// joins may add or drop up to a few frames per input. larger differences mean a truncated result
+constexpr double DURATION_TOLERANCE = 1.0;      // seconds
+constexpr double DURATION_TOLERANCE_RATIO = 0.001;
+// packets overlapping a join, and those at the edges of trimmed ranges, may be dropped or kept
+constexpr qint64 PACKET_TOLERANCE_PER_JOIN = 2;
+// chapter times are rounded to the timescale of the container
+constexpr double CHAPTER_TOLERANCE = 0.05;  // seconds
+double to_double(const QJsonValue &value, double default_value) {
+    bool ok;
+    auto result = value.toString().toDouble(&ok);
+    return ok ? result : default_value;
+}
+bool is_close(double actual, double expected) {
+    return std::abs(actual - expected) <= std::max(DURATION_TOLERANCE, expected * DURATION_TOLERANCE_RATIO);
+}
+}  // namespace
+QStringList validation_probe_arguments(const QString &path) {
+    QStringList result;
+    // clang-format off
+    result << "-v" << "error"
+           << "-of" << "json"
+           << "-show_entries" << "format=duration:stream=index,codec_type,duration,nb_frames"
+           << "-show_chapters"
+           << path;
+    // clang-format on
+    return result;
+}
+QString ValidationResult::report() const {
+    QStringList lines;
+    for (const auto &error : errors) {
+        lines << QStringLiteral("error: %1").arg(error);
+    }
+    lines += details;
+    return lines.join("\n");
+}
+ValidationResult validate_output(const QJsonObject &probe, const ExpectedOutput &expected) {
+    ValidationResult result;
+    auto duration = to_double(probe["format"].toObject()["duration"], -1);
+    result.details << QStringLiteral("duration: %1 s (expected %2 s)").arg(duration).arg(expected.duration);
+    if (duration < 0) {
+        result.errors << QStringLiteral("duration of the result is unknown");
+    } else if (not is_close(duration, expected.duration)) {
+        result.errors << QStringLiteral("duration differs from inputs by %1 s").arg(duration - expected.duration);
+    }
+
+    int video_count = 0;
+    int audio_count = 0;
+    auto packet_tolerance = PACKET_TOLERANCE_PER_JOIN * (expected.join_count + 1);  // inputs count as trims too
+    for (const auto &value : probe["streams"].toArray()) {
+        auto stream = value.toObject();
+        auto index = stream["index"].toInt();
+        auto type = stream["codec_type"].toString();
+        video_count += type == "video" ? 1 : 0;
+        audio_count += type == "audio" ? 1 : 0;
+        auto packets = stream.contains("nb_frames") ? stream["nb_frames"].toString() : QStringLiteral("unknown");
+        auto stream_duration = to_double(stream["duration"], -1);
+        result.details << QStringLiteral("stream #%1 (%2): %3 packets, %4 s")
+                              .arg(index)
+                              .arg(type, packets)
+                              .arg(stream_duration);
+        auto expected_packets = type == "video"   ? expected.video_packets
+                                : type == "audio" ? expected.audio_packets
+                                                  : std::nullopt;
+        bool is_counted;
+        auto packet_count = packets.toLongLong(&is_counted);
+        if (packets == "0") {
+            result.errors << QStringLiteral("stream #%1 (%2) has no packets").arg(index).arg(type);
+        } else if (is_counted && expected_packets.has_value()) {
+            result.details << QStringLiteral("stream #%1 (%2): %3 packets expected from inputs")
+                                  .arg(index)
+                                  .arg(type)
+                                  .arg(expected_packets.value());
+            // a dropped GOP or a duplicated input is within the expected duration but not within this
+            if (std::abs(packet_count - expected_packets.value()) > packet_tolerance) {
+                result.errors << QStringLiteral("stream #%1 (%2) has %3 packets instead of %4")
+                                     .arg(index)
+                                     .arg(type)
+                                     .arg(packet_count)
+                                     .arg(expected_packets.value());
+            }
+        }
+        // a stream which ends early is truncated even if the container reports the expected duration
+        if (stream_duration >= 0 && (type == "video" || type == "audio") &&
+            not is_close(stream_duration, expected.duration)) {
+            result.errors << QStringLiteral("stream #%1 (%2) lasts %3 s").arg(index).arg(type).arg(stream_duration);
+        }
+    }
+    if (video_count == 0) {
+        result.errors << QStringLiteral("no video stream");
+    }
+    if (expected.has_audio && audio_count == 0) {
+        result.errors << QStringLiteral("no audio stream");
+    }
+
+    if (expected.chapters.has_value()) {
+        auto chapters = probe["chapters"].toArray();
+        const auto &expected_chapters = expected.chapters.value();
+        result.details << QStringLiteral("chapters: %1 (expected %2)")
+                              .arg(chapters.size())
+                              .arg(expected_chapters.size());
+        if (chapters.size() != expected_chapters.size()) {
+            result.errors << QStringLiteral("%1 chapters are written instead of %2")
+                                 .arg(chapters.size())
+                                 .arg(expected_chapters.size());
+        } else {
+            for (auto i = 0; i < chapters.size(); i++) {
+                auto chapter = chapters[i].toObject();
+                auto start = to_double(chapter["start_time"], -1);
+                auto end = to_double(chapter["end_time"], -1);
+                if (std::abs(start - expected_chapters[i].start) > CHAPTER_TOLERANCE ||
+                    std::abs(end - expected_chapters[i].end) > CHAPTER_TOLERANCE) {
+                    result.errors << QStringLiteral("chapter #%1 is [%2, %3) instead of [%4, %5)")
+                                         .arg(i + 1)
+                                         .arg(start)
+                                         .arg(end)
+                                         .arg(expected_chapters[i].start)
+                                         .arg(expected_chapters[i].end);
+                }
+            }
+        }
+    }
+    return result;
+}
+}  // namespace concat
@@ -0,0 +1,45 @@
+#ifndef VIDEO_CONCATENATER_VALIDATION
+#define VIDEO_CONCATENATER_VALIDATION
+
+#include <QJsonObject>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <optional>
+
+namespace concat {
+struct ExpectedChapter {
+    double start;  // seconds
+    double end;
+};
+/**
+ * @brief what the result should contain, derived from inputs
+ */
+struct ExpectedOutput {
+    double duration;  // seconds. sum of durations of inputs on the output timeline
+    bool has_audio;
+    std::optional<QVector<ExpectedChapter>> chapters;  // std::nullopt if chapters are not written by ffmpeg
+    // packets of copied streams, from nb_frames of inputs scaled to the kept range. std::nullopt if not checked
+    std::optional<qint64> video_packets = std::nullopt;
+    std::optional<qint64> audio_packets = std::nullopt;
+    int join_count = 0;  // a few packets may be dropped or duplicated at each join
+};
+/**
+ * @brief arguments of ffprobe which read only the header (and index) of the result
+ * @details Streams are neither decoded nor demuxed, so validation takes the same time regardless of the size.
+ * nb_frames comes from the index (e.g. stsz of MP4) and is missing for containers without one.
+ */
+QStringList validation_probe_arguments(const QString &path);
+struct ValidationResult {
+    QStringList errors;  // the result is likely broken
+    QStringList details;
+
+    bool is_valid() const { return errors.isEmpty(); }
+    QString report() const;
+};
+/**
+ * @param probe output of ffprobe with validation_probe_arguments()
+ */
+ValidationResult validate_output(const QJsonObject &probe, const ExpectedOutput &expected);
+}  // namespace concat
+#endif
@@ -29,8 +29,18 @@ template <class T>
 using RangedVariant = std::variant<SameAsHighest<T>, SameAsLowest<T>, T, ValueRange<T>>;
 template <class T>
 using SelectableVariant = std::variant<SameAsInput<T>, T, QSet<T>>;
+/**
+ * @brief an additional output encoded from the same decoded frames as the main output
+ */
+struct Rendition {
+    QString name;                    // "<base name of result>_<name>.<suffix of result>" is written
+    QSize resolution;                // same as the main output if not valid
+    QString video_codec;             // copied if empty
+    QString audio_codec;             // copied if empty
+    QVector<QString> encoding_args;  // not inherited from the main output
+};
 struct VideoInfo {
-    static constexpr int VERSION = 1;
+    static constexpr int VERSION = 4;
     RangedVariant<QSize> resolution;
     RangedVariant<double> framerate;
     bool is_vfr;
@@ -38,6 +48,11 @@ struct VideoInfo {
     SelectableVariant<QString> video_codec;
     QVector<QString> encoding_args;
     QVector<QString> input_file_args;
+    qint64 max_part_size = 0;      // bytes. output is split into parts if positive
+    double max_part_duration = 0;  // seconds. output is split into parts if positive
+    QVector<Rendition> renditions;  // written in the same pass as the main output. ignored if output is split
+    double loudness_target = 0;     // LUFS. audio is not normalized if 0. audio is encoded if it is normalized
+    bool normalizes_each_input = true;  // false: one gain for whole output keeps the balance between inputs
 
     static VideoInfo create_input_info() {
         return {ValueRange<QSize>{}, ValueRange<double>{}, true, QSet<QString>{}, QSet<QString>{}};
@@ -53,6 +68,7 @@ Q_DECLARE_METATYPE(concat::ValueRange<double>);
 Q_DECLARE_METATYPE(concat::RangedVariant<QSize>);
 Q_DECLARE_METATYPE(concat::RangedVariant<double>);
 Q_DECLARE_METATYPE(concat::SelectableVariant<QString>);
+Q_DECLARE_METATYPE(concat::Rendition);
 Q_DECLARE_METATYPE(concat::VideoInfo);
 
 #endif
\ No newline at end of file
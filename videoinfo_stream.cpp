@@ -4,6 +4,22 @@
 
 namespace concat {
 inline namespace operators {
+QDataStream& operator<<(QDataStream& stream, const Rendition& rendition) {
+    stream << rendition.name;
+    stream << rendition.resolution;
+    stream << rendition.video_codec;
+    stream << rendition.audio_codec;
+    stream << rendition.encoding_args;
+    return stream;
+}
+QDataStream& operator>>(QDataStream& stream, Rendition& rendition) {
+    stream >> rendition.name;
+    stream >> rendition.resolution;
+    stream >> rendition.video_codec;
+    stream >> rendition.audio_codec;
+    stream >> rendition.encoding_args;
+    return stream;
+}
 QDataStream& operator<<(QDataStream& stream, const VideoInfo& info) {
     stream << VideoInfo::VERSION;
     stream << info.resolution;
@@ -13,6 +29,11 @@ QDataStream& operator<<(QDataStream& stream, const VideoInfo& info) {
     stream << info.video_codec;
     stream << info.encoding_args;
     stream << info.input_file_args;
+    stream << info.max_part_size;
+    stream << info.max_part_duration;
+    stream << info.renditions;
+    stream << info.loudness_target;
+    stream << info.normalizes_each_input;
     return stream;
 }
 QDataStream& operator>>(QDataStream& stream, VideoInfo& info) {
@@ -27,6 +48,17 @@ QDataStream& operator>>(QDataStream& stream, VideoInfo& info) {
     if (version >= 1) {
         stream >> info.input_file_args;
     }
+    if (version >= 2) {
+        stream >> info.max_part_size;
+        stream >> info.max_part_duration;
+    }
+    if (version >= 3) {
+        stream >> info.renditions;
+    }
+    if (version >= 4) {
+        stream >> info.loudness_target;
+        stream >> info.normalizes_each_input;
+    }
     return stream;
 }
 }  // namespace operators
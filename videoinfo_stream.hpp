@@ -114,6 +114,8 @@ QDataStream& operator>>(QDataStream& stream, SelectableVariant<T>& value) {
     return stream;
 }
 
+QDataStream& operator<<(QDataStream& stream, const Rendition& rendition);
+QDataStream& operator>>(QDataStream& stream, Rendition& rendition);
 QDataStream& operator<<(QDataStream& stream, const VideoInfo& info);
 QDataStream& operator>>(QDataStream& stream, VideoInfo& info);
 }  // namespace operators
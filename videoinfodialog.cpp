@@ -1,5 +1,8 @@
 #include "videoinfodialog.hpp"
 
+#include <QMessageBox>
+#include <ciso646>
+
 #include "ui_videoinfodialog.h"
 
 VideoInfoDialog::VideoInfoDialog(QWidget *parent) : QDialog(parent), ui_(new Ui::VideoInfoDialog) {
@@ -8,6 +11,15 @@ VideoInfoDialog::VideoInfoDialog(QWidget *parent) : QDialog(parent), ui_(new Ui:
 
 VideoInfoDialog::~VideoInfoDialog() { delete ui_; }
 
+void VideoInfoDialog::accept() {
+    auto errors = ui_->videoInfoWidget->rendition_errors();
+    if (not errors.isEmpty()) {
+        QMessageBox::warning(this, tr("invalid renditions"), errors.join("\n"));
+        return;
+    }
+    QDialog::accept();
+}
+
 concat::VideoInfo VideoInfoDialog::get_video_info(QWidget *parent, const QString &title, const QString &label,
                                                   const concat::VideoInfo &initial_info,
                                                   const concat::VideoInfo &input_info, bool *ok, Qt::WindowFlags flags,
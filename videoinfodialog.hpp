@@ -21,6 +21,9 @@ class VideoInfoDialog : public QDialog {
                                             bool *ok = nullptr, Qt::WindowFlags flags = Qt::WindowFlags(),
                                             Qt::InputMethodHints input_method_hints = Qt::ImhNone);
 
+   public slots:
+    void accept() override;  // refused while renditions are invalid
+
    private:
     Ui::VideoInfoDialog *ui_;
 };
@@ -1,6 +1,17 @@
 #include "videoinfowidget.hpp"
 
+#include <QDebug>
+#include <QSet>
+#include <QSignalBlocker>
+#include <ciso646>
+
+#include "rendition.hpp"
 #include "ui_videoinfowidget.h"
+
+namespace {
+constexpr qint64 MEBIBYTE = 1024 * 1024;
+constexpr auto DEFAULT_RENDITION = "proxy 1280x720 libx264 aac -crf 28 -preset veryfast";
+}  // namespace
 VideoInfoWidget::VideoInfoWidget(QWidget *parent)
     : QWidget(parent),
       ui_(new Ui::VideoInfoWidget),
@@ -13,6 +24,10 @@ VideoInfoWidget::VideoInfoWidget(QWidget *parent)
     connect(ui_->pushButton_add_input_args, &QPushButton::clicked, this, &VideoInfoWidget::add_argument_slot_input_);
     connect(ui_->pushButton_remove_input_args, &QPushButton::clicked, this,
             &VideoInfoWidget::remove_current_argument_slot_input_);
+    connect(ui_->pushButton_add_rendition, &QPushButton::clicked, this, &VideoInfoWidget::add_rendition_slot_);
+    connect(ui_->pushButton_remove_rendition, &QPushButton::clicked, this,
+            &VideoInfoWidget::remove_current_rendition_slot_);
+    connect(ui_->listWidget_renditions, &QListWidget::itemChanged, this, &VideoInfoWidget::mark_invalid_renditions_);
     connect(ui_->comboBox_resolution, &QComboBox::currentTextChanged, this, &VideoInfoWidget::update_input_resolution_);
     connect(ui_->comboBox_framerate, &QComboBox::currentTextChanged, this, &VideoInfoWidget::update_input_framerate_);
     connect(ui_->comboBox_audio_codec, &QComboBox::currentTextChanged, this,
@@ -27,8 +42,8 @@ VideoInfoWidget::VideoInfoWidget(QWidget *parent)
 
 VideoInfoWidget::~VideoInfoWidget() { delete ui_; }
 
-void VideoInfoWidget::add_argument_slot_impl_(QListWidget *widget, QPushButton *button) {
-    auto item = new QListWidgetItem("arg", widget);
+void VideoInfoWidget::add_argument_slot_impl_(QListWidget *widget, QPushButton *button, const QString &text) {
+    auto item = new QListWidgetItem(text, widget);
     item->setFlags(Qt::ItemIsSelectable | Qt::ItemIsEditable | Qt::ItemIsEnabled);
     button->setEnabled(true);
 }
@@ -56,6 +71,50 @@ void VideoInfoWidget::remove_current_argument_slot_input_() {
 void VideoInfoWidget::remove_current_argument_slot_output_() {
     remove_current_argument_slot_impl_(ui_->listWidget_args, ui_->pushButton_remove);
 }
+void VideoInfoWidget::add_rendition_slot_() {
+    add_argument_slot_impl_(ui_->listWidget_renditions, ui_->pushButton_remove_rendition, DEFAULT_RENDITION);
+}
+void VideoInfoWidget::remove_current_rendition_slot_() {
+    remove_current_argument_slot_impl_(ui_->listWidget_renditions, ui_->pushButton_remove_rendition);
+    mark_invalid_renditions_();  // a duplicate may have been removed
+}
+void VideoInfoWidget::mark_invalid_renditions_() {
+    QSignalBlocker blocker(ui_->listWidget_renditions);  // changing colors emits itemChanged again
+    QSet<QString> names;
+    QSet<QString> duplicated_names;
+    for (auto i = 0; i < ui_->listWidget_renditions->count(); i++) {
+        auto rendition = concat::parse_rendition(ui_->listWidget_renditions->item(i)->text());
+        if (rendition.has_value() && not names.contains(rendition->name.toLower())) {
+            names << rendition->name.toLower();
+        } else if (rendition.has_value()) {
+            duplicated_names << rendition->name.toLower();
+        }
+    }
+    for (auto i = 0; i < ui_->listWidget_renditions->count(); i++) {
+        auto item = ui_->listWidget_renditions->item(i);
+        auto rendition = concat::parse_rendition(item->text());
+        auto is_valid = rendition.has_value() && not duplicated_names.contains(rendition->name.toLower());
+        item->setForeground(is_valid ? palette().text() : QBrush(Qt::red));
+        item->setToolTip(is_valid ? QString() : tr("invalid rendition, or its name is used more than once"));
+    }
+}
+QStringList VideoInfoWidget::rendition_errors() const {
+    QStringList errors;
+    // names are compared case-insensitively, as files differing only in case collide on some filesystems
+    QSet<QString> names;
+    for (auto i = 0; i < ui_->listWidget_renditions->count(); i++) {
+        auto text = ui_->listWidget_renditions->item(i)->text();
+        auto rendition = concat::parse_rendition(text);
+        if (not rendition.has_value()) {
+            errors << tr("line %1 is not a rendition: %2").arg(i + 1).arg(text);
+        } else if (names.contains(rendition->name.toLower())) {
+            errors << tr("line %1 uses the name of another rendition: %2").arg(i + 1).arg(rendition->name);
+        } else {
+            names << rendition->name.toLower();
+        }
+    }
+    return errors;
+}
 void VideoInfoWidget::toggle_input_is_enabled_(QString text, QVector<QWidget *> widgets) {
     bool new_enabled;
     if (text == tr("custom")) {
@@ -183,6 +242,18 @@ void VideoInfoWidget::set_infos(const concat::VideoInfo &initial_values, const c
         add_argument_slot_input_();
         ui_->listWidget_input_args->item(ui_->listWidget_input_args->count() - 1)->setText(arg);
     }
+    ui_->spinBox_max_part_size->setValue(static_cast<int>(initial_values.max_part_size / MEBIBYTE));
+    ui_->spinBox_max_part_duration->setValue(static_cast<int>(initial_values.max_part_duration));
+    for (const auto &rendition : initial_values.renditions) {
+        add_argument_slot_impl_(ui_->listWidget_renditions, ui_->pushButton_remove_rendition,
+                                concat::format_rendition(rendition));
+    }
+    mark_invalid_renditions_();
+    // the minimum of the spin box is shown as "off"
+    ui_->doubleSpinBox_loudness_target->setValue(initial_values.loudness_target == 0
+                                                     ? ui_->doubleSpinBox_loudness_target->minimum()
+                                                     : initial_values.loudness_target);
+    ui_->checkBox_loudness_per_input->setChecked(initial_values.normalizes_each_input);
 }
 concat::VideoInfo VideoInfoWidget::info() const {
     concat::VideoInfo result{};
@@ -221,6 +292,21 @@ concat::VideoInfo VideoInfoWidget::info() const {
     for (auto i = 0; i < ui_->listWidget_input_args->count(); i++) {
         result.input_file_args += ui_->listWidget_input_args->item(i)->text();
     }
+    result.max_part_size = static_cast<qint64>(ui_->spinBox_max_part_size->value()) * MEBIBYTE;
+    result.max_part_duration = ui_->spinBox_max_part_duration->value();
+    for (auto i = 0; i < ui_->listWidget_renditions->count(); i++) {
+        auto text = ui_->listWidget_renditions->item(i)->text();
+        auto rendition = concat::parse_rendition(text);
+        if (rendition.has_value()) {
+            result.renditions << rendition.value();
+        } else {
+            qWarning() << "ignored invalid rendition:" << text;
+        }
+    }
+    auto loudness_target = ui_->doubleSpinBox_loudness_target->value();
+    result.loudness_target =
+        loudness_target == ui_->doubleSpinBox_loudness_target->minimum() ? 0.0 : loudness_target;
+    result.normalizes_each_input = ui_->checkBox_loudness_per_input->isChecked();
     return result;
 }
 void VideoInfoWidget::update_everything_() {
@@ -20,17 +20,24 @@ class VideoInfoWidget : public QWidget {
     ~VideoInfoWidget();
     void set_infos(const concat::VideoInfo &initial_values, const concat::VideoInfo &input_info);
     concat::VideoInfo info() const;
+    /**
+     * @brief problems of rendition lines, which are dropped by info(). empty if every line is a valid rendition
+     */
+    QStringList rendition_errors() const;
 
    private:
     Ui::VideoInfoWidget *ui_;
     concat::VideoInfo input_info_;
     concat::VideoInfo cache_;
-    void add_argument_slot_impl_(QListWidget *widget, QPushButton *button);
+    void add_argument_slot_impl_(QListWidget *widget, QPushButton *button, const QString &text = "arg");
     void add_argument_slot_input_();
     void add_argument_slot_output_();
     void remove_current_argument_slot_impl_(QListWidget *widget, QPushButton *button);
     void remove_current_argument_slot_input_();
     void remove_current_argument_slot_output_();
+    void add_rendition_slot_();
+    void remove_current_rendition_slot_();
+    void mark_invalid_renditions_();
     void toggle_input_is_enabled_(QString text, QVector<QWidget *> widgets);
     void update_input_resolution_(QString text);
     void update_input_framerate_(QString text);